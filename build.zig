@@ -19,6 +19,7 @@ var optJIT: ?bool = undefined;
 var runtime: config.Runtime = undefined;
 
 var stdx: *std.build.Module = undefined;
+var unicodeTables: *std.build.Module = undefined;
 var tcc: *std.build.Module = undefined;
 var mimalloc: *std.build.Module = undefined;
 
@@ -43,6 +44,18 @@ pub fn build(b: *std.build.Builder) !void {
     tcc = tcc_lib.createModule(b);
     mimalloc = mimalloc_lib.createModule(b);
 
+    // Case mapping tables are generated from the vendored UnicodeData snapshot.
+    const genUnicode = b.addExecutable(.{
+        .name = "gen_unicode",
+        .root_source_file = .{ .path = "src/tools/gen_unicode.zig" },
+        .optimize = .ReleaseSafe,
+    });
+    const genUnicodeRun = b.addRunArtifact(genUnicode);
+    genUnicodeRun.addFileArg(.{ .path = thisDir() ++ "/src/unicode/UnicodeData.txt" });
+    unicodeTables = b.createModule(.{
+        .source_file = genUnicodeRun.addOutputFileArg("unicode_tables.zig"),
+    });
+
     {
         const step = b.step("cli", "Build main cli.");
 
@@ -253,6 +266,7 @@ pub fn buildAndLinkDeps(step: *std.build.Step.Compile, opts: Options) !void {
 
     try addBuildOptions(b, step, opts);
     step.addModule("stdx", stdx);
+    step.addModule("unicode_tables", unicodeTables);
 
     step.linkLibC();
 
@@ -11,6 +11,7 @@ const cc = @import("capi.zig");
 const vmc = cy.vmc;
 const rt = cy.rt;
 const bt = cy.types.BuiltinTypes;
+const os = @import("std/os.zig");
 
 pub fn release(vm: *cy.VM, val: cy.Value) linksection(cy.HotSection) void {
     if (cy.Trace) {
@@ -250,6 +251,9 @@ fn performMark(vm: *cy.VM) !void {
             markValue(vm, sym.value);
         }
     }
+
+    // Mark the os module's process snapshots.
+    os.markProcCache(vm);
 }
 
 fn performSweep(vm: *cy.VM) !GCResult {
@@ -375,7 +379,7 @@ fn markMainStackRoots(vm: *cy.VM) !void {
 }
 
 /// Assumes `v` is a cyclable pointer.
-fn markValue(vm: *cy.VM, v: cy.Value) void {
+pub fn markValue(vm: *cy.VM, v: cy.Value) void {
     const obj = v.asHeapObject();
     if (!obj.isGcMarked()) {
         obj.setGcMarked();
@@ -265,6 +265,8 @@ pub const Node = struct {
             typed: bool,
             // Declared with `.` prefix.
             root: bool,
+            // Declared at the root of a REPL input. Assigned by the main block instead of the chunk's initializer.
+            replRoot: bool,
         },
         localDecl: struct {
             varSpec: NodeId,
@@ -69,6 +69,7 @@ fn genStmt(c: *Chunk, idx: u32) anyerror!void {
         .mainBlock          => try mainBlock(c, idx, nodeId),
         .block              => try genBlock(c, idx, nodeId),
         .opSet              => try opSet(c, idx, nodeId),
+        .mapUpdate          => try mapUpdate(c, idx, nodeId),
         .pushDebugLabel     => try pushDebugLabel(c, idx),
         .retExprStmt        => try retExprStmt(c, idx, nodeId),
         .retStmt            => try retStmt(c),
@@ -307,8 +308,15 @@ fn genCoresume(c: *Chunk, idx: usize, cstr: Cstr, nodeId: cy.NodeId) !GenValue {
     const childIdx = c.ir.advanceExpr(idx, .coresume);
     const childv = try genExpr(c, childIdx, Cstr.simpleRetain);
 
-    try c.buf.pushOp2(.coresume, childv.local, inst.dst);
+    // A stackless generator's frame is copied after the temps like a call frame.
+    const frameStart = try c.rega.consumeNextTemp();
 
+    // Failable since the generator's frame returns to `coreturnGen`.
+    try c.pushFailableDebugSym(nodeId);
+    try c.buf.pushOp3(.coresume, childv.local, inst.dst, frameStart);
+    try c.buf.pushOp3(.coreturnGen, childv.local, inst.dst, frameStart);
+
+    try popTemp(c, frameStart);
     try popTempAndUnwind(c, childv);
 
     return finishDstInst(c, inst, true);
@@ -352,6 +360,23 @@ fn genCoinitCall(c: *Chunk, idx: usize, cstr: Cstr, nodeId: cy.NodeId) !GenValue
         try pushUnwindValue(c, val);
     }
 
+    if (callCode == .preCallFuncSym and c.sema.isStacklessGen(data.callFuncSym.func)) {
+        if (data.callFuncSym.hasDynamicArg) {
+            try genCallTypeCheck(c, tempStart, numArgs, data.callFuncSym.func.funcSigId, nodeId);
+        }
+
+        // Args are moved into the generator's frame.
+        const rtId = c.compiler.genSymMap.get(data.callFuncSym.func).?.funcSym.id;
+        try c.pushOptionalDebugSym(nodeId);
+        const start = c.buf.ops.items.len;
+        try c.buf.pushOpSlice(.coinitGen, &[_]u8{ tempStart, @intCast(numArgs), 0, 0, inst.dst });
+        c.buf.setOpArgU16(start + 3, @intCast(rtId));
+
+        const argvs = popValues(c, numArgs);
+        try popTempAndUnwinds(c, argvs);
+        return finishDstInst(c, inst, true);
+    }
+
     const node = c.nodes[nodeId];
     const callExprId = node.head.child_head;
 
@@ -857,7 +882,8 @@ fn genStringTemplate(c: *Chunk, idx: usize, cstr: Cstr, nodeId: cy.NodeId) !GenV
     if (cy.Trace and c.rega.nextTemp != argStart + data.numExprs) return error.Unexpected;
 
     try c.pushOptionalDebugSym(nodeId);
-    try c.buf.pushOp3(.stringTemplate, argStart, data.numExprs, inst.dst);
+    const code: cy.OpCode = if (data.allStrs) .stringTemplateStrs else .stringTemplate;
+    try c.buf.pushOp3(code, argStart, data.numExprs, inst.dst);
 
     // Append const str indexes.
     const start = try c.buf.reserveData(strs.len);
@@ -1294,11 +1320,13 @@ fn genBinOp(c: *Chunk, idx: usize, cstr: Cstr, opts: BinOpOptions, nodeId: cy.No
         },
         .equal_equal => {
             try c.pushOptionalDebugSym(nodeId);
-            try c.buf.pushOp3Ext(.compare, leftv.local, rightv.local, inst.dst, c.desc(nodeId));
+            const code: cy.OpCode = if (data.bitEq) .compareBits else .compare;
+            try c.buf.pushOp3Ext(code, leftv.local, rightv.local, inst.dst, c.desc(nodeId));
         },
         .bang_equal => {
             try c.pushOptionalDebugSym(nodeId);
-            try c.buf.pushOp3Ext(.compareNot, leftv.local, rightv.local, inst.dst, c.desc(nodeId));
+            const code: cy.OpCode = if (data.bitEq) .compareNotBits else .compareNot;
+            try c.buf.pushOp3Ext(code, leftv.local, rightv.local, inst.dst, c.desc(nodeId));
         },
         else => {
             return c.reportErrorAt("Unsupported op: {}", &.{v(data.op)}, nodeId);
@@ -1333,7 +1361,11 @@ fn genCaptured(c: *Chunk, idx: usize, cstr: Cstr, nodeId: cy.NodeId) !GenValue {
     if (inst.requiresPreRelease) {
         try pushRelease(c, inst.dst, nodeId);
     }
-    try c.buf.pushOp3(.captured, c.curBlock.closureLocal, data.idx, inst.dst);
+    if (c.curBlock.capturedByValue.isSet(data.idx)) {
+        try c.buf.pushOp3(.capturedValue, c.curBlock.closureLocal, data.idx, inst.dst);
+    } else {
+        try c.buf.pushOp3(.captured, c.curBlock.closureLocal, data.idx, inst.dst);
+    }
 
     return finishNoErrInst(c, inst, true);
 }
@@ -1682,6 +1714,40 @@ fn opSet(c: *Chunk, idx: usize, nodeId: cy.NodeId) !void {
     try genStmt(c, @intCast(setIdx));
 }
 
+fn mapUpdate(c: *Chunk, idx: usize, nodeId: cy.NodeId) !void {
+    const data = c.ir.getStmtData(idx, .mapUpdate);
+
+    // Operands are locals or literals so they don't need to be released.
+    const valsStart = c.genValueStack.items.len;
+    const recv = try genAndPushExpr(c, data.recv, Cstr.simple);
+    const indexv = try genAndPushExpr(c, data.index, Cstr.simple);
+    const rightv = try genAndPushExpr(c, data.right, Cstr.simple);
+    var flags: u8 = switch (data.op) {
+        .plus => vmc.MAP_UPDATE_ADD,
+        .minus => vmc.MAP_UPDATE_SUB,
+        .star => vmc.MAP_UPDATE_MUL,
+        else => return error.Unexpected,
+    };
+    var defaultLocal: u8 = 0;
+    if (data.default != cy.NullId) {
+        const defaultv = try genAndPushExpr(c, data.default, Cstr.simple);
+        defaultLocal = defaultv.local;
+        flags |= vmc.MAP_UPDATE_DEFAULT;
+    }
+
+    const updatePc = c.buf.ops.items.len;
+    try c.pushFailableDebugSym(nodeId);
+    try c.buf.pushOpSliceExt(.mapUpdate, &.{ recv.local, indexv.local, rightv.local, defaultLocal, flags, 0, 0 }, c.desc(nodeId));
+
+    const argvs = c.genValueStack.items[valsStart..];
+    c.genValueStack.items.len = valsStart;
+    try popTempAndUnwinds(c, argvs);
+
+    // Unfused path when the update can't be done in place.
+    try genStmt(c, data.slow);
+    c.buf.setOpArgU16(updatePc + 6, @intCast(c.buf.ops.items.len - updatePc));
+}
+
 // fn opSetField(c: *Chunk, data: ir.OpSet, nodeId: cy.NodeId) !void {
 //     try pushIrData(c, .{ .opSet = data });
 //     try pushBasic(c, nodeId);
@@ -2439,8 +2505,12 @@ fn destrElemsStmt(c: *Chunk, idx: usize, nodeId: cy.NodeId) !void {
 
     const rightv = try genExpr(c, data.right, Cstr.simple);
 
+    // The hidden source local owns the tuple, so its elements can be moved out
+    // instead of retained and the tuple shell is freed right away.
+    const move = data.moveRight and !c.isTempLocal(rightv.local);
+
     try c.pushFailableDebugSym(nodeId);
-    try c.buf.pushOp2(.seqDestructure, rightv.local, @intCast(locals.len));
+    try c.buf.pushOp2(if (move) .seqDestructureMove else .seqDestructure, rightv.local, @intCast(locals.len));
     const start = c.buf.ops.items.len;
     try c.buf.ops.resize(c.alloc, c.buf.ops.items.len + locals.len);
     for (locals, 0..) |local, i| {
@@ -2450,6 +2520,11 @@ fn destrElemsStmt(c: *Chunk, idx: usize, nodeId: cy.NodeId) !void {
         c.buf.ops.items[start+i] = .{ .val = reg };
     }
 
+    if (move) {
+        // The source local is now `none` and no longer needs to be released.
+        getLocalInfoPtr(c, rightv.local).some.rcCandidate = false;
+    }
+
     _ = try popUnwindValue(c, rightv);
 }
 
@@ -2779,7 +2854,8 @@ fn genSwitch(c: *Chunk, idx: usize, cstr: ?Cstr, nodeId: cy.NodeId) !GenValue {
                 const condv = try genExpr(c, condIdx, Cstr.simple);
 
                 try c.pushOptionalDebugSym(condNodeId);
-                try c.buf.pushOp3Ext(.compare, exprv.local, condv.local, temp, c.desc(condNodeId));
+                const code: cy.OpCode = if (data.bitEq) .compareBits else .compare;
+                try c.buf.pushOp3Ext(code, exprv.local, condv.local, temp, c.desc(condNodeId));
                 try popTempValue(c, condv);
 
                 const condMissJump = try c.pushEmptyJumpNotCond(temp);
@@ -2998,9 +3074,21 @@ fn genLambda(c: *Chunk, idx: usize, cstr: Cstr, nodeId: cy.NodeId) !GenValue {
     // Prepare jump to skip the body.
     const skipJump = try c.pushEmptyJump();
 
+    // Parent locals that weren't lifted are copied into the closure.
+    var capturedByValue = std.StaticBitSet(256).initEmpty();
+    if (data.numCaptures > 0) {
+        const captures = c.ir.getArray(data.captures, u8, data.numCaptures);
+        for (captures, 0..) |irVar, i| {
+            if (!getLocalInfo(c, toLocalReg(c, irVar)).some.lifted) {
+                capturedByValue.set(i);
+            }
+        }
+    }
+
     log.tracev("push lambda block: {}, {}", .{func.numParams, data.maxLocals});
     const funcPc = c.buf.ops.items.len;
     try pushFuncBlockCommon(c, data.maxLocals, data.numParamCopies, params, func, nodeId);
+    c.curBlock.capturedByValue = capturedByValue;
 
     try genStmts(c, data.bodyHead);
 
@@ -3166,6 +3254,9 @@ pub const Proc = struct {
     /// contains the closure's value which is then used to perform captured var lookup.
     closureLocal: u8,
 
+    /// Captured vars that are copied into the closure instead of boxed.
+    capturedByValue: std.StaticBitSet(256) = std.StaticBitSet(256).initEmpty(),
+
     /// Register allocator state.
     regaTempStart: u8,
     regaNextTemp: u8,
@@ -3260,6 +3351,10 @@ fn exprStmt(c: *Chunk, idx: usize, nodeId: cy.NodeId) !void {
             const b = c.blocks.getLast();
             _ = try genExpr(c, expr, b.blockExprCstr);
         }
+    } else if (c.curBlock.type == .func and c.ir.getExprCode(expr) == .coyield) {
+        // A statement yield in a function can suspend a stackless generator.
+        try c.pushFailableDebugSym(nodeId);
+        try c.buf.pushOp2(.coyieldGen, c.curBlock.startLocalReg, c.curBlock.nextLocalReg);
     } else {
         const exprv = try genExpr(c, expr, Cstr.simple);
 
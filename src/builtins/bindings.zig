@@ -97,6 +97,17 @@ pub const Symbol = enum {
     file,
     dir,
 
+    // Memory access patterns.
+    normal,
+    sequential,
+    random,
+    willNeed,
+
+    // Hash algorithms.
+    xxhash64,
+    wyhash,
+    sha256,
+
     unknown,
 };
 
@@ -314,6 +325,25 @@ pub fn mapRemove(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSect
     return Value.None;
 }
 
+pub fn mapGet(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
+    const obj = args[0].asHeapObject();
+    const val = obj.map.map().get(args[1]) orelse args[2];
+    vm.retain(val);
+    return val;
+}
+
+pub fn mapGetOrPut(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    const obj = args[0].asHeapObject();
+    if (obj.map.map().get(args[1])) |val| {
+        vm.retain(val);
+        return val;
+    }
+    // `initFn` can modify the map so the entry is only inserted after it returns.
+    const val = try vm.callFunc(args[2], &.{});
+    try obj.map.set(vm, args[1], val);
+    return val;
+}
+
 pub fn listLen(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.Section) Value {
     const list = args[0].asHeapObject();
     const inner = cy.ptrAlignCast(*cy.List(Value), &list.list.list);
@@ -0,0 +1,466 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const stdx = @import("stdx");
+const t = stdx.testing;
+const cy = @import("../cyber.zig");
+const cc = @import("../capi.zig");
+const Value = cy.Value;
+const fatal = cy.fatal;
+
+pub var BufferT: cy.TypeId = undefined;
+
+/// A growable byte buffer for encoding binary data.
+/// The bytes live in a backing `Array` that is sized to the buffer's capacity, so `freeze`
+/// can return a slice of it without copying. After a freeze the backing array is shared,
+/// and the next write copies it first.
+pub const Buffer = extern struct {
+    /// Backing `Array` or `none` before the first write.
+    arr: Value,
+    len: u32,
+    shared: bool,
+
+    fn getCap(self: *const Buffer) usize {
+        if (self.arr.isNone()) {
+            return 0;
+        }
+        return self.arr.asHeapObject().array.len();
+    }
+
+    fn getBuf(self: *const Buffer) []u8 {
+        if (self.arr.isNone()) {
+            return &.{};
+        }
+        return self.arr.asHeapObject().array.getMutSlice();
+    }
+
+    pub fn items(self: *const Buffer) []u8 {
+        return self.getBuf()[0..self.len];
+    }
+
+    /// Ensures the backing array is owned and can hold `newLen` bytes. `len` is not changed.
+    fn ensureWritable(self: *Buffer, vm: *cy.VM, newLen: usize) !void {
+        const cap = self.getCap();
+        if (newLen <= cap and !self.shared) {
+            return;
+        }
+        var newCap = cap;
+        if (newCap < newLen) {
+            newCap = @max(newLen, cap * 2, 32);
+        }
+        if (newCap > std.math.maxInt(u31)) {
+            return error.OutOfBounds;
+        }
+        const new = try vm.allocUnsetArrayObject(newCap);
+        const newBuf = new.array.getMutSlice();
+        @memcpy(newBuf[0..self.len], self.items());
+        vm.release(self.arr);
+        self.arr = Value.initNoCycPtr(new);
+        self.shared = false;
+    }
+
+    fn appendSlice(self: *Buffer, vm: *cy.VM, bytes: []const u8) !void {
+        const newLen = self.len + bytes.len;
+        try self.ensureWritable(vm, newLen);
+        @memcpy(self.getBuf()[self.len..newLen], bytes);
+        self.len = @intCast(newLen);
+    }
+};
+
+pub fn bufferGetChildren(_: ?*cc.VM, obj: ?*anyopaque) callconv(.C) cc.ValueSlice {
+    const buf: *Buffer = @ptrCast(@alignCast(obj));
+    return .{
+        .ptr = @ptrCast(&buf.arr),
+        .len = 1,
+    };
+}
+
+/// The backing array is released as a child. Only the object's memory is left to free.
+pub fn bufferFinalizer(_: ?*cc.VM, _: ?*anyopaque) callconv(.C) void {}
+
+pub fn allocBuffer(vm: *cy.VM, cap: usize) !Value {
+    const buf: *Buffer = @ptrCast(@alignCast(try cy.heap.allocHostNoCycObject(vm, BufferT, @sizeOf(Buffer))));
+    buf.* = .{
+        .arr = Value.None,
+        .len = 0,
+        .shared = false,
+    };
+    const val = Value.initHostNoCycPtr(buf);
+    if (cap > 0) {
+        buf.ensureWritable(vm, cap) catch |err| {
+            vm.release(val);
+            return err;
+        };
+    }
+    return val;
+}
+
+pub fn bufferNew(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const cap = args[0].asInteger();
+    if (cap < 0) {
+        return error.InvalidArgument;
+    }
+    return allocBuffer(vm, @intCast(cap));
+}
+
+pub fn bufferAppend(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    const val = args[1];
+    if (val.isString()) {
+        try buf.appendSlice(vm, val.asString());
+    } else if (val.isArray()) {
+        try buf.appendSlice(vm, val.asArray());
+    } else {
+        return error.InvalidArgument;
+    }
+    return Value.None;
+}
+
+pub fn bufferAppendByte(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    const byte = std.math.cast(u8, args[1].asInteger()) orelse {
+        return error.InvalidArgument;
+    };
+    try buf.appendSlice(vm, &.{byte});
+    return Value.None;
+}
+
+pub fn bufferClear(_: *cy.VM, args: [*]const Value, _: u8) Value {
+    const buf = args[0].castHostObject(*Buffer);
+    buf.len = 0;
+    return Value.None;
+}
+
+pub fn bufferFreeze(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    if (buf.len == 0) {
+        return vm.allocArray("");
+    }
+    const parent = buf.arr.asHeapObject();
+    vm.retainObject(parent);
+    buf.shared = true;
+    return vm.allocArraySlice(buf.items(), parent);
+}
+
+pub fn bufferGetByte(_: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    const idx = args[1].asInteger();
+    if (idx < 0 or idx >= buf.len) {
+        return error.OutOfBounds;
+    }
+    return Value.initInt(buf.items()[@intCast(idx)]);
+}
+
+pub fn bufferLen(_: *cy.VM, args: [*]const Value, _: u8) Value {
+    const buf = args[0].castHostObject(*Buffer);
+    return Value.initInt(@intCast(buf.len));
+}
+
+pub fn bufferPack(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    try pack(vm, buf, buf.len, args[1].asString(), args[2]);
+    return Value.None;
+}
+
+pub fn bufferPackAt(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    const offset = args[1].asInteger();
+    if (offset < 0 or offset > buf.len) {
+        return error.OutOfBounds;
+    }
+    try pack(vm, buf, @intCast(offset), args[2].asString(), args[3]);
+    return Value.None;
+}
+
+pub fn bufferSetByte(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    const idx = args[1].asInteger();
+    if (idx < 0 or idx >= buf.len) {
+        return error.OutOfBounds;
+    }
+    const byte = std.math.cast(u8, args[2].asInteger()) orelse {
+        return error.InvalidArgument;
+    };
+    try buf.ensureWritable(vm, buf.len);
+    buf.items()[@intCast(idx)] = byte;
+    return Value.None;
+}
+
+pub fn bufferUnpack(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const buf = args[0].castHostObject(*Buffer);
+    return unpack(vm, buf.items(), args[1].asString(), args[2].asInteger());
+}
+
+pub fn arrayUnpack(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return unpack(vm, args[0].asArray(), args[1].asString(), args[2].asInteger());
+}
+
+const Field = struct {
+    code: u8,
+    count: u32,
+
+    fn size(self: Field) usize {
+        return fieldSize(self.code) * self.count;
+    }
+
+    /// Number of values consumed or produced.
+    fn numValues(self: Field) usize {
+        return if (self.code == 'x') 0 else self.count;
+    }
+};
+
+fn fieldSize(code: u8) usize {
+    return switch (code) {
+        'b', 'B', 'x' => 1,
+        'h', 'H' => 2,
+        'i', 'I', 'f' => 4,
+        'q', 'Q', 'd' => 8,
+        else => unreachable,
+    };
+}
+
+/// Iterates the fields of a format string. The format starts with an optional byte order:
+/// `<` little, `>` or `!` big, `=` native. Native is the default.
+/// Each field code can be preceded by a repeat count.
+const FieldIterator = struct {
+    fmt: []const u8,
+    idx: usize,
+    endian: std.builtin.Endian,
+
+    fn init(fmt: []const u8) FieldIterator {
+        var iter = FieldIterator{
+            .fmt = fmt,
+            .idx = 0,
+            .endian = builtin.cpu.arch.endian(),
+        };
+        if (fmt.len > 0) {
+            switch (fmt[0]) {
+                '<' => iter.endian = .Little,
+                '>', '!' => iter.endian = .Big,
+                '=' => {},
+                else => return iter,
+            }
+            iter.idx = 1;
+        }
+        return iter;
+    }
+
+    fn next(self: *FieldIterator) !?Field {
+        while (self.idx < self.fmt.len and self.fmt[self.idx] == ' ') {
+            self.idx += 1;
+        }
+        if (self.idx == self.fmt.len) {
+            return null;
+        }
+        var count: u32 = 1;
+        if (std.ascii.isDigit(self.fmt[self.idx])) {
+            const start = self.idx;
+            while (self.idx < self.fmt.len and std.ascii.isDigit(self.fmt[self.idx])) {
+                self.idx += 1;
+            }
+            count = std.fmt.parseInt(u32, self.fmt[start..self.idx], 10) catch {
+                return error.InvalidArgument;
+            };
+            if (self.idx == self.fmt.len) {
+                return error.InvalidArgument;
+            }
+        }
+        const code = self.fmt[self.idx];
+        switch (code) {
+            'b', 'B', 'h', 'H', 'i', 'I', 'q', 'Q', 'f', 'd', 'x' => {},
+            else => return error.InvalidArgument,
+        }
+        self.idx += 1;
+        return Field{ .code = code, .count = count };
+    }
+};
+
+const FormatInfo = struct {
+    size: usize,
+    numValues: usize,
+};
+
+fn getFormatInfo(fmt: []const u8) !FormatInfo {
+    var res = FormatInfo{ .size = 0, .numValues = 0 };
+    var iter = FieldIterator.init(fmt);
+    while (try iter.next()) |field| {
+        res.size += field.size();
+        res.numValues += field.numValues();
+    }
+    return res;
+}
+
+/// Writes every field of `fmt` at `offset` in one pass. The buffer grows if needed.
+/// The values are checked first so a bad value leaves the buffer unchanged.
+fn pack(vm: *cy.VM, buf: *Buffer, offset: usize, fmt: []const u8, vals: Value) !void {
+    if (!vals.isList()) {
+        return error.InvalidArgument;
+    }
+    const list = vals.asHeapObject().list.items();
+    const info = try getFormatInfo(fmt);
+    if (info.numValues != list.len) {
+        return error.InvalidArgument;
+    }
+
+    var valIdx: usize = 0;
+    var iter = FieldIterator.init(fmt);
+    while (try iter.next()) |field| {
+        if (field.code == 'x') {
+            continue;
+        }
+        for (list[valIdx..valIdx+field.count]) |val| {
+            try checkField(field.code, val);
+        }
+        valIdx += field.count;
+    }
+
+    const end = offset + info.size;
+    try buf.ensureWritable(vm, @max(end, buf.len));
+
+    var dst = buf.getBuf()[offset..end];
+    valIdx = 0;
+    iter = FieldIterator.init(fmt);
+    while (try iter.next()) |field| {
+        const size = fieldSize(field.code);
+        for (0..field.count) |_| {
+            if (field.code == 'x') {
+                dst[0] = 0;
+            } else {
+                writeField(dst[0..size], field.code, list[valIdx], iter.endian);
+                valIdx += 1;
+            }
+            dst = dst[size..];
+        }
+    }
+    buf.len = @intCast(@max(end, buf.len));
+}
+
+fn checkField(code: u8, val: Value) !void {
+    switch (code) {
+        'b' => try checkIntField(i8, val),
+        'B' => try checkIntField(u8, val),
+        'h' => try checkIntField(i16, val),
+        'H' => try checkIntField(u16, val),
+        'i' => try checkIntField(i32, val),
+        'I' => try checkIntField(u32, val),
+        'q' => try checkIntField(i64, val),
+        'Q' => try checkIntField(u64, val),
+        'f', 'd' => {
+            if (!val.isFloat() and !val.isInteger()) {
+                return error.InvalidArgument;
+            }
+        },
+        else => unreachable,
+    }
+}
+
+fn checkIntField(comptime T: type, val: Value) !void {
+    if (!val.isInteger()) {
+        return error.InvalidArgument;
+    }
+    if (std.math.cast(T, val.asInteger()) == null) {
+        return error.OutOfBounds;
+    }
+}
+
+/// Expects `val` to have passed `checkField`.
+fn writeField(dst: []u8, code: u8, val: Value, endian: std.builtin.Endian) void {
+    switch (code) {
+        'b' => writeIntField(i8, dst, val, endian),
+        'B' => writeIntField(u8, dst, val, endian),
+        'h' => writeIntField(i16, dst, val, endian),
+        'H' => writeIntField(u16, dst, val, endian),
+        'i' => writeIntField(i32, dst, val, endian),
+        'I' => writeIntField(u32, dst, val, endian),
+        'q' => writeIntField(i64, dst, val, endian),
+        'Q' => writeIntField(u64, dst, val, endian),
+        'f' => {
+            const f: f32 = @floatCast(toF64(val));
+            std.mem.writeInt(u32, dst[0..4], @bitCast(f), endian);
+        },
+        'd' => {
+            const f = toF64(val);
+            std.mem.writeInt(u64, dst[0..8], @bitCast(f), endian);
+        },
+        else => unreachable,
+    }
+}
+
+fn writeIntField(comptime T: type, dst: []u8, val: Value, endian: std.builtin.Endian) void {
+    const n: T = @intCast(val.asInteger());
+    std.mem.writeInt(T, dst[0..@sizeOf(T)], n, endian);
+}
+
+fn toF64(val: Value) f64 {
+    if (val.isInteger()) {
+        return @floatFromInt(val.asInteger());
+    } else {
+        return val.asF64();
+    }
+}
+
+/// Decodes every field of `fmt` starting at `offset` into a new list.
+/// 64-bit ints that don't fit in an `int` return `error.OutOfBounds`.
+fn unpack(vm: *cy.VM, src: []const u8, fmt: []const u8, offset: i48) !Value {
+    const info = try getFormatInfo(fmt);
+    if (offset < 0 or @as(usize, @intCast(offset)) + info.size > src.len) {
+        return error.OutOfBounds;
+    }
+    const vals = try vm.alloc.alloc(Value, info.numValues);
+    errdefer vm.alloc.free(vals);
+
+    var cur = src[@intCast(offset)..];
+    var valIdx: usize = 0;
+    var iter = FieldIterator.init(fmt);
+    while (try iter.next()) |field| {
+        const size = fieldSize(field.code);
+        for (0..field.count) |_| {
+            if (field.code != 'x') {
+                vals[valIdx] = try readField(cur[0..size], field.code, iter.endian);
+                valIdx += 1;
+            }
+            cur = cur[size..];
+        }
+    }
+    return cy.heap.allocOwnedList(vm, vals);
+}
+
+fn readField(src: []const u8, code: u8, endian: std.builtin.Endian) !Value {
+    return switch (code) {
+        'b' => readIntField(i8, src, endian),
+        'B' => readIntField(u8, src, endian),
+        'h' => readIntField(i16, src, endian),
+        'H' => readIntField(u16, src, endian),
+        'i' => readIntField(i32, src, endian),
+        'I' => readIntField(u32, src, endian),
+        'q' => readIntField(i64, src, endian),
+        'Q' => readIntField(u64, src, endian),
+        'f' => {
+            const bits = std.mem.readInt(u32, src[0..4], endian);
+            const f: f32 = @bitCast(bits);
+            return Value.initF64(f);
+        },
+        'd' => Value.initF64(@bitCast(std.mem.readInt(u64, src[0..8], endian))),
+        else => unreachable,
+    };
+}
+
+fn readIntField(comptime T: type, src: []const u8, endian: std.builtin.Endian) !Value {
+    const n = std.mem.readInt(T, src[0..@sizeOf(T)], endian);
+    const i = std.math.cast(i48, n) orelse {
+        return error.OutOfBounds;
+    };
+    return Value.initInt(i);
+}
+
+test "getFormatInfo()" {
+    var info = try getFormatInfo("<BHIq");
+    try t.eq(info.size, 15);
+    try t.eq(info.numValues, 4);
+
+    info = try getFormatInfo(">3h 2x d");
+    try t.eq(info.size, 16);
+    try t.eq(info.numValues, 4);
+
+    try t.expectError(getFormatInfo("<z"), error.InvalidArgument);
+    try t.expectError(getFormatInfo("3"), error.InvalidArgument);
+}
@@ -12,6 +12,7 @@ const rt = cy.rt;
 const bt = cy.types.BuiltinTypes;
 const vmc = cy.vmc;
 const string = @import("string.zig");
+const buffer = @import("buffer.zig");
 const inlineBinOp = bindings.inlineBinOp;
 
 const log = cy.log.scoped(.core);
@@ -57,6 +58,9 @@ const funcs = [_]NameFunc{
     // error
     .{"sym", errorSym, .standard},
     .{"error.'$call'", errorCall, .standard},
+
+    // symbol
+    .{"name", zErrFunc2(symbolName), .standard},
     
     // int
     .{"$prefix~", bindings.intBitwiseNot, .inlinec},
@@ -121,6 +125,8 @@ const funcs = [_]NameFunc{
     // Map
     .{"$index", zErrFunc2(inlineBinOp(.indexMap)), .inlinec},
     .{"$setIndex", bindings.inlineTernOp(.setIndexMap), .inlinec},
+    .{"get", bindings.mapGet, .standard},
+    .{"getOrPut", zErrFunc2(bindings.mapGetOrPut), .standard},
     .{"remove", bindings.mapRemove, .standard},
     .{"size", bindings.mapSize, .standard},
     .{"iterator", bindings.mapIterator, .standard},
@@ -135,6 +141,7 @@ const funcs = [_]NameFunc{
     .{"find", string.find, .standard},
     .{"findAnyRune", string.findAnyRune, .standard},
     .{"findRune", string.findRune, .standard},
+    .{"foldCase", string.foldCase, .standard},
     .{"insert", string.insertFn, .standard},
     .{"isAscii", string.isAscii, .standard},
     .{"len", string.lenFn, .standard},
@@ -177,6 +184,7 @@ const funcs = [_]NameFunc{
     .{"split",          zErrFunc2(arraySplit), .standard},
     .{"startsWith",     arrayStartsWith, .standard},
     .{"trim",           zErrFunc2(arrayTrim), .standard},
+    .{"unpack",         zErrFunc2(buffer.arrayUnpack), .standard},
     .{"Array.'$call'",  zErrFunc2(arrayCall), .standard},
 
     // pointer
@@ -196,12 +204,26 @@ const funcs = [_]NameFunc{
 
     // metatype
     .{"id", metatypeId, .standard},
+
+    // Buffer
+    .{"append",         zErrFunc2(buffer.bufferAppend), .standard},
+    .{"appendByte",     zErrFunc2(buffer.bufferAppendByte), .standard},
+    .{"clear",          buffer.bufferClear, .standard},
+    .{"freeze",         zErrFunc2(buffer.bufferFreeze), .standard},
+    .{"getByte",        zErrFunc2(buffer.bufferGetByte), .standard},
+    .{"len",            buffer.bufferLen, .standard},
+    .{"pack",           zErrFunc2(buffer.bufferPack), .standard},
+    .{"packAt",         zErrFunc2(buffer.bufferPackAt), .standard},
+    .{"setByte",        zErrFunc2(buffer.bufferSetByte), .standard},
+    .{"unpack",         zErrFunc2(buffer.bufferUnpack), .standard},
+    .{"Buffer.new",     zErrFunc2(buffer.bufferNew), .standard},
 };
 
 const NameType = struct { []const u8, cy.TypeId };
 const types = [_]NameType{
     .{"bool", bt.Boolean },
     .{"error", bt.Error },
+    .{"symbol", bt.Symbol },
     .{"int", bt.Integer },
     .{"float", bt.Float },
     .{"List", bt.List },
@@ -217,9 +239,28 @@ const types = [_]NameType{
     .{"metatype", bt.MetaType },
 };
 
+/// Types implemented as host objects. Declared after the core types in `builtins.cy`.
+const HostType = struct { []const u8, *cy.TypeId, cc.ObjectGetChildrenFn, cc.ObjectFinalizerFn };
+const hostTypes = [_]HostType{
+    .{"Buffer", &buffer.BufferT, buffer.bufferGetChildren, buffer.bufferFinalizer },
+};
+
 pub fn typeLoader(_: ?*cc.VM, info: cc.TypeInfo, out_: [*c]cc.TypeResult) callconv(.C) bool {
     const out: *cc.TypeResult = out_;
     const name = cc.strSlice(info.name);
+    if (info.idx >= types.len) {
+        const hostType = hostTypes[info.idx - types.len];
+        if (std.mem.eql(u8, hostType.@"0", name)) {
+            out.type = cc.TypeKindObject;
+            out.data.object = .{
+                .outTypeId = hostType.@"1",
+                .getChildren = hostType.@"2",
+                .finalizer = hostType.@"3",
+            };
+            return true;
+        }
+        return false;
+    }
     if (std.mem.eql(u8, types[info.idx].@"0", name)) {
         out.type = cc.TypeKindCoreObject;
         out.data.coreObject = .{
@@ -271,21 +312,28 @@ pub fn prepThrowZError(vm: *cy.VM, err: anyerror, optTrace: ?*std.builtin.StackT
             std.debug.dumpStackTrace(trace.*);
         }
     }
-    switch (err) {
-        error.Unicode               => return rt.prepThrowError(vm, .Unicode),
-        error.InvalidArgument       => return rt.prepThrowError(vm, .InvalidArgument),
-        error.InvalidEnumTag        => return rt.prepThrowError(vm, .InvalidArgument),
-        error.FileNotFound          => return rt.prepThrowError(vm, .FileNotFound),
-        error.OutOfBounds           => return rt.prepThrowError(vm, .OutOfBounds),
-        error.PermissionDenied      => return rt.prepThrowError(vm, .PermissionDenied),
-        error.StdoutStreamTooLong   => return rt.prepThrowError(vm, .StreamTooLong),
-        error.StderrStreamTooLong   => return rt.prepThrowError(vm, .StreamTooLong),
-        error.EndOfStream           => return rt.prepThrowError(vm, .EndOfStream),
-        else                        => {
-            rt.errFmt(vm, "UnknownError: {}", &.{fmt.v(err)});
-            return rt.prepThrowError(vm, .UnknownError);
-        }
+    const sym = zErrorSymbol(err);
+    if (sym == .UnknownError) {
+        rt.errFmt(vm, "UnknownError: {}", &.{fmt.v(err)});
     }
+    return rt.prepThrowError(vm, sym);
+}
+
+/// Returns the error symbol that `prepThrowZError` throws for `err`.
+pub fn zErrorSymbol(err: anyerror) Symbol {
+    return switch (err) {
+        error.Unicode               => .Unicode,
+        error.InvalidArgument       => .InvalidArgument,
+        error.InvalidEnumTag        => .InvalidArgument,
+        error.FileNotFound          => .FileNotFound,
+        error.OutOfBounds           => .OutOfBounds,
+        error.PermissionDenied      => .PermissionDenied,
+        error.StdoutStreamTooLong   => .StreamTooLong,
+        error.StderrStreamTooLong   => .StreamTooLong,
+        error.FileTooBig            => .StreamTooLong,
+        error.EndOfStream           => .EndOfStream,
+        else                        => .UnknownError,
+    };
 }
 
 fn traceRetains(vm: *cy.VM, _: [*]const Value, _: u8) linksection(cy.StdSection) Value {
@@ -954,10 +1002,11 @@ fn arrayInsert(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSectio
     return Value.initNoCycPtr(new);
 }
 
-fn arrayFind(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
+fn arrayFind(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     const obj = args[0].asHeapObject();
     const slice = obj.array.getSlice();
-    const needle = args[1].asArray();
+    const needleObj = args[1].asHeapObject();
+    const needle = needleObj.array.getSlice();
     if (needle.len > 0 and needle.len <= slice.len) {
         if (needle.len == 1) {
             // One byte special case. Perform indexOfChar.
@@ -965,7 +1014,9 @@ fn arrayFind(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection)
                 return Value.initInt(@intCast(idx));
             }
         }
-        if (cy.string.indexOf(slice, needle)) |idx| {
+        var finderBuf: cy.string.Finder = undefined;
+        const finder = vm.finderCache.getArray(needleObj, &finderBuf);
+        if (finder.find(slice)) |idx| {
             return Value.initInt(@intCast(idx));
         }
     }
@@ -1174,13 +1225,16 @@ fn arrayTrim(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection)
 fn arrayReplace(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     const obj = args[0].asHeapObject();
     const slice = obj.array.getSlice();
-    const needle = args[1].asArray();
+    const needleObj = args[1].asHeapObject();
+    const needle = needleObj.array.getSlice();
     const replacement = args[2].asArray();
 
     const idxBuf = &vm.u8Buf;
     idxBuf.clearRetainingCapacity();
     defer idxBuf.ensureMaxCapOrClear(vm.alloc, 4096) catch fatal();
-    const newLen = cy.prepReplacement(slice, needle, replacement, idxBuf.writer(vm.alloc)) catch fatal();
+    var finderBuf: cy.string.Finder = undefined;
+    const finder = vm.finderCache.getArray(needleObj, &finderBuf);
+    const newLen = cy.prepReplacement(slice, finder, replacement, idxBuf.writer(vm.alloc)) catch fatal();
     const numIdxes = @divExact(idxBuf.len, 4);
     if (numIdxes > 0) {
         const new = vm.allocUnsetArrayObject(newLen) catch fatal();
@@ -1250,16 +1304,18 @@ fn arrayRepeat(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSectio
 fn arraySplit(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
     const obj = args[0].asHeapObject();
     const slice = obj.array.getSlice();
-    const delim = args[1].asArray();
+    const delimObj = args[1].asHeapObject();
 
     const res = try vm.allocEmptyList();
-    if (delim.len == 0) {
+    if (delimObj.array.len() == 0) {
         return res;
     }
     const list = res.asHeapObject();
 
     const parent = obj.array.getParent();
-    var iter = std.mem.split(u8, slice, delim);
+    var finderBuf: cy.string.Finder = undefined;
+    const finder = vm.finderCache.getArray(delimObj, &finderBuf);
+    var iter = cy.string.SplitIterator.init(slice, finder);
     while (iter.next()) |part| {
         vm.retainObject(parent);
         const new = try vm.allocArraySlice(part, parent);
@@ -1276,7 +1332,7 @@ fn arrayCall(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
 fn fiberStatus(vm: *cy.VM, args: [*]const Value, _: u8) Value {
     const fiber = args[0].castHeapObject(*vmc.Fiber);
 
-    if (vm.curFiber == fiber) {
+    if (vm.curFiber == fiber or fiber.genState == vmc.GEN_RUNNING) {
         return Value.initSymbol(@intFromEnum(Symbol.running));
     } else {
         // Check if done.
@@ -1408,6 +1464,15 @@ fn errorSym(_: *cy.VM, args: [*]const Value, _: u8) Value {
     return Value.initSymbol(recv.asErrorSymbol());
 }
 
+fn symbolName(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return vm.getSymbolStr(args[0].asSymbolId(), false);
+}
+
+/// Declared by sema as `name()` on each enum type.
+pub fn enumName(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return vm.getEnumStr(args[0], false);
+}
+
 fn errorCall(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     const val = args[0];
     if (val.isPointer()) {
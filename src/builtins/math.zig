@@ -4,6 +4,8 @@ const cc = @import("../capi.zig");
 const vmc = cy.vmc;
 const Value = cy.Value;
 const bt = cy.types.BuiltinTypes;
+const builtins = @import("builtins.zig");
+const zErrFunc2 = builtins.zErrFunc2;
 
 pub const Src = @embedFile("math.cy");
 pub fn funcLoader(_: ?*cc.VM, func: cc.FuncInfo, out_: [*c]cc.FuncResult) callconv(.C) bool {
@@ -57,6 +59,8 @@ const funcs = [_]NameFunc{
     .{"clz32",  clz32},
     .{"cos",    cos},
     .{"cosh",   cosh},
+    .{"cumsum", zErrFunc2(cumsum)},
+    .{"dot",    zErrFunc2(dot)},
     .{"exp",    exp},
     .{"expm1",  expm1},
     .{"floor",  floor},
@@ -69,8 +73,12 @@ const funcs = [_]NameFunc{
     .{"log10",  log10},
     .{"log1p",  log1p},
     .{"log2",   log2},
+    .{"map",    zErrFunc2(map)},
     .{"max",    max},
+    .{"max",    zErrFunc2(maxList)},
+    .{"mean",   zErrFunc2(mean)},
     .{"min",    min},
+    .{"min",    zErrFunc2(minList)},
     .{"mul32",  mul32},
     .{"pow",    pow},
     .{"random", random},
@@ -79,6 +87,7 @@ const funcs = [_]NameFunc{
     .{"sin",    sin},
     .{"sinh",   sinh},
     .{"sqrt",   sqrt},
+    .{"sum",    zErrFunc2(sum)},
     .{"tan",    tan},
     .{"tanh",   tanh},
     .{"trunc",  trunc},
@@ -277,4 +286,361 @@ pub fn tanh(_: *cy.VM, args: [*]const Value, _: u8) Value {
 /// Returns the integer portion of x, removing any fractional digits.
 pub fn trunc(_: *cy.VM, args: [*]const Value, _: u8) Value {
     return Value.initF64(std.math.trunc(args[0].asF64()));
-}
\ No newline at end of file
+}
+// List kernels.
+// Floats are stored unboxed in a `Value`, so a list of only floats can be read as a `[]const f64`.
+// Integers are tagged 48-bit values that are sign extended per lane.
+// Lists with other elements fall back to converting each element to a float.
+
+const VecLen = 4;
+const VecF = @Vector(VecLen, f64);
+const VecI = @Vector(VecLen, i64);
+const VecU = @Vector(VecLen, u64);
+
+const TaggedValueMask: u64 = vmc.TAGGED_VALUE_MASK;
+const TaggedUpperValueMask: u64 = vmc.TAGGED_UPPER_VALUE_MASK;
+const TaggedIntegerMask: u64 = vmc.TAGGED_INTEGER_MASK;
+
+const ListKind = enum {
+    float,
+    int,
+    mixed,
+};
+
+fn listItems(val: Value) []Value {
+    const list = cy.ptrAlignCast(*cy.List(Value), &val.asHeapObject().list.list);
+    return list.items();
+}
+
+fn rawItems(vals: []const Value) []const u64 {
+    return @as([*]const u64, @ptrCast(vals.ptr))[0..vals.len];
+}
+
+fn floatItems(vals: []const Value) []const f64 {
+    return @as([*]const f64, @ptrCast(vals.ptr))[0..vals.len];
+}
+
+/// An empty list is considered a float list.
+fn listKind(vals: []const Value) ListKind {
+    const raw = rawItems(vals);
+    var allFloat = true;
+    var allInt = true;
+    var i: usize = 0;
+    while (i + VecLen <= raw.len) : (i += VecLen) {
+        const v: VecU = raw[i..][0..VecLen].*;
+        allFloat = allFloat and @reduce(.And, v & @as(VecU, @splat(TaggedValueMask)) != @as(VecU, @splat(TaggedValueMask)));
+        allInt = allInt and @reduce(.And, v & @as(VecU, @splat(TaggedUpperValueMask)) == @as(VecU, @splat(TaggedIntegerMask)));
+        if (!allFloat and !allInt) {
+            return .mixed;
+        }
+    }
+    for (vals[i..]) |val| {
+        allFloat = allFloat and val.isFloat();
+        allInt = allInt and val.isInteger();
+    }
+    if (allFloat) return .float;
+    if (allInt) return .int;
+    return .mixed;
+}
+
+inline fn intLanes(v: VecU) VecI {
+    const shift: @Vector(VecLen, u6) = @splat(16);
+    const upper: VecI = @bitCast(v << shift);
+    return upper >> shift;
+}
+
+inline fn intItem(raw: u64) i64 {
+    return @as(i64, @bitCast(raw << 16)) >> 16;
+}
+
+fn toF64(val: Value) !f64 {
+    if (val.isFloat()) {
+        return val.asF64();
+    } else if (val.isInteger()) {
+        return @floatFromInt(val.asInteger());
+    } else {
+        return error.InvalidArgument;
+    }
+}
+
+fn sumFloats(xs: []const f64) f64 {
+    var acc: VecF = @splat(0);
+    var i: usize = 0;
+    while (i + VecLen <= xs.len) : (i += VecLen) {
+        acc += @as(VecF, xs[i..][0..VecLen].*);
+    }
+    var res = @reduce(.Add, acc);
+    for (xs[i..]) |x| {
+        res += x;
+    }
+    return res;
+}
+
+/// Wraps on overflow like integer addition in the VM.
+fn sumInts(raw: []const u64) i64 {
+    var acc: VecI = @splat(0);
+    var i: usize = 0;
+    while (i + VecLen <= raw.len) : (i += VecLen) {
+        acc +%= intLanes(raw[i..][0..VecLen].*);
+    }
+    var res = @reduce(.Add, acc);
+    for (raw[i..]) |x| {
+        res +%= intItem(x);
+    }
+    return res;
+}
+
+fn sumMixed(vals: []const Value) !f64 {
+    var res: f64 = 0;
+    for (vals) |val| {
+        res += try toF64(val);
+    }
+    return res;
+}
+
+pub fn sum(_: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const vals = listItems(args[0]);
+    return switch (listKind(vals)) {
+        .float => Value.initF64(sumFloats(floatItems(vals))),
+        .int => Value.initInt(@truncate(sumInts(rawItems(vals)))),
+        .mixed => Value.initF64(try sumMixed(vals)),
+    };
+}
+
+pub fn mean(_: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const vals = listItems(args[0]);
+    if (vals.len == 0) {
+        return Value.initF64(std.math.nan_f64);
+    }
+    const total: f64 = switch (listKind(vals)) {
+        .float => sumFloats(floatItems(vals)),
+        .int => @floatFromInt(sumInts(rawItems(vals))),
+        .mixed => try sumMixed(vals),
+    };
+    return Value.initF64(total / @as(f64, @floatFromInt(vals.len)));
+}
+
+fn reduceFloats(comptime op: std.builtin.ReduceOp, xs: []const f64) f64 {
+    var acc: VecF = @splat(xs[0]);
+    var i: usize = 0;
+    while (i + VecLen <= xs.len) : (i += VecLen) {
+        const v: VecF = xs[i..][0..VecLen].*;
+        acc = if (op == .Min) @min(acc, v) else @max(acc, v);
+    }
+    var res = @reduce(op, acc);
+    for (xs[i..]) |x| {
+        res = if (op == .Min) @min(res, x) else @max(res, x);
+    }
+    return res;
+}
+
+fn reduceInts(comptime op: std.builtin.ReduceOp, raw: []const u64) i64 {
+    var acc: VecI = @splat(intItem(raw[0]));
+    var i: usize = 0;
+    while (i + VecLen <= raw.len) : (i += VecLen) {
+        const v = intLanes(raw[i..][0..VecLen].*);
+        acc = if (op == .Min) @min(acc, v) else @max(acc, v);
+    }
+    var res = @reduce(op, acc);
+    for (raw[i..]) |x| {
+        res = if (op == .Min) @min(res, intItem(x)) else @max(res, intItem(x));
+    }
+    return res;
+}
+
+/// Mixed lists return the original element so that an integer stays an integer.
+fn reduceList(comptime op: std.builtin.ReduceOp, vals: []const Value) !Value {
+    if (vals.len == 0) {
+        return error.InvalidArgument;
+    }
+    switch (listKind(vals)) {
+        .float => return Value.initF64(reduceFloats(op, floatItems(vals))),
+        .int => return Value.initInt(@intCast(reduceInts(op, rawItems(vals)))),
+        .mixed => {
+            var resIdx: usize = 0;
+            var res = try toF64(vals[0]);
+            for (vals[1..], 1..) |val, i| {
+                const x = try toF64(val);
+                const better = if (op == .Min) x < res else x > res;
+                if (better) {
+                    res = x;
+                    resIdx = i;
+                }
+            }
+            return vals[resIdx];
+        },
+    }
+}
+
+pub fn minList(_: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return reduceList(.Min, listItems(args[0]));
+}
+
+pub fn maxList(_: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return reduceList(.Max, listItems(args[0]));
+}
+
+pub fn dot(_: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const a = listItems(args[0]);
+    const b = listItems(args[1]);
+    if (a.len != b.len) {
+        return error.InvalidArgument;
+    }
+    const kind = listKind(a);
+    if (kind != .mixed and kind == listKind(b)) {
+        var i: usize = 0;
+        if (kind == .float) {
+            const xs = floatItems(a);
+            const ys = floatItems(b);
+            var acc: VecF = @splat(0);
+            while (i + VecLen <= xs.len) : (i += VecLen) {
+                acc = @mulAdd(VecF, xs[i..][0..VecLen].*, ys[i..][0..VecLen].*, acc);
+            }
+            var res = @reduce(.Add, acc);
+            for (xs[i..], ys[i..]) |x, y| {
+                res = @mulAdd(f64, x, y, res);
+            }
+            return Value.initF64(res);
+        } else {
+            const xs = rawItems(a);
+            const ys = rawItems(b);
+            var acc: VecI = @splat(0);
+            while (i + VecLen <= xs.len) : (i += VecLen) {
+                acc +%= intLanes(xs[i..][0..VecLen].*) *% intLanes(ys[i..][0..VecLen].*);
+            }
+            var res = @reduce(.Add, acc);
+            for (xs[i..], ys[i..]) |x, y| {
+                res +%= intItem(x) *% intItem(y);
+            }
+            return Value.initInt(@truncate(res));
+        }
+    }
+    var res: f64 = 0;
+    for (a, b) |x, y| {
+        res += try toF64(x) * try toF64(y);
+    }
+    return Value.initF64(res);
+}
+
+pub fn cumsum(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const vals = listItems(args[0]);
+    const out = try vm.alloc.alloc(Value, vals.len);
+    errdefer vm.alloc.free(out);
+    switch (listKind(vals)) {
+        .float => {
+            var acc: f64 = 0;
+            for (floatItems(vals), out) |x, *dst| {
+                acc += x;
+                dst.* = Value.initF64(acc);
+            }
+        },
+        .int => {
+            var acc: i48 = 0;
+            for (vals, out) |val, *dst| {
+                acc +%= val.asInteger();
+                dst.* = Value.initInt(acc);
+            }
+        },
+        .mixed => {
+            var acc: f64 = 0;
+            for (vals, out) |val, *dst| {
+                acc += try toF64(val);
+                dst.* = Value.initF64(acc);
+            }
+        },
+    }
+    return cy.heap.allocOwnedList(vm, out);
+}
+
+const UnaryOp = enum {
+    abs, acos, acosh, asin, asinh, atan, atanh, cbrt, ceil, cos, cosh, exp, expm1,
+    floor, frac, ln, log10, log1p, log2, round, sign, sin, sinh, sqrt, tan, tanh, trunc,
+};
+
+/// `x` is either a `f64` or a `VecF`. Ops without a vector builtin are applied per lane.
+inline fn applyUnary(comptime op: UnaryOp, x: anytype) @TypeOf(x) {
+    return switch (op) {
+        .abs => @fabs(x),
+        .ceil => @ceil(x),
+        .cos => @cos(x),
+        .exp => @exp(x),
+        .floor => @floor(x),
+        .ln => @log(x),
+        .log10 => @log10(x),
+        .log2 => @log2(x),
+        .round => @round(x),
+        .sin => @sin(x),
+        .sqrt => @sqrt(x),
+        .tan => @tan(x),
+        .trunc => @trunc(x),
+        else => {
+            if (@TypeOf(x) == f64) {
+                return applyScalarUnary(op, x);
+            }
+            var res: VecF = undefined;
+            inline for (0..VecLen) |i| {
+                res[i] = applyScalarUnary(op, x[i]);
+            }
+            return res;
+        },
+    };
+}
+
+fn applyScalarUnary(comptime op: UnaryOp, x: f64) f64 {
+    return switch (op) {
+        .acos => std.math.acos(x),
+        .acosh => std.math.acosh(x),
+        .asin => std.math.asin(x),
+        .asinh => std.math.asinh(x),
+        .atan => std.math.atan(x),
+        .atanh => std.math.atanh(x),
+        .cbrt => std.math.cbrt(x),
+        .cosh => std.math.cosh(x),
+        .expm1 => std.math.expm1(x),
+        .frac => std.math.modf(x).fpart,
+        .log1p => std.math.log1p(x),
+        .sign => std.math.sign(x),
+        .sinh => std.math.sinh(x),
+        .tanh => std.math.tanh(x),
+        else => unreachable,
+    };
+}
+
+fn mapFloats(op: UnaryOp, xs: []f64) void {
+    switch (op) {
+        inline else => |cop| {
+            var i: usize = 0;
+            while (i + VecLen <= xs.len) : (i += VecLen) {
+                xs[i..][0..VecLen].* = applyUnary(cop, @as(VecF, xs[i..][0..VecLen].*));
+            }
+            for (xs[i..]) |*x| {
+                x.* = applyUnary(cop, x.*);
+            }
+        },
+    }
+}
+
+pub fn map(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const vals = listItems(args[0]);
+    const op = std.meta.stringToEnum(UnaryOp, vm.getSymbolName(args[1].asSymbolId())) orelse {
+        return error.InvalidArgument;
+    };
+    const out = try vm.alloc.alloc(Value, vals.len);
+    errdefer vm.alloc.free(out);
+    const xs = @as([*]f64, @ptrCast(out.ptr))[0..out.len];
+    switch (listKind(vals)) {
+        .float => @memcpy(xs, floatItems(vals)),
+        .int => {
+            for (vals, xs) |val, *x| {
+                x.* = @floatFromInt(val.asInteger());
+            }
+        },
+        .mixed => {
+            for (vals, xs) |val, *x| {
+                x.* = try toF64(val);
+            }
+        },
+    }
+    mapFloats(op, xs);
+    return cy.heap.allocOwnedList(vm, out);
+}
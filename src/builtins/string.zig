@@ -128,7 +128,8 @@ pub fn insertFn(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSecti
 pub fn find(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     const obj = args[0].asHeapObject();
     const str = obj.string.getSlice();
-    const needle = args[1].asString();
+    const needleObj = args[1].asHeapObject();
+    const needle = needleObj.string.getSlice();
     if (needle.len > 0 and needle.len <= str.len) {
         if (needle.len == 1) {
             // One ascii char special case. Perform indexOfChar.
@@ -142,7 +143,9 @@ pub fn find(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) V
                 }
             }
         }
-        if (cy.string.indexOf(str, needle)) |idx| {
+        var finderBuf: cy.string.Finder = undefined;
+        const finder = vm.finderCache.get(needleObj, &finderBuf);
+        if (finder.find(str)) |idx| {
             const stype = obj.string.getType();
             if (stype.isUstring()) {
                 const charIdx = cy.toUtf8CharIdx(str, idx);
@@ -275,36 +278,36 @@ pub fn findRune(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSectio
 }
 
 pub fn upper(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
-    const obj = args[0].asHeapObject();
-    const str = obj.string.getSlice();
-    const stype = obj.string.getType();
-    if (stype.isAstring()) {
-        const new = vm.allocUnsetAstringObject(str.len) catch fatal();
-        const newBuf = new.astring.getMutSlice();
-        _ = std.ascii.upperString(newBuf, str);
-        return vm.allocOwnedAstring(new) catch fatal();
-    } else {
-        const new = vm.allocUnsetUstringObject(str.len, obj.string.getUstringCharLen()) catch fatal();
-        const newBuf = new.ustring.getMutSlice();
-        _ = std.ascii.upperString(newBuf, str);
-        return vm.allocOwnedUstring(new) catch fatal();
-    }
+    return mapCase(vm, args[0].asHeapObject(), .upper) catch fatal();
 }
 
 pub fn lower(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
-    const obj = args[0].asHeapObject();
+    return mapCase(vm, args[0].asHeapObject(), .lower) catch fatal();
+}
+
+pub fn foldCase(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
+    return mapCase(vm, args[0].asHeapObject(), .fold) catch fatal();
+}
+
+fn mapCase(vm: *cy.VM, obj: *cy.HeapObject, comptime mode: cy.unicode.CaseMode) linksection(cy.StdSection) !Value {
     const str = obj.string.getSlice();
     const stype = obj.string.getType();
     if (stype.isAstring()) {
-        const new = vm.allocUnsetAstringObject(str.len) catch fatal();
+        const new = try vm.allocUnsetAstringObject(str.len);
         const newBuf = new.astring.getMutSlice();
-        _ = std.ascii.lowerString(newBuf, str);
-        return vm.allocOwnedAstring(new) catch fatal();
+        _ = cy.unicode.mapAsciiPrefix(mode, newBuf, str);
+        return vm.allocOwnedAstring(new);
     } else {
-        const new = vm.allocUnsetUstringObject(str.len, obj.string.getUstringCharLen()) catch fatal();
-        const newBuf = new.ustring.getMutSlice();
-        _ = std.ascii.lowerString(newBuf, str);
-        return vm.allocOwnedUstring(new) catch fatal();
+        // Mapped runes can have a different byte length.
+        const charLen = obj.string.getUstringCharLen();
+        try vm.u8Buf.resize(vm.alloc, str.len * 2);
+        const n = cy.unicode.mapUtf8(mode, vm.u8Buf.buf[0..str.len * 2], str);
+        const res = vm.u8Buf.buf[0..n];
+        if (n == charLen) {
+            return vm.retainOrAllocAstring(res);
+        } else {
+            return vm.retainOrAllocUstring(res, charLen);
+        }
     }
 }
 
@@ -435,10 +438,13 @@ fn astringReplace(vm: *cy.VM, str: []const u8, needlev: *cy.heap.String, replace
     const replacement = replacev.getSlice();
     const rcharLen = replacev.getCharLen();
 
+    var finderBuf: cy.string.Finder = undefined;
+    const finder = vm.finderCache.get(@ptrCast(needlev), &finderBuf);
+
     const idxBuf = &@as(*cy.VM, @ptrCast(vm)).u8Buf;
     idxBuf.clearRetainingCapacity();
     defer idxBuf.ensureMaxCapOrClear(vm.alloc, 4096) catch fatal();
-    const newLen = cy.prepReplacement(str, needle, replacement, idxBuf.writer(vm.alloc)) catch fatal();
+    const newLen = cy.prepReplacement(str, finder, replacement, idxBuf.writer(vm.alloc)) catch fatal();
     const numIdxes = @divExact(idxBuf.len, 4);
     if (numIdxes > 0) {
         if (rcharLen == replacement.len) {
@@ -465,10 +471,13 @@ fn ustringReplace(vm: *cy.VM, str: []const u8, needlev: *cy.heap.String, replace
     var rcharLen: u32 = undefined;
     const replacement = replacev.getSlice2(&rcharLen);
 
+    var finderBuf: cy.string.Finder = undefined;
+    const finder = vm.finderCache.get(@ptrCast(needlev), &finderBuf);
+
     const idxBuf = &@as(*cy.VM, @ptrCast(vm)).u8Buf;
     idxBuf.clearRetainingCapacity();
     defer idxBuf.ensureMaxCapOrClear(vm.alloc, 4096) catch fatal();
-    const newLen = cy.prepReplacement(str, needle, replacement, idxBuf.writer(vm.alloc)) catch fatal();
+    const newLen = cy.prepReplacement(str, finder, replacement, idxBuf.writer(vm.alloc)) catch fatal();
     const numIdxes = @divExact(idxBuf.len, 4);
     if (numIdxes > 0) {
         const new = vm.allocUnsetUstringObject(newLen, @intCast(str.len + idxBuf.len * rcharLen - idxBuf.len * ncharLen)) catch fatal();
@@ -531,15 +540,17 @@ pub fn split(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection)
     const str = obj.string.getSlice();
     const stype = obj.string.getType();
     const parent = obj.string.getParentByType(stype);
-    const delim = args[1].asString();
+    const delimObj = args[1].asHeapObject();
 
     const res = try vm.allocEmptyList();
-    if (delim.len == 0) {
+    if (delimObj.string.len() == 0) {
         return res;
     }
     const list = res.asHeapObject();
 
-    var iter = std.mem.split(u8, str, delim);
+    var finderBuf: cy.string.Finder = undefined;
+    const finder = vm.finderCache.get(delimObj, &finderBuf);
+    var iter = cy.string.SplitIterator.init(str, finder);
     while (iter.next()) |part| {
         if (stype.isAstring()) {
             vm.retainObject(parent);
@@ -560,6 +571,10 @@ pub fn stringCall(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
     if (val.isString()) {
         vm.retain(val);
         return val; 
+    } else if (val.isSymbol()) {
+        return vm.getSymbolStr(val.asSymbolId(), true);
+    } else if (val.isEnum()) {
+        return vm.getEnumStr(val, true);
     } else {
         var charLen: u32 = undefined;
         const str = try vm.getOrBufPrintValueStr2(&cy.tempBuf, val, &charLen);
@@ -373,7 +373,8 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             const dst = pc[2].val;
             len += try fmt.printCount(w, "local={}, dst={}", &.{v(local), v(dst)});
         },
-        .captured => {
+        .captured,
+        .capturedValue => {
             const closure = pc[1].val;
             const varIdx = pc[2].val;
             const dst = pc[3].val;
@@ -546,7 +547,8 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             const endLocal = pc[1].val;
             len += try fmt.printCount(w, "endLocal={}", &.{ v(endLocal) });
         },
-        .compare => {
+        .compare,
+        .compareBits => {
             const left = pc[1].val;
             const right = pc[2].val;
             const dst = pc[3].val;
@@ -595,6 +597,18 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             const dst = pc[3].val;
             len += try fmt.printCount(w, "recv={}, index={}, dst={}", &.{v(recv), v(index), v(dst)});
         },
+        .mapUpdate => {
+            const map = pc[1].val;
+            const key = pc[2].val;
+            const right = pc[3].val;
+            const flags = pc[5].val;
+            const skip = @as(*const align(1) u16, @ptrCast(pc + 6)).*;
+            len += try fmt.printCount(w, "map={}, key={}, right={}, flags={}, skip @{}", &.{
+                v(map), v(key), v(right), v(flags), v(pcOffset + skip)});
+            if (flags & vmc.MAP_UPDATE_DEFAULT != 0) {
+                len += try fmt.printCount(w, ", default={}", &.{v(pc[4].val)});
+            }
+        },
         .jump => {
             const jump = @as(*const align(1) i16, @ptrCast(pc + 1)).*;
             const jumpU32: u32 = @bitCast(@as(i32, jump));
@@ -622,7 +636,8 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             const dst = pc[3].val;
             len += try fmt.printCount(w, "%{} = [List %{}..%{}]", &.{v(dst), v(startLocal), v(startLocal+numElems)});
         },
-        .seqDestructure => {
+        .seqDestructure,
+        .seqDestructureMove => {
             const src = pc[1].val;
             const numLocals = pc[2].val;
             const locals = std.mem.sliceAsBytes(pc[3..3+numLocals]);
@@ -704,10 +719,20 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             len += try fmt.printCount(w, "startArgs={}, numArgs={}, argDst={}, jump={}, initStack={}, dst={}",
                 &.{v(startArgs), v(numArgs), v(argDst), v(jump), v(initialStackSize), v(dst)});
         },
-        .coresume => {
+        .coresume,
+        .coreturnGen => {
             const fiberLocal = pc[1].val;
             const retLocal = pc[2].val;
-            len += try fmt.printCount(w, "fiberLocal={}, retLocal={}", &.{v(fiberLocal), v(retLocal) });
+            const frameStart = pc[3].val;
+            len += try fmt.printCount(w, "fiberLocal={}, retLocal={}, frameStart={}", &.{v(fiberLocal), v(retLocal), v(frameStart) });
+        },
+        .coinitGen => {
+            const startArgs = pc[1].val;
+            const numArgs = pc[2].val;
+            const symId = @as(*const align(1) u16, @ptrCast(pc + 3)).*;
+            const dst = pc[5].val;
+            len += try fmt.printCount(w, "startArgs={}, numArgs={}, sym={}, dst={}",
+                &.{v(startArgs), v(numArgs), v(symId), v(dst)});
         },
         .sliceList => {
             const recv = pc[1].val;
@@ -748,7 +773,8 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             const endOffset = @as(*const align(1) u16, @ptrCast(pc + 1)).*;
             len += try fmt.printCount(w, "endOff={}", &.{v(endOffset)});
         },
-        .stringTemplate => {
+        .stringTemplate,
+        .stringTemplateStrs => {
             const startLocal = pc[1].val;
             const exprCount = pc[2].val;
             const dst = pc[3].val;
@@ -919,7 +945,7 @@ pub fn getInstLenAt(pc: [*]const Inst) u8 {
         .constI8,
         .jump,
         .coyield,
-        .coresume,
+        .coyieldGen,
         .box,
         .setBoxValue,
         .setBoxValueRelease,
@@ -928,15 +954,19 @@ pub fn getInstLenAt(pc: [*]const Inst) u8 {
         .tagLiteral => {
             return 3;
         },
-        .seqDestructure => {
+        .seqDestructure,
+        .seqDestructureMove => {
             return 3 + pc[2].val;
         },
         .objectTypeCheck => {
             return 3 + pc[2].val * 5;
         },
         .typeCheck,
+        .coresume,
+        .coreturnGen,
         .call,
         .captured,
+        .capturedValue,
         .constOp,
         .constRetain,
         .staticVar,
@@ -950,13 +980,16 @@ pub fn getInstLenAt(pc: [*]const Inst) u8 {
         .jumpCond,
         .compare,
         .compareNot,
+        .compareBits,
+        .compareNotBits,
         .list,
         .tag,
         .setCaptured,
         .jumpNotCond => {
             return 4;
         },
-        .stringTemplate => {
+        .stringTemplate,
+        .stringTemplateStrs => {
             const numExprs = pc[2].val;
             return 4 + numExprs + 1;
         },
@@ -975,6 +1008,7 @@ pub fn getInstLenAt(pc: [*]const Inst) u8 {
             return 5 + numConds * 3;
         },
         .setObjectFieldCheck,
+        .coinitGen,
         .object,
         .objectSmall,
         .forRange,
@@ -987,6 +1021,7 @@ pub fn getInstLenAt(pc: [*]const Inst) u8 {
         },
         .field,
         .fieldIC,
+        .mapUpdate,
         .forRangeInit => {
             return 8;
         },
@@ -1077,6 +1112,11 @@ pub const OpCode = enum(u8) {
     indexTuple = vmc.CodeIndexTuple,
     indexMap = vmc.CodeIndexMap,
 
+    /// Fused read-modify-write of a map entry. Falls through to the unfused instructions
+    /// when the update can't be done in place.
+    /// [map] [key] [right] [default] [flags] [skipOffset u16]
+    mapUpdate = vmc.CodeMapUpdate,
+
     appendList = vmc.CodeAppendList,
 
     /// First operand points the first elem and also the dst local. Second operand contains the number of elements.
@@ -1137,9 +1177,13 @@ pub const OpCode = enum(u8) {
     modFloat = vmc.CodeModFloat,
 
     compareNot = vmc.CodeCompareNot,
+    compareBits = vmc.CodeCompareBits,
+    compareNotBits = vmc.CodeCompareNotBits,
 
     /// [startLocal] [exprCount] [dst] [..string consts]
     stringTemplate = vmc.CodeStringTemplate,
+    /// Same operands as `stringTemplate`. Every expression is a string so no formatting is needed.
+    stringTemplateStrs = vmc.CodeStringTemplateStrs,
     negFloat = vmc.CodeNegFloat,
 
     objectTypeCheck = vmc.CodeObjectTypeCheck,
@@ -1152,8 +1196,22 @@ pub const OpCode = enum(u8) {
 
     coinit = vmc.CodeCoinit,
     coyield = vmc.CodeCoyield,
+
+    /// [fiberLocal] [dstLocal] [frameStart]
+    /// Always followed by `coreturnGen`.
     coresume = vmc.CodeCoresume,
     coreturn = vmc.CodeCoreturn,
+
+    /// Creates a stackless generator.
+    /// [startArgsLocal] [numArgs] [symId u16] [dstLocal]
+    coinitGen = vmc.CodeCoinitGen,
+
+    /// Suspends a stackless generator or falls back to `coyield`.
+    /// [startLocal] [endLocal]
+    coyieldGen = vmc.CodeCoyieldGen,
+
+    /// [fiberLocal] [dstLocal] [frameStart]
+    coreturnGen = vmc.CodeCoreturnGen,
     retain = vmc.CodeRetain,
 
     /// Lifts a source local to a box object and stores the result in `dstLocal`.
@@ -1166,6 +1224,7 @@ pub const OpCode = enum(u8) {
     boxValue = vmc.CodeBoxValue,
     boxValueRetain = vmc.CodeBoxValueRetain,
     captured = vmc.CodeCaptured,
+    capturedValue = vmc.CodeCapturedValue,
     setCaptured = vmc.CodeSetCaptured,
     /// TODO: Rename to enumOp.
     tag = vmc.CodeTag,
@@ -1173,6 +1232,7 @@ pub const OpCode = enum(u8) {
     tagLiteral = vmc.CodeTagLiteral,
 
     seqDestructure = vmc.CodeSeqDestructure,
+    seqDestructureMove = vmc.CodeSeqDestructureMove,
     bitwiseAnd = vmc.CodeBitwiseAnd,
     bitwiseOr = vmc.CodeBitwiseOr,
     bitwiseXor = vmc.CodeBitwiseXor,
@@ -19,6 +19,24 @@ pub const listAppend = c.csListAppend;
 pub const listGet = c.csListGet;
 pub const listSet = c.csListSet;
 pub const listInsert = c.csListInsert;
+pub const listGetRange = c.csListGetRange;
+pub const listAppendN = c.csListAppendN;
+pub const newListFromF64s = c.csNewListFromF64s;
+pub const newListFromI64s = c.csNewListFromI64s;
+pub const newEmptyMap = c.csNewEmptyMap;
+pub const newString = c.csNewString;
+pub const mapSize = c.csMapSize;
+pub const mapContains = c.csMapContains;
+pub const mapContainsStringKey = c.csMapContainsStringKey;
+pub const mapGet = c.csMapGet;
+pub const mapGetStringKey = c.csMapGetStringKey;
+pub const mapSet = c.csMapSet;
+pub const mapSetStringKey = c.csMapSetStringKey;
+pub const mapIter = c.csMapIter;
+pub const asStringView = c.csAsStringView;
+pub const asArrayView = c.csAsArrayView;
+pub const stringCharLen = c.csStringCharLen;
+pub const release = c.csRelease;
 pub const asFloat = c.csAsFloat;
 pub const float = c.csFloat;
 pub const getTypeId = c.csGetTypeId;
@@ -585,6 +585,7 @@ fn genStmt(c: *Chunk, idx: u32) anyerror!void {
         .ifStmt             => try ifStmt(c, idx, nodeId),
         .mainBlock          => try mainBlock(c, idx, nodeId),
         // .opSet              => try opSet(c, idx, nodeId),
+        // .mapUpdate          => try mapUpdate(c, idx, nodeId),
         // .pushDebugLabel     => try pushDebugLabel(c, idx),
         .retExprStmt        => try retExprStmt(c, idx, nodeId),
         // .retStmt            => try retStmt(c),
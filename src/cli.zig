@@ -4,6 +4,7 @@ const cy = @import("cyber.zig");
 const bindings = @import("builtins/bindings.zig");
 const os_mod = @import("std/os.zig");
 const test_mod = @import("std/test.zig");
+const sched_mod = @import("std/sched.zig");
 const cache = @import("cache.zig");
 const c = @import("capi.zig");
 const bt = cy.types.BuiltinTypes;
@@ -26,7 +27,18 @@ const stdMods = std.ComptimeStringMap(c.ModuleLoaderResult, .{
         .onTypeLoad = os_mod.onTypeLoad,
         .onLoad = os_mod.onLoad,
         .onReceipt = null,
+        .onDestroy = os_mod.onDestroy,
+    }},
+    .{"sched", c.ModuleLoaderResult{
+        .src = sched_mod.Src,
+        .srcLen = sched_mod.Src.len,
+        .funcLoader = null,
+        .onLoad = null,
+        .onReceipt = null,
+        .varLoader = null,
+        .typeLoader = null,
         .onDestroy = null,
+        .onTypeLoad = null,
     }},
     .{"test", c.ModuleLoaderResult{
         .src = test_mod.Src,
@@ -111,6 +111,7 @@ pub const validateUtf8 = string.validateUtf8;
 pub const utf8CharSliceAt = string.utf8CharSliceAt;
 pub const indexOfChar = string.indexOfChar;
 pub const indexOfAsciiSet = string.indexOfAsciiSet;
+pub const unicode = @import("unicode.zig");
 pub const toUtf8CharIdx = string.toUtf8CharIdx;
 pub const charIndexOfCodepoint = string.charIndexOfCodepoint;
 pub const getLineEnd = string.getLineEnd;
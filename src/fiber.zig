@@ -13,6 +13,7 @@ const rt = cy.rt;
 const log = cy.log.scoped(.fiber);
 const Value = cy.Value;
 const bt = cy.types.BuiltinTypes;
+const CallArgStart = cy.vm.CallArgStart;
 
 pub const PanicPayload = u64;
 
@@ -63,6 +64,45 @@ pub fn allocFiber(vm: *cy.VM, pc: usize, args: []const cy.Value, argDst: u8, ini
         .panicPayload = undefined,
         .panicType = vmc.PANIC_NONE,
         .prevFiber = undefined,
+        .genState = vmc.GEN_NONE,
+    };
+
+    return Value.initCycPtr(obj);
+}
+
+/// A stackless generator is a `Fiber` without its own stack. The function's frame is kept in
+/// a heap buffer that `coresume` copies onto the current stack and `CoyieldGen` copies back.
+pub fn allocGen(vm: *cy.VM, symId: u32, args: []const cy.Value) linksection(cy.HotSection) !cy.Value {
+    const sym = vm.funcSyms.buf[symId];
+    if (sym.entryT != @intFromEnum(rt.FuncSymbolType.func)) {
+        return error.Unexpected;
+    }
+    const stackSize = @max(sym.inner.func.stackSize, CallArgStart + args.len);
+    var frame = try vm.alloc.alloc(Value, stackSize);
+    std.mem.copy(Value, frame[CallArgStart..CallArgStart+args.len], args);
+
+    const obj: *vmc.Fiber = @ptrCast(try cy.heap.allocExternalObject(vm, @sizeOf(vmc.Fiber), true));
+    obj.* = .{
+        .typeId = bt.Fiber | vmc.CYC_TYPE_MASK,
+        .rc = 1,
+        .stackPtr = @ptrCast(frame.ptr),
+        .stackLen = @intCast(frame.len),
+        .pcOffset = sym.inner.func.pc,
+        .argStart = CallArgStart,
+        .numArgs = @intCast(args.len),
+        .stackOffset = 0,
+        .parentDstLocal = cy.NullU8,
+        .tryStackCap = 0,
+        .tryStackPtr = undefined,
+        .tryStackLen = 0,
+        .throwTracePtr = undefined,
+        .throwTraceCap = 0,
+        .throwTraceLen = 0,
+        .initialPcOffset = sym.inner.func.pc,
+        .panicType = vmc.PANIC_NONE,
+        .panicPayload = undefined,
+        .prevFiber = undefined,
+        .genState = vmc.GEN_INIT,
     };
 
     return Value.initCycPtr(obj);
@@ -83,7 +123,7 @@ pub fn pushFiber(vm: *cy.VM, curFiberEndPc: usize, curFramePtr: [*]Value, fiber:
     vm.stack = @as([*]Value, @ptrCast(fiber.stackPtr))[0..fiber.stackLen];
     vm.stackEndPtr = vm.stack.ptr + fiber.stackLen;
     // Check if fiber was previously yielded.
-    if (vm.ops[fiber.pcOffset].opcode() == .coyield) {
+    if (isYieldOp(vm.ops[fiber.pcOffset].opcode())) {
         log.tracev("fiber set to {} {*}", .{fiber.pcOffset + 3, vm.framePtr});
         return .{
             .pc = toVmPc(vm, fiber.pcOffset + 3),
@@ -128,18 +168,47 @@ pub fn popFiber(vm: *cy.VM, cur: PcSpOff, retValue: Value) PcSpOff {
     };
 }
 
+fn isYieldOp(code: cy.OpCode) bool {
+    return code == .coyield or code == .coyieldGen;
+}
+
+/// Releases the locals of a generator paused at `CoyieldGen` and the bound args.
+/// A generator that is running or done only owns its args.
+fn releaseGenFrame(vm: *cy.VM, gen: *cy.Fiber) !void {
+    const frame = @as([*]Value, @ptrCast(gen.stackPtr))[0..gen.stackLen];
+    if (gen.genState == vmc.GEN_PAUSED) {
+        const symIdx = cy.debug.indexOfDebugSym(vm, gen.pcOffset) orelse return error.NoDebugSym;
+        const tempIdx = cy.debug.getDebugTempIndex(vm, symIdx);
+        if (tempIdx != cy.NullId) {
+            cy.arc.runTempReleaseOps(vm, frame.ptr, tempIdx);
+        }
+        const localsStart = vm.ops[gen.pcOffset+1].val;
+        const localsEnd = vm.ops[gen.pcOffset+2].val;
+        for (frame[localsStart..localsEnd]) |val| {
+            cy.arc.release(vm, val);
+        }
+    }
+    for (frame[gen.argStart..gen.argStart+gen.numArgs]) |arg| {
+        cy.arc.release(vm, arg);
+    }
+    vm.alloc.free(frame);
+}
+
 /// Unwinds the stack and releases the locals.
 /// This also releases the initial captured vars since it's on the stack.
 pub fn releaseFiberStack(vm: *cy.VM, fiber: *cy.Fiber) !void {
     log.tracev("release fiber stack, start", .{});
     defer log.tracev("release fiber stack, end", .{});
+    if (fiber.genState != vmc.GEN_NONE) {
+        return releaseGenFrame(vm, fiber);
+    }
     var stack = @as([*]Value, @ptrCast(fiber.stackPtr))[0..fiber.stackLen];
     var framePtr = fiber.stackOffset;
     var pc = fiber.pcOffset;
 
     if (pc != cy.NullId) {
         // Check if fiber was previously on a yield op.
-        if (vm.ops[pc].opcode() == .coyield) {
+        if (isYieldOp(vm.ops[pc].opcode())) {
             // The yield statement contains the alive locals.
             const localsStart = vm.ops[pc+1].val;
             const localsEnd = vm.ops[pc+2].val;
@@ -520,6 +520,19 @@ const Ustring = extern struct {
     }
 };
 
+/// Slice `offset` when the parent is not within a `u32` offset below `buf`,
+/// such as a host object that owns mapped memory. The parent is stored in `parent` instead.
+const FarParentOffset: u32 = std.math.maxInt(u32);
+
+fn getParentOffset(buf: [*]const u8, parent: *HeapObject) ?u32 {
+    const ubuf = @intFromPtr(buf);
+    const uparent = @intFromPtr(parent);
+    if (ubuf < uparent or ubuf - uparent >= FarParentOffset) {
+        return null;
+    }
+    return @intCast(ubuf - uparent);
+}
+
 pub const AstringSlice = extern struct {
     typeId: cy.TypeId align(8),
     rc: u32,
@@ -528,8 +541,13 @@ pub const AstringSlice = extern struct {
     offset: u32,
     /// Pointer to the first byte of the slice.
     buf: [*]const u8,
+    /// Only set when `offset` is `FarParentOffset`.
+    parent: ?*cy.HeapObject,
 
     pub inline fn getParentPtr(self: *const AstringSlice) ?*cy.HeapObject {
+        if (self.offset == FarParentOffset) {
+            return self.parent;
+        }
         if (self.offset != 0) {
             return @ptrFromInt(@intFromPtr(self.buf) - self.offset);
         } else return null;
@@ -616,6 +634,8 @@ const ArraySlice = extern struct {
     /// `buf` offset from the parent Array object.
     offset: u32,
     buf: [*]const u8,
+    /// Only set when `offset` is `FarParentOffset`.
+    parent: ?*cy.HeapObject,
 
     pub inline fn getMutSlice(self: *ArraySlice) []u8 {
         return @constCast(self.buf[0..@as(*const Array, @ptrCast(self)).len()]);
@@ -626,6 +646,9 @@ const ArraySlice = extern struct {
     }
 
     pub inline fn getParentPtr(self: *const ArraySlice) ?*cy.HeapObject {
+        if (self.offset == FarParentOffset) {
+            return self.parent;
+        }
         if (self.offset != 0) {
             return @ptrFromInt(@intFromPtr(self.buf) - self.offset);
         } else return null;
@@ -759,16 +782,24 @@ pub const DListNode = extern struct {
     }
 };
 
+/// Bytes allocated in front of an external object for the Zig allocator's size field and the cyclable list node.
+fn externalPayloadSize(comptime cyclable: bool) usize {
+    // u64 so it can be 8 byte aligned.
+    const ZigLenSize = if (cy.Malloc == .zig) @sizeOf(u64) else 0;
+    return (if (cy.hasGC and cyclable) @sizeOf(DListNode) else 0) + ZigLenSize;
+}
+
 pub fn allocExternalObject(vm: *cy.VM, size: usize, comptime cyclable: bool) !*HeapObject {
     // Align with HeapObject so it can be casted.
-    const addToCyclableList = comptime (cy.hasGC and cyclable);
+    const slice = try vm.alloc.alignedAlloc(u8, @alignOf(HeapObject), size + externalPayloadSize(cyclable));
+    return initExternalObject(vm, slice, cyclable);
+}
 
-    // An extra size field is included for the Zig allocator.
-    // u64 so it can be 8 byte aligned.
-    const ZigLenSize = if (cy.Malloc == .zig) @sizeOf(u64) else 0;
-    const PayloadSize = (if (addToCyclableList) @sizeOf(DListNode) else 0) + ZigLenSize;
+/// Initializes the payload of an allocation made for an external object and returns the object.
+fn initExternalObject(vm: *cy.VM, slice: []align(@alignOf(HeapObject)) u8, comptime cyclable: bool) *HeapObject {
+    const addToCyclableList = comptime (cy.hasGC and cyclable);
+    const PayloadSize = externalPayloadSize(cyclable);
 
-    const slice = try vm.alloc.alignedAlloc(u8, @alignOf(HeapObject), size + PayloadSize);
     defer {
         if (cy.Trace) {
             cy.heap.traceAlloc(vm, @ptrCast(slice.ptr + PayloadSize));
@@ -784,7 +815,8 @@ pub fn allocExternalObject(vm: *cy.VM, size: usize, comptime cyclable: bool) !*H
         vm.cyclableHead = node;
     }
     if (cy.Malloc == .zig) {
-        @as(*u64, @ptrCast(slice.ptr + PayloadSize - ZigLenSize)).* = size;
+        // An extra size field is included for the Zig allocator.
+        @as(*u64, @ptrCast(slice.ptr + PayloadSize - @sizeOf(u64))).* = slice.len - PayloadSize;
     }
     if (cy.TraceRC) {
         cy.arc.log.tracev("0 +1 alloc external object: {*}", .{slice.ptr + PayloadSize});
@@ -1186,59 +1218,155 @@ pub fn allocLambda(self: *cy.VM, funcPc: usize, numParams: u8, stackSize: u8, fu
 }
 
 pub fn allocStringTemplate(self: *cy.VM, strs: []const cy.Inst, vals: []const Value) !Value {
-    const firstStr = Value.initRaw(self.consts[strs[0].val].val).asHeapObject();
-    const firstSlice = firstStr.string.getSlice();
-    try self.u8Buf.resize(self.alloc, firstSlice.len);
-    std.mem.copy(u8, self.u8Buf.items(), firstSlice);
+    return allocStringTemplateExt(self, strs, vals);
+}
 
-    const writer = self.u8Buf.writer(self.alloc);
-    var finalCharLen: u32 = firstStr.string.getCharLen();
-    for (vals, 0..) |val, i| {
-        var charLen: u32 = undefined;
-        const valstr = try self.getOrBufPrintValueStr2(&cy.tempBuf, val, &charLen);
-        finalCharLen += charLen;
-        _ = try writer.write(valstr);
+pub fn allocStringTemplate2(self: *cy.VM, strs: []const Value, vals: []const Value) !Value {
+    return allocStringTemplateExt(self, strs, vals);
+}
 
-        const str = Value.initRaw(self.consts[strs[i+1].val].val).asHeapObject();
-        finalCharLen += str.string.getCharLen();
+/// `strs` are either const indexes (bytecode) or string values.
+inline fn templateStr(vm: *cy.VM, strs: anytype, i: usize) *const String {
+    if (@TypeOf(strs) == []const cy.Inst) {
+        return &Value.initRaw(vm.consts[strs[i].val].val).asHeapObject().string;
+    } else {
+        return &strs[i].asHeapObject().string;
+    }
+}
 
-        try self.u8Buf.appendSlice(self.alloc, str.string.getSlice());
+/// Returns the number of bytes `writeValue` would produce for values with a fixed format.
+/// Returns null if the value needs to be formatted to determine its length.
+fn templateValueLen(val: Value) ?u32 {
+    switch (val.getTypeId()) {
+        bt.String => return val.asHeapObject().string.len(),
+        bt.Integer => return intStrLen(val.asInteger()),
+        bt.Float => {
+            const f = val.asF64();
+            // Integral floats are printed as integers. Exclude -0 and magnitudes that can't round trip through i64.
+            if (Value.floatCanBeInteger(f) and @fabs(f) < 9007199254740992 and !(f == 0 and std.math.signbit(f))) {
+                return intStrLen(@intFromFloat(f));
+            }
+            return null;
+        },
+        bt.Boolean => return if (val.asBool()) 4 else 5,
+        bt.None => return 4,
+        else => return null,
     }
+}
 
-    if (self.u8Buf.len != finalCharLen) {
-        return retainOrAllocUstring(self, self.u8Buf.items(), finalCharLen);
-    } else {
-        return retainOrAllocAstring(self, self.u8Buf.items());
+fn intStrLen(i: i64) u32 {
+    var n = std.math.absCast(i);
+    var len: u32 = if (i < 0) 2 else 1;
+    while (n >= 10) : (n /= 10) {
+        len += 1;
     }
+    return len;
 }
 
-pub fn allocStringTemplate2(self: *cy.VM, strs: []const Value, vals: []const Value) !Value {
-    const firstStr = strs[0].asHeapObject();
-    const firstSlice = firstStr.string.getSlice();
-    try self.u8Buf.resize(self.alloc, firstSlice.len);
-    std.mem.copy(u8, self.u8Buf.items(), firstSlice);
+/// Computes the exact length of the template first so the result can be written into a single allocation.
+/// Only values without a fixed format (eg. objects that dispatch `toString`) are printed to `u8Buf` beforehand.
+fn allocStringTemplateExt(self: *cy.VM, strs: anytype, vals: []const Value) !Value {
+    var lens: [256]u32 = undefined;
+    self.u8Buf.clearRetainingCapacity();
 
-    const writer = self.u8Buf.writer(self.alloc);
-    var finalCharLen: u32 = firstStr.string.getCharLen();
+    const first = templateStr(self, strs, 0);
+    var len: usize = first.len();
+    var charLen: u32 = first.getCharLen();
     for (vals, 0..) |val, i| {
-        var charLen: u32 = undefined;
-        const valstr = try self.getOrBufPrintValueStr2(&cy.tempBuf, val, &charLen);
-        finalCharLen += charLen;
-        _ = try writer.write(valstr);
+        if (templateValueLen(val)) |vlen| {
+            lens[i] = vlen;
+            if (val.isString()) {
+                charLen += val.asHeapObject().string.getCharLen();
+            } else {
+                charLen += vlen;
+            }
+        } else {
+            const start = self.u8Buf.len;
+            try self.writeValue(self.u8Buf.writer(self.alloc), val);
+            lens[i] = @intCast(self.u8Buf.len - start);
+            charLen += lens[i];
+        }
+        len += lens[i];
+        const str = templateStr(self, strs, i+1);
+        len += str.len();
+        charLen += str.getCharLen();
+    }
 
-        const str = strs[i+1].asHeapObject();
-        finalCharLen += str.string.getCharLen();
+    return allocStringTemplateResult(self, len, charLen, strs, vals, &lens);
+}
 
-        try self.u8Buf.appendSlice(self.alloc, str.string.getSlice());
+fn allocStringTemplateResult(self: *cy.VM, len: usize, charLen: u32, strs: anytype, vals: []const Value, lens: []const u32) !Value {
+    if (len <= DefaultStringInternMaxByteLen) {
+        const buf = self.tempBuf[0..len];
+        writeStringTemplate(self, buf, strs, vals, lens);
+        if (len != charLen) {
+            return retainOrAllocUstring(self, buf, charLen);
+        } else {
+            return retainOrAllocAstring(self, buf);
+        }
     }
 
-    if (self.u8Buf.len != finalCharLen) {
-        return retainOrAllocUstring(self, self.u8Buf.items(), finalCharLen);
+    if (len != charLen) {
+        const obj = try allocUnsetUstringObject(self, len, charLen);
+        writeStringTemplate(self, obj.ustring.getMutSlice(), strs, vals, lens);
+        return Value.initNoCycPtr(obj);
     } else {
-        return retainOrAllocAstring(self, self.u8Buf.items());
+        const obj = try allocUnsetAstringObject(self, len);
+        writeStringTemplate(self, obj.astring.getMutSlice(), strs, vals, lens);
+        return Value.initNoCycPtr(obj);
     }
 }
 
+fn writeStringTemplate(self: *cy.VM, dst: []u8, strs: anytype, vals: []const Value, lens: []const u32) void {
+    const first = templateStr(self, strs, 0).getSlice();
+    @memcpy(dst[0..first.len], first);
+    var pos: usize = first.len;
+    var bufPos: usize = 0;
+    for (vals, 0..) |val, i| {
+        const part = dst[pos..pos+lens[i]];
+        switch (val.getTypeId()) {
+            bt.String => @memcpy(part, val.asString()),
+            bt.Integer => _ = std.fmt.formatIntBuf(part, val.asInteger(), 10, .lower, .{}),
+            bt.Boolean => @memcpy(part, if (val.asBool()) "true" else "false"),
+            bt.None => @memcpy(part, "none"),
+            else => {
+                if (templateValueLen(val) != null) {
+                    // Integral float.
+                    _ = std.fmt.formatIntBuf(part, @as(i64, @intFromFloat(val.asF64())), 10, .lower, .{});
+                } else {
+                    @memcpy(part, self.u8Buf.buf[bufPos..bufPos+lens[i]]);
+                    bufPos += lens[i];
+                }
+            },
+        }
+        pos += lens[i];
+
+        const str = templateStr(self, strs, i+1).getSlice();
+        @memcpy(dst[pos..pos+str.len], str);
+        pos += str.len;
+    }
+}
+
+/// Fast path for templates whose expressions are all known to be strings.
+/// Lengths are summed directly from the string headers and nothing is formatted.
+pub fn allocStringTemplateStrs(self: *cy.VM, strs: []const cy.Inst, vals: []const Value) !Value {
+    var lens: [256]u32 = undefined;
+    var len: usize = 0;
+    var charLen: u32 = 0;
+    for (0..strs.len) |i| {
+        const str = templateStr(self, strs, i);
+        len += str.len();
+        charLen += str.getCharLen();
+    }
+    for (vals, 0..) |val, i| {
+        const str = &val.asHeapObject().string;
+        lens[i] = str.len();
+        len += lens[i];
+        charLen += str.getCharLen();
+    }
+    return allocStringTemplateResult(self, len, charLen, strs, vals, &lens);
+}
+
 pub fn getOrAllocOwnedAstring(self: *cy.VM, obj: *HeapObject) linksection(cy.HotSection) !Value {
     return getOrAllocOwnedString(self, obj, obj.astring.getSlice());
 }
@@ -1398,7 +1526,7 @@ pub fn getOrAllocUstringConcat(self: *cy.VM, str: []const u8, str2: []const u8,
     }
 }
 
-const DefaultStringInternMaxByteLen = 64;
+pub const DefaultStringInternMaxByteLen = 64;
 
 // If no such string intern exists, `obj` is added as a string intern.
 // Otherwise, `obj` is released and the existing string intern is retained and returned.
@@ -1422,6 +1550,7 @@ pub fn getOrAllocOwnedString(self: *cy.VM, obj: *HeapObject, str: []const u8) li
 const Root = @This();
 pub const VmExt = struct {
     pub const allocStringInternOrArray = Root.allocStringInternOrArray;
+    pub const allocOwnedStringOrArray = Root.allocOwnedStringOrArray;
     pub const retainOrAllocAstring = Root.retainOrAllocAstring;
     pub const retainOrAllocUstring = Root.retainOrAllocUstring;
     pub const allocAstringConcat = Root.getOrAllocAstringConcat;
@@ -1477,6 +1606,63 @@ pub fn allocStringInternOrArray(self: *cy.VM, str: []const u8) linksection(cy.Se
     }
 }
 
+/// Bytes to reserve in front of the data of a buffer passed to `allocOwnedStringOrArray`.
+pub const OwnedBufHeaderLen = externalPayloadSize(false) + Astring.BufOffset;
+
+comptime {
+    std.debug.assert(Astring.BufOffset == Array.BufOffset);
+}
+
+/// Like `allocStringInternOrArray` but takes ownership of `buf`, which was allocated by `vm.alloc`.
+/// The data starts after `OwnedBufHeaderLen` bytes so that it becomes the object's buffer without being copied.
+/// A non-ASCII string needs a larger header, so its data is moved within the grown buffer.
+pub fn allocOwnedStringOrArray(self: *cy.VM, buf: []align(@alignOf(HeapObject)) u8) !Value {
+    const data = buf[OwnedBufHeaderLen..];
+    if (data.len <= DefaultStringInternMaxByteLen) {
+        // Small strings are interned.
+        defer self.alloc.free(buf);
+        return allocStringInternOrArray(self, data);
+    }
+    errdefer self.alloc.free(buf);
+    const len: u32 = @intCast(data.len);
+    if (cy.validateUtf8(data)) |charLen| {
+        if (charLen == data.len) {
+            const obj = initExternalObject(self, buf, false);
+            obj.astring = .{
+                .typeId = bt.String,
+                .rc = 1,
+                .headerAndLen = (@as(u32, @intFromEnum(String.Type.astring)) << 30) | len,
+                .bufStart = undefined,
+            };
+            return Value.initNoCycPtr(obj);
+        } else {
+            const ExtraLen = Ustring.BufOffset - Astring.BufOffset;
+            const new = try self.alloc.realloc(buf, buf.len + ExtraLen);
+            std.mem.copyBackwards(u8, new[OwnedBufHeaderLen + ExtraLen..], new[OwnedBufHeaderLen..new.len - ExtraLen]);
+            const obj = initExternalObject(self, new, false);
+            obj.ustring = .{
+                .typeId = bt.String,
+                .rc = 1,
+                .headerAndLen = (@as(u32, @intFromEnum(String.Type.ustring)) << 30) | len,
+                .charLen = @intCast(charLen),
+                .mruIdx = 0,
+                .mruCharIdx = 0,
+                .bufStart = undefined,
+            };
+            return Value.initNoCycPtr(obj);
+        }
+    } else {
+        const obj = initExternalObject(self, buf, false);
+        obj.array = .{
+            .typeId = bt.Array,
+            .rc = 1,
+            .headerAndLen = len,
+            .bufStart = undefined,
+        };
+        return Value.initNoCycPtr(obj);
+    }
+}
+
 pub fn allocAstring(self: *cy.VM, str: []const u8) linksection(cy.Section) !Value {
     const obj = try allocUnsetAstringObject(self, str.len);
     const dst = obj.astring.getSlice();
@@ -1590,6 +1776,14 @@ pub fn allocUnsetUstringObject(self: *cy.VM, len: usize, charLen: u32) linksecti
 }
 
 pub fn allocUstringSlice(self: *cy.VM, slice: []const u8, charLen: u32, parent: ?*HeapObject) !Value {
+    if (parent) |parent_| {
+        if (getParentOffset(slice.ptr, parent_) == null) {
+            // A Ustring slice has no room for a far parent, so the bytes are copied instead.
+            const res = try allocUstring(self, slice, charLen);
+            cy.arc.releaseObject(self, parent_);
+            return res;
+        }
+    }
     const obj = try allocPoolObject(self);
     obj.uslice = .{
         .typeId = bt.String,
@@ -1607,12 +1801,14 @@ pub fn allocUstringSlice(self: *cy.VM, slice: []const u8, charLen: u32, parent:
 pub fn allocAstringSlice(self: *cy.VM, slice: []const u8, parent: *HeapObject) !Value {
     const obj = try allocPoolObject(self);
     log.tracev("{*} {*}", .{parent, slice.ptr});
+    const offset = getParentOffset(slice.ptr, parent);
     obj.aslice = .{
         .typeId = bt.String,
         .rc = 1,
         .headerAndLen = (@as(u32, @intFromEnum(String.Type.aslice)) << 30) | @as(u32, @intCast(slice.len)),
         .buf = slice.ptr,
-        .offset = @intCast(@intFromPtr(slice.ptr) - @intFromPtr(parent)),
+        .offset = offset orelse FarParentOffset,
+        .parent = if (offset == null) parent else null,
     };
     return Value.initNoCycPtr(obj);
 }
@@ -1642,12 +1838,14 @@ pub fn allocArray(vm: *cy.VM, buf: []const u8) !Value {
 
 pub fn allocArraySlice(self: *cy.VM, slice: []const u8, parent: *HeapObject) !Value {
     const obj = try allocPoolObject(self);
+    const offset = getParentOffset(slice.ptr, parent);
     obj.arraySlice = .{
         .typeId = bt.Array,
         .rc = 1,
         .buf = slice.ptr,
         .headerAndLen = 0x80000000 | @as(u32, @intCast(slice.len)),
-        .offset = @intCast(@intFromPtr(slice.ptr) - @intFromPtr(parent)),
+        .offset = offset orelse FarParentOffset,
+        .parent = if (offset == null) parent else null,
     };
     return Value.initNoCycPtr(obj);
 }
@@ -1926,6 +2124,7 @@ pub fn freeObject(vm: *cy.VM, obj: *HeapObject,
                     if (free) {
                         const len = obj.string.len();
                         if (len <= DefaultStringInternMaxByteLen) {
+                            vm.finderCache.invalidate(obj);
 
                             // Check both the key and value to make sure this object is the intern entry.
                             // TODO: Use a flag bit instead of a map query.
@@ -1947,6 +2146,7 @@ pub fn freeObject(vm: *cy.VM, obj: *HeapObject,
                     if (free) {
                         const len = obj.string.len();
                         if (len <= DefaultStringInternMaxByteLen) {
+                            vm.finderCache.invalidate(obj);
                             const key = obj.ustring.getSlice();
                             if (vm.strInterns.get(key)) |val| {
                                 if (val == obj) {
@@ -1996,6 +2196,9 @@ pub fn freeObject(vm: *cy.VM, obj: *HeapObject,
             } else {
                 if (free) {
                     const len = obj.array.len();
+                    if (len <= cy.string.FinderCache.MaxNeedleLen) {
+                        vm.finderCache.invalidate(obj);
+                    }
                     if (len <= MaxPoolObjectArrayByteLen) {
                         freePoolObject(vm, obj);
                     } else {
@@ -2212,7 +2415,7 @@ test "heap internals." {
             try t.eq(@sizeOf(ListIterator), 24);
             try t.eq(@sizeOf(Map), 40);
             try t.eq(@sizeOf(MapIterator), 24);
-            try t.eq(@sizeOf(ArraySlice), 24);
+            try t.eq(@sizeOf(ArraySlice), 32);
             try t.eq(@sizeOf(Pointer), 16);
         }
     }
@@ -2221,7 +2424,11 @@ test "heap internals." {
         try t.eq(@sizeOf(Lambda), 24);
         try t.eq(@sizeOf(Astring), 16);
         try t.eq(@sizeOf(Ustring), 32);
-        try t.eq(@sizeOf(AstringSlice), 24);
+        if (cy.is32Bit) {
+            try t.eq(@sizeOf(AstringSlice), 24);
+        } else {
+            try t.eq(@sizeOf(AstringSlice), 32);
+        }
         if (cy.is32Bit) {
             try t.eq(@sizeOf(UstringSlice), 32);
         } else {
@@ -106,6 +106,12 @@ pub const MockHttpClient = struct {
     retBodyIdx: usize = undefined,
     client: std.http.Client,
 
+    /// Simulated round trip latency applied in `waitRequest`.
+    latencyNs: u64 = 0,
+
+    /// Shared counters when created from a `MockHttpClientFactory`.
+    stats: ?*MockHttpStats = null,
+
     pub fn init(alloc: std.mem.Allocator) MockHttpClient {
         return .{ .client = .{ .allocator = alloc } };
     }
@@ -164,16 +170,29 @@ pub const MockHttpClient = struct {
         _ = ptr;
     }
 
-    fn deinitRequest(_: *anyopaque, req: *Request) void {
+    fn deinitRequest(ptr: *anyopaque, req: *Request) void {
         _ = req;
+        const self: *MockHttpClient = @ptrCast(@alignCast(ptr));
+        if (self.stats) |stats| {
+            _ = @atomicRmw(u32, &stats.numInflight, .Sub, 1, .SeqCst);
+        }
     }
 
-    fn startRequest(_: *anyopaque, req: *Request) anyerror!void {
+    fn startRequest(ptr: *anyopaque, req: *Request) anyerror!void {
         _ = req;
+        const self: *MockHttpClient = @ptrCast(@alignCast(ptr));
+        if (self.stats) |stats| {
+            const inflight = @atomicRmw(u32, &stats.numInflight, .Add, 1, .SeqCst) + 1;
+            _ = @atomicRmw(u32, &stats.maxInflight, .Max, inflight, .SeqCst);
+            _ = @atomicRmw(u32, &stats.numRequests, .Add, 1, .SeqCst);
+        }
     }
 
     fn waitRequest(ptr: *anyopaque, req: *Request) anyerror!void {
         const self: *MockHttpClient = @ptrCast(@alignCast(ptr));
+        if (self.latencyNs > 0) {
+            std.time.sleep(self.latencyNs);
+        }
         if (self.retStatusCode) |code| {
             req.response.status = code;
         } else {
@@ -194,7 +213,417 @@ pub const MockHttpClient = struct {
     }
 };
 
-const Response = struct {
+pub const MockHttpStats = struct {
+    /// Number of connections (clients) opened.
+    numOpens: u32 = 0,
+    numCloses: u32 = 0,
+    numRequests: u32 = 0,
+    numInflight: u32 = 0,
+    maxInflight: u32 = 0,
+};
+
+/// Opens a `MockHttpClient` per pooled connection so that tests can count connection opens.
+pub const MockHttpClientFactory = struct {
+    retStatusCode: ?std.http.Status = null,
+    retBody: []const u8 = "Hello.",
+    latencyNs: u64 = 0,
+    stats: MockHttpStats = .{},
+
+    pub fn iface(self: *MockHttpClientFactory) ClientFactory {
+        return ClientFactory{
+            .ptr = self,
+            .vtable = &.{
+                .open = open,
+                .close = close,
+            },
+        };
+    }
+
+    fn open(ptr: *anyopaque, alloc: std.mem.Allocator) anyerror!HttpClient {
+        const self: *MockHttpClientFactory = @ptrCast(@alignCast(ptr));
+        const client = try alloc.create(MockHttpClient);
+        client.* = MockHttpClient.init(alloc);
+        client.retStatusCode = self.retStatusCode;
+        client.retBody = self.retBody;
+        client.latencyNs = self.latencyNs;
+        client.stats = &self.stats;
+        _ = @atomicRmw(u32, &self.stats.numOpens, .Add, 1, .SeqCst);
+        return client.iface();
+    }
+
+    fn close(ptr: *anyopaque, alloc: std.mem.Allocator, client: HttpClient) void {
+        const self: *MockHttpClientFactory = @ptrCast(@alignCast(ptr));
+        _ = @atomicRmw(u32, &self.stats.numCloses, .Add, 1, .SeqCst);
+        client.deinit();
+        alloc.destroy(@as(*MockHttpClient, @ptrCast(@alignCast(client.ptr))));
+    }
+};
+
+/// Creates the client that backs a single pooled connection.
+pub const ClientFactory = struct {
+    ptr: *anyopaque,
+    vtable: *const VTable,
+
+    const VTable = struct {
+        open: *const fn (ptr: *anyopaque, alloc: std.mem.Allocator) anyerror!HttpClient,
+        close: *const fn (ptr: *anyopaque, alloc: std.mem.Allocator, client: HttpClient) void,
+    };
+
+    pub fn open(self: ClientFactory, alloc: std.mem.Allocator) !HttpClient {
+        return self.vtable.open(self.ptr, alloc);
+    }
+
+    pub fn close(self: ClientFactory, alloc: std.mem.Allocator, client: HttpClient) void {
+        self.vtable.close(self.ptr, alloc, client);
+    }
+};
+
+/// Each pooled connection is a `StdHttpClient` which keeps its socket alive between requests.
+pub const StdHttpClientFactory = struct {
+    dummy: u8 = 0,
+
+    /// The factory is stateless so a single instance is shared.
+    var instance: StdHttpClientFactory = .{};
+
+    pub fn shared() ClientFactory {
+        return instance.iface();
+    }
+
+    pub fn iface(self: *StdHttpClientFactory) ClientFactory {
+        return ClientFactory{
+            .ptr = self,
+            .vtable = &.{
+                .open = open,
+                .close = close,
+            },
+        };
+    }
+
+    fn open(_: *anyopaque, alloc: std.mem.Allocator) anyerror!HttpClient {
+        const client = try alloc.create(StdHttpClient);
+        client.* = StdHttpClient.init(alloc);
+        return client.iface();
+    }
+
+    fn close(_: *anyopaque, alloc: std.mem.Allocator, client: HttpClient) void {
+        client.deinit();
+        alloc.destroy(@as(*StdHttpClient, @ptrCast(@alignCast(client.ptr))));
+    }
+};
+
+/// Keep-alive connections keyed by `host:port`.
+/// A connection is reused by the next request to the same host. Idle connections older than
+/// `idleTimeoutMs` are closed when the host is visited again or on `closeIdle`.
+/// At most `maxPerHost` connections are open per host; further requests wait for one to be released.
+pub const PooledHttpClient = struct {
+    alloc: std.mem.Allocator,
+    factory: ClientFactory,
+    maxPerHost: u32,
+    idleTimeoutMs: i64,
+
+    mutex: std.Thread.Mutex = .{},
+    cond: std.Thread.Condition = .{},
+
+    /// Host pools are heap allocated so they stay put while the map grows with the lock released.
+    hosts: std.StringHashMapUnmanaged(*HostPool) = .{},
+
+    /// Connections serving a request made through `iface`, keyed by the request's client.
+    active: std.AutoHashMapUnmanaged(*std.http.Client, Conn) = .{},
+
+    const HostPool = struct {
+        idle: std.ArrayListUnmanaged(IdleConn) = .{},
+
+        /// Idle and in use connections.
+        numOpen: u32 = 0,
+    };
+
+    const IdleConn = struct {
+        client: HttpClient,
+        lastUsedMs: i64,
+    };
+
+    const Conn = struct {
+        pool: *HostPool,
+        client: HttpClient,
+    };
+
+    pub const Options = struct {
+        maxPerHost: u32 = 6,
+        idleTimeoutMs: i64 = 30 * 1000,
+    };
+
+    pub fn init(alloc: std.mem.Allocator, factory: ClientFactory, opts: Options) PooledHttpClient {
+        return .{
+            .alloc = alloc,
+            .factory = factory,
+            .maxPerHost = @max(opts.maxPerHost, 1),
+            .idleTimeoutMs = opts.idleTimeoutMs,
+        };
+    }
+
+    /// Expects all connections to have been released.
+    pub fn deinit(self: *PooledHttpClient) void {
+        var iter = self.hosts.iterator();
+        while (iter.next()) |e| {
+            const pool = e.value_ptr.*;
+            for (pool.idle.items) |conn| {
+                self.factory.close(self.alloc, conn.client);
+            }
+            pool.idle.deinit(self.alloc);
+            self.alloc.destroy(pool);
+            self.alloc.free(e.key_ptr.*);
+        }
+        self.hosts.deinit(self.alloc);
+        self.active.deinit(self.alloc);
+    }
+
+    /// Each request acquires a pooled connection for its host, and `deinitRequest` releases it.
+    /// This lets URL imports and `fetchUrl` reuse connections through the VM's `HttpClient`.
+    pub fn iface(self: *PooledHttpClient) HttpClient {
+        return HttpClient{
+            .ptr = self,
+            .vtable = &.{
+                .request = ifaceRequest,
+                .deinit = ifaceDeinit,
+                .deinitRequest = ifaceDeinitRequest,
+                .startRequest = ifaceStartRequest,
+                .waitRequest = ifaceWaitRequest,
+                .readAll = ifaceReadAll,
+            },
+        };
+    }
+
+    fn ifaceRequest(ptr: *anyopaque, method: std.http.Method, uri: std.Uri, headers: std.http.Headers) anyerror!Request {
+        const self: *PooledHttpClient = @ptrCast(@alignCast(ptr));
+        var keyBuf: [512]u8 = undefined;
+        const key = try hostKey(&keyBuf, uri);
+
+        const conn = try self.acquire(key);
+        var req = conn.client.request(method, uri, headers) catch |err| {
+            self.discard(conn);
+            return err;
+        };
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.active.put(self.alloc, req.client, conn) catch |err| {
+            conn.client.deinitRequest(&req);
+            self.discardLocked(conn);
+            return err;
+        };
+        return req;
+    }
+
+    fn ifaceDeinit(ptr: *anyopaque) void {
+        const self: *PooledHttpClient = @ptrCast(@alignCast(ptr));
+        self.deinit();
+    }
+
+    fn ifaceDeinitRequest(ptr: *anyopaque, req: *Request) void {
+        const self: *PooledHttpClient = @ptrCast(@alignCast(ptr));
+        self.mutex.lock();
+        const entry = self.active.fetchRemove(req.client);
+        self.mutex.unlock();
+        const conn = entry.?.value;
+        conn.client.deinitRequest(req);
+        self.release(conn);
+    }
+
+    fn ifaceStartRequest(ptr: *anyopaque, req: *Request) anyerror!void {
+        const self: *PooledHttpClient = @ptrCast(@alignCast(ptr));
+        try self.activeClient(req).startRequest(req);
+    }
+
+    fn ifaceWaitRequest(ptr: *anyopaque, req: *Request) anyerror!void {
+        const self: *PooledHttpClient = @ptrCast(@alignCast(ptr));
+        try self.activeClient(req).waitRequest(req);
+    }
+
+    fn ifaceReadAll(ptr: *anyopaque, req: *Request, buf: []u8) anyerror!usize {
+        const self: *PooledHttpClient = @ptrCast(@alignCast(ptr));
+        return self.activeClient(req).readAll(req, buf);
+    }
+
+    fn activeClient(self: *PooledHttpClient, req: *Request) HttpClient {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        return self.active.get(req.client).?.client;
+    }
+
+    /// HTTP GET on a pooled connection, always consumes body.
+    pub fn getOne(self: *PooledHttpClient, url: []const u8) !Response {
+        const uri = try std.Uri.parse(url);
+        var keyBuf: [512]u8 = undefined;
+        const key = try hostKey(&keyBuf, uri);
+
+        const conn = try self.acquire(key);
+        const res = get(self.alloc, conn.client, url) catch |err| {
+            // The connection state is unknown after a failed request.
+            self.discard(conn);
+            return err;
+        };
+        self.release(conn);
+        return res;
+    }
+
+    /// Fetches `urls` concurrently. Requests to the same host share up to `maxPerHost` connections
+    /// and reuse them back to back. Results are in the same order as `urls`.
+    /// Caller owns the returned slice and each response body.
+    pub fn getMany(self: *PooledHttpClient, urls: []const []const u8) ![]GetResult {
+        const results = try self.alloc.alloc(GetResult, urls.len);
+        errdefer self.alloc.free(results);
+        if (urls.len == 0) {
+            return results;
+        }
+
+        var ctx = GetManyContext{
+            .pool = self,
+            .urls = urls,
+            .results = results,
+        };
+
+        const maxWorkers = 64;
+        const numWorkers = @min(urls.len, maxWorkers);
+        var threads: [maxWorkers]std.Thread = undefined;
+        var numSpawned: usize = 0;
+        defer {
+            for (threads[0..numSpawned]) |thread| {
+                thread.join();
+            }
+        }
+        // The calling thread also works so a failed spawn only reduces concurrency.
+        while (numSpawned < numWorkers - 1) : (numSpawned += 1) {
+            threads[numSpawned] = std.Thread.spawn(.{}, getManyWorker, .{&ctx}) catch break;
+        }
+        getManyWorker(&ctx);
+        return results;
+    }
+
+    /// Closes idle connections that have exceeded the idle timeout.
+    pub fn closeIdle(self: *PooledHttpClient) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const now = std.time.milliTimestamp();
+        var iter = self.hosts.valueIterator();
+        while (iter.next()) |pool| {
+            self.pruneIdle(pool.*, now);
+        }
+    }
+
+    fn pruneIdle(self: *PooledHttpClient, pool: *HostPool, now: i64) void {
+        var i: usize = 0;
+        while (i < pool.idle.items.len) {
+            const conn = pool.idle.items[i];
+            if (now - conn.lastUsedMs >= self.idleTimeoutMs) {
+                self.factory.close(self.alloc, conn.client);
+                _ = pool.idle.swapRemove(i);
+                pool.numOpen -= 1;
+            } else {
+                i += 1;
+            }
+        }
+    }
+
+    fn getHostPool(self: *PooledHttpClient, key: []const u8) !*HostPool {
+        const res = try self.hosts.getOrPut(self.alloc, key);
+        if (!res.found_existing) {
+            errdefer self.hosts.removeByPtr(res.key_ptr);
+            const pool = try self.alloc.create(HostPool);
+            errdefer self.alloc.destroy(pool);
+            pool.* = .{};
+            res.key_ptr.* = try self.alloc.dupe(u8, key);
+            res.value_ptr.* = pool;
+        }
+        return res.value_ptr.*;
+    }
+
+    fn acquire(self: *PooledHttpClient, key: []const u8) !Conn {
+        self.mutex.lock();
+        const pool = self.getHostPool(key) catch |err| {
+            self.mutex.unlock();
+            return err;
+        };
+        while (true) {
+            self.pruneIdle(pool, std.time.milliTimestamp());
+            if (pool.idle.popOrNull()) |conn| {
+                self.mutex.unlock();
+                return .{ .pool = pool, .client = conn.client };
+            }
+            if (pool.numOpen < self.maxPerHost) {
+                pool.numOpen += 1;
+                self.mutex.unlock();
+                const client = self.factory.open(self.alloc) catch |err| {
+                    self.mutex.lock();
+                    pool.numOpen -= 1;
+                    self.cond.signal();
+                    self.mutex.unlock();
+                    return err;
+                };
+                return .{ .pool = pool, .client = client };
+            }
+            self.cond.wait(&self.mutex);
+        }
+    }
+
+    fn release(self: *PooledHttpClient, conn: Conn) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        conn.pool.idle.append(self.alloc, .{
+            .client = conn.client,
+            .lastUsedMs = std.time.milliTimestamp(),
+        }) catch {
+            self.factory.close(self.alloc, conn.client);
+            conn.pool.numOpen -= 1;
+        };
+        self.cond.signal();
+    }
+
+    fn discard(self: *PooledHttpClient, conn: Conn) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.discardLocked(conn);
+    }
+
+    fn discardLocked(self: *PooledHttpClient, conn: Conn) void {
+        self.factory.close(self.alloc, conn.client);
+        conn.pool.numOpen -= 1;
+        self.cond.signal();
+    }
+};
+
+pub const GetResult = union(enum) {
+    ok: Response,
+    err: anyerror,
+};
+
+const GetManyContext = struct {
+    pool: *PooledHttpClient,
+    urls: []const []const u8,
+    results: []GetResult,
+    next: usize = 0,
+};
+
+fn getManyWorker(ctx: *GetManyContext) void {
+    while (true) {
+        const idx = @atomicRmw(usize, &ctx.next, .Add, 1, .SeqCst);
+        if (idx >= ctx.urls.len) {
+            return;
+        }
+        if (ctx.pool.getOne(ctx.urls[idx])) |res| {
+            ctx.results[idx] = .{ .ok = res };
+        } else |err| {
+            ctx.results[idx] = .{ .err = err };
+        }
+    }
+}
+
+/// Formats the pool key `host:port` with the scheme's default port.
+fn hostKey(buf: []u8, uri: std.Uri) ![]const u8 {
+    const host = uri.host orelse return error.UriMissingHost;
+    const port: u16 = uri.port orelse if (std.mem.eql(u8, uri.scheme, "https")) 443 else 80;
+    return std.fmt.bufPrint(buf, "{s}:{}", .{ host, port });
+}
+
+pub const Response = struct {
     status: std.http.Status,
     body: []const u8,
 };
@@ -203,7 +632,7 @@ const Response = struct {
 pub fn get(alloc: std.mem.Allocator, client: HttpClient, url: []const u8) !Response {
     const uri = try std.Uri.parse(url);
     var req = try client.request(.GET, uri, .{ .allocator = alloc });
-    defer req.deinit();
+    defer client.deinitRequest(&req);
 
     try client.startRequest(&req);
     try client.waitRequest(&req);
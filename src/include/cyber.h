@@ -431,14 +431,44 @@ void csListSet(CsVM* vm, CsValue list, size_t idx, CsValue val);
 void csListAppend(CsVM* vm, CsValue list, CsValue val);
 void csListInsert(CsVM* vm, CsValue list, size_t idx, CsValue val);
 
+// Copies up to `len` elements starting at `start` into `out` and returns the number copied.
+// Each copied element is retained +1 like `csListGet`.
+size_t csListGetRange(CsVM* vm, CsValue list, size_t start, size_t len, CsValue* out);
+
+// Appends `len` elements with a single capacity check. Each element is retained.
+void csListAppendN(CsVM* vm, CsValue list, const CsValue* vals, size_t len);
+
+// Creates a list of floats/integers directly from a C array. No per-element retain is needed.
+// int64_t is downcasted to a 48-bit int.
+CsValue csNewListFromF64s(CsVM* vm, const double* vals, size_t len);
+CsValue csNewListFromI64s(CsVM* vm, const int64_t* vals, size_t len);
+
 // Maps.
-// size_t csMapSize(CsValue map);
-// bool csMapContains(CsValue map, CsValue key);
-// bool csMapContainsStringKey(CsValue map, CsStr key);
-// CsValue csMapGet(CsVM* vm, CsValue map, CsValue key);
-// CsValue csMapGetStringKey(CsVM* vm, CsValue map, CsStr key);
-// void csMapSet(CsVM* vm, CsValue map, CsValue key, CsValue val);
-// void csMapSetStringKey(CsVM* vm, CsValue map, CsStr key, CsValue val);
+size_t csMapSize(CsValue map);
+bool csMapContains(CsValue map, CsValue key);
+bool csMapContainsStringKey(CsValue map, CsStr key);
+
+// Returns the value retained +1, or `none` if the key does not exist.
+CsValue csMapGet(CsVM* vm, CsValue map, CsValue key);
+CsValue csMapGetStringKey(CsVM* vm, CsValue map, CsStr key);
+
+// The key and value are retained by the map.
+void csMapSet(CsVM* vm, CsValue map, CsValue key, CsValue val);
+void csMapSetStringKey(CsVM* vm, CsValue map, CsStr key, CsValue val);
+
+// Iterates a map's entries. Start with `*idx = 0` and call until it returns false.
+// `outKey` and `outVal` are borrowed and are only valid while the entry is in the map.
+// The map must not be modified during iteration.
+bool csMapIter(CsValue map, uint32_t* idx, CsValue* outKey, CsValue* outVal);
+
+// Strings and arrays.
+// Returns a borrowed view into the string's (or array's) bytes without copying.
+// The view is valid as long as the value is alive. It is not null terminated.
+CsStr csAsStringView(CsValue str);
+CsStr csAsArrayView(CsValue arr);
+
+// Returns the number of UTF-8 code points in the string.
+uint32_t csStringCharLen(CsValue str);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -56,6 +56,10 @@ pub const StmtCode = enum(u8) {
     /// precedes a set* stmt.
     opSet,
 
+    /// Fused read-modify-write of a map entry.
+    /// The unfused stmt is kept in `slow` and is generated as the fallback path.
+    mapUpdate,
+
     set,
     setLocal,
     setCaptured,
@@ -146,6 +150,9 @@ pub const BlockExpr = struct {
 pub const Switch = struct {
     expr: Loc,
     numCases: u8,
+
+    /// The switch expr is statically known to only equal identical value bits.
+    bitEq: bool = false,
 };
 
 const Loc = u32;
@@ -160,6 +167,10 @@ pub const SwitchCase = struct {
 pub const DestructureElems = struct {
     numLocals: u8,
     right: u32,
+
+    /// `right` is a hidden local that isn't read after the destructure,
+    /// so the elements can be moved out instead of retained.
+    moveRight: bool,
 };
 
 pub const WhileOptStmt = struct {
@@ -372,6 +383,9 @@ pub const BinOp = struct {
     rightT: TypeId,
     op: cy.BinaryExprOp,
     right: u32,
+
+    /// For `==` and `!=`, an operand is statically known to only equal identical value bits.
+    bitEq: bool = false,
 };
 
 pub const Set = union {
@@ -393,6 +407,19 @@ pub const SetGeneric = struct {
     right: u32,
 };
 
+pub const MapUpdate = struct {
+    op: cy.BinaryExprOp,
+    recv: u32,
+    index: u32,
+    right: u32,
+
+    /// Initial value for a missing key. NullId if missing keys are left to `slow`.
+    default: u32,
+
+    /// The unfused stmt.
+    slow: u32,
+};
+
 pub const SetIndex = struct {
     recvT: TypeId,
     index: u32,
@@ -479,6 +506,8 @@ pub const String = struct {
 
 pub const StringTemplate = struct {
     numExprs: u8,
+    /// Every expression has a static string type.
+    allStrs: bool,
     args: u32,
 };
 
@@ -514,6 +543,7 @@ pub fn StmtData(comptime code: StmtCode) type {
         .forIterStmt => ForIterStmt,
         .forRangeStmt => ForRangeStmt,
         .setLocalType => SetLocalType,
+        .mapUpdate => MapUpdate,
         .setIndex,
         .setCallObjSymTern,
         .setLocal,
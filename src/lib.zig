@@ -566,6 +566,213 @@ test "List ops." {
     try t.eq(c.listLen(list), 5);
 }
 
+export fn csListGetRange(vm: *cy.VM, list: Value, start: usize, len: usize, out: [*]Value) usize {
+    const items = list.asHeapObject().list.items();
+    if (start >= items.len) {
+        return 0;
+    }
+    const n = @min(len, items.len - start);
+    const src = items[start..start+n];
+    for (src, 0..) |elem, i| {
+        vm.retain(elem);
+        out[i] = elem;
+    }
+    return n;
+}
+
+export fn csListAppendN(vm: *cy.VM, list: Value, vals: [*]const Value, len: usize) void {
+    const elems = vals[0..len];
+    for (elems) |elem| {
+        vm.retain(elem);
+    }
+    list.asHeapObject().list.getList().appendSlice(vm.alloc, elems) catch cy.fatal();
+}
+
+export fn csNewListFromF64s(vm: *cy.VM, vals: [*]const f64, len: usize) Value {
+    const res = vm.allocEmptyList() catch fatal();
+    const inner = res.asHeapObject().list.getList();
+    inner.ensureTotalCapacityPrecise(vm.alloc, len) catch fatal();
+    for (vals[0..len], 0..) |val, i| {
+        inner.buf[i] = Value.initF64(val);
+    }
+    inner.len = len;
+    return res;
+}
+
+export fn csNewListFromI64s(vm: *cy.VM, vals: [*]const i64, len: usize) Value {
+    const res = vm.allocEmptyList() catch fatal();
+    const inner = res.asHeapObject().list.getList();
+    inner.ensureTotalCapacityPrecise(vm.alloc, len) catch fatal();
+    for (vals[0..len], 0..) |val, i| {
+        inner.buf[i] = Value.initInt(@truncate(val));
+    }
+    inner.len = len;
+    return res;
+}
+
+test "List bulk ops." {
+    const vm = c.create();
+    defer c.destroy(vm);
+
+    const floats = [_]f64{ 1.5, 2.5, 3.5 };
+    const list = c.newListFromF64s(vm, &floats, floats.len);
+    defer c.release(vm, list);
+    try t.eq(c.listLen(list), 3);
+    try t.eq(c.listCap(list), 3);
+    try t.eq(c.asFloat(c.listGet(vm, list, 2)), 3.5);
+
+    const ints = [_]i64{ 10, 20, 30, 40 };
+    const ilist = c.newListFromI64s(vm, &ints, ints.len);
+    defer c.release(vm, ilist);
+    try t.eq(c.listLen(ilist), 4);
+    try t.eq(c.asInteger(c.listGet(vm, ilist, 3)), 40);
+
+    // Append many.
+    c.listAppendN(vm, list, &[_]c.Value{ c.integer(1), c.integer(2) }, 2);
+    try t.eq(c.listLen(list), 5);
+    try t.eq(c.asInteger(c.listGet(vm, list, 4)), 2);
+
+    // Get range.
+    var out: [8]c.Value = undefined;
+    var n = c.listGetRange(vm, list, 1, 3, &out);
+    try t.eq(n, 3);
+    try t.eq(c.asFloat(out[0]), 2.5);
+    try t.eq(c.asFloat(out[1]), 3.5);
+    try t.eq(c.asInteger(out[2]), 1);
+
+    // Range is clamped to the list's length.
+    n = c.listGetRange(vm, list, 3, 8, &out);
+    try t.eq(n, 2);
+    n = c.listGetRange(vm, list, 5, 8, &out);
+    try t.eq(n, 0);
+}
+
+export fn csMapSize(map: Value) usize {
+    return map.asHeapObject().map.inner.size;
+}
+
+export fn csMapContains(map: Value, key: Value) bool {
+    return map.asHeapObject().map.map().contains(key);
+}
+
+export fn csMapContainsStringKey(map: Value, key: c.Str) bool {
+    return map.asHeapObject().map.map().getByString(c.strSlice(key)) != null;
+}
+
+export fn csMapGet(vm: *cy.VM, map: Value, key: Value) Value {
+    if (map.asHeapObject().map.map().get(key)) |val| {
+        vm.retain(val);
+        return val;
+    }
+    return Value.None;
+}
+
+export fn csMapGetStringKey(vm: *cy.VM, map: Value, key: c.Str) Value {
+    if (map.asHeapObject().map.map().getByString(c.strSlice(key))) |val| {
+        vm.retain(val);
+        return val;
+    }
+    return Value.None;
+}
+
+export fn csMapSet(vm: *cy.VM, map: Value, key: Value, val: Value) void {
+    map.asHeapObject().map.set(vm, key, val) catch fatal();
+}
+
+export fn csMapSetStringKey(vm: *cy.VM, map: Value, key: c.Str, val: Value) void {
+    const keyv = vm.allocStringInternOrArray(c.strSlice(key)) catch fatal();
+    vm.retain(val);
+    map.asHeapObject().map.setConsume(vm, keyv, val) catch fatal();
+}
+
+export fn csMapIter(map: Value, idx: *u32, outKey: *Value, outVal: *Value) bool {
+    if (map.asHeapObject().map.map().next(idx)) |entry| {
+        outKey.* = entry.key;
+        outVal.* = entry.value;
+        return true;
+    }
+    return false;
+}
+
+test "Map ops." {
+    const vm = c.create();
+    defer c.destroy(vm);
+
+    const map = c.newEmptyMap(vm);
+    defer c.release(vm, map);
+    try t.eq(c.mapSize(map), 0);
+
+    // Set.
+    c.mapSet(vm, map, c.integer(1), c.float(10));
+    c.mapSetStringKey(vm, map, c.initStr("foo"), c.integer(123));
+    try t.eq(c.mapSize(map), 2);
+
+    // Overwrite string key.
+    c.mapSetStringKey(vm, map, c.initStr("foo"), c.integer(234));
+    try t.eq(c.mapSize(map), 2);
+
+    // Contains.
+    try t.eq(c.mapContains(map, c.integer(1)), true);
+    try t.eq(c.mapContains(map, c.integer(2)), false);
+    try t.eq(c.mapContainsStringKey(map, c.initStr("foo")), true);
+    try t.eq(c.mapContainsStringKey(map, c.initStr("bar")), false);
+
+    // Get.
+    try t.eq(c.asFloat(c.mapGet(vm, map, c.integer(1))), 10);
+    try t.eq(c.asInteger(c.mapGetStringKey(vm, map, c.initStr("foo"))), 234);
+    try t.eq(c.getTypeId(c.mapGet(vm, map, c.integer(2))), bt.None);
+
+    // String value key matches the string key variants.
+    const key = c.newString(vm, c.initStr("foo"));
+    defer c.release(vm, key);
+    try t.eq(c.mapContains(map, key), true);
+
+    // Iterate.
+    var idx: u32 = 0;
+    var k: c.Value = undefined;
+    var v: c.Value = undefined;
+    var count: u32 = 0;
+    while (c.mapIter(map, &idx, &k, &v)) {
+        count += 1;
+        if (c.getTypeId(k) == bt.String) {
+            try t.eqStr(c.strSlice(c.asStringView(k)), "foo");
+            try t.eq(c.asInteger(v), 234);
+        } else {
+            try t.eq(c.asInteger(k), 1);
+            try t.eq(c.asFloat(v), 10);
+        }
+    }
+    try t.eq(count, 2);
+}
+
+export fn csAsStringView(str: Value) c.Str {
+    return c.initStr(str.asString());
+}
+
+export fn csAsArrayView(arr: Value) c.Str {
+    return c.initStr(arr.asArray());
+}
+
+export fn csStringCharLen(str: Value) u32 {
+    return str.asHeapObject().string.getCharLen();
+}
+
+test "String views." {
+    const vm = c.create();
+    defer c.destroy(vm);
+
+    const astr = c.newString(vm, c.initStr("abcdefghijklmnopqrstuvwxyz0123456789"));
+    defer c.release(vm, astr);
+    const view = c.asStringView(astr);
+    try t.eqStr(c.strSlice(view), "abcdefghijklmnopqrstuvwxyz0123456789");
+    try t.eq(c.stringCharLen(astr), 36);
+
+    const ustr = c.newString(vm, c.initStr("abc🦊xyz"));
+    defer c.release(vm, ustr);
+    try t.eqStr(c.strSlice(c.asStringView(ustr)), "abc🦊xyz");
+    try t.eq(c.stringCharLen(ustr), 7);
+}
+
 export fn csGetFullVersion() c.Str {
     return c.initStr(build_options.full_version.ptr[0..build_options.full_version.len]);
 }
@@ -6,6 +6,7 @@ const log = cy.log.scoped(.main);
 const cli = @import("cli.zig");
 const build_options = @import("build_options");
 const fmt = @import("fmt.zig");
+const test_runner = @import("test_runner.zig");
 comptime {
     const lib = @import("lib.zig");
     std.testing.refAllDecls(lib);
@@ -16,6 +17,8 @@ var reload = false;
 var backend: cy.Backend = .vm;
 var dumpStats = false; // Only for trace build.
 var pc: ?u32 = null;
+var testJobs: ?u32 = null;
+var testTiming = false;
 
 const CP_UTF8 = 65001;
 var prevWinConsoleOutputCP: u32 = undefined;
@@ -59,6 +62,16 @@ pub fn main() !void {
                 backend = .tcc;
             } else if (std.mem.eql(u8, arg, "-jit")) {
                 backend = .jit;
+            } else if (cmd == .@"test" and std.mem.eql(u8, arg, "--jobs")) {
+                i += 1;
+                if (i < args.len) {
+                    testJobs = try std.fmt.parseInt(u32, args[i], 10);
+                } else {
+                    std.debug.print("Missing jobs arg.\n", .{});
+                    exit(1);
+                }
+            } else if (cmd == .@"test" and std.mem.eql(u8, arg, "--time")) {
+                testTiming = true;
             } else if (std.mem.eql(u8, arg, "-pc")) {
                 i += 1;
                 if (i < args.len) {
@@ -84,6 +97,10 @@ pub fn main() !void {
                     cmd = .version;
                 } else if (std.mem.eql(u8, arg, "help")) {
                     cmd = .help;
+                } else if (std.mem.eql(u8, arg, "test")) {
+                    cmd = .@"test";
+                } else if (std.mem.eql(u8, arg, "repl")) {
+                    cmd = .repl;
                 } else {
                     cmd = .eval;
                     if (arg0 == null) {
@@ -94,7 +111,9 @@ pub fn main() !void {
             } else {
                 if (arg0 == null) {
                     arg0 = arg;
-                    break;
+                    if (cmd != .@"test") {
+                        break;
+                    }
                 }
             }
         }
@@ -115,6 +134,18 @@ pub fn main() !void {
                 return error.MissingFilePath;
             }
         },
+        .repl => {
+            try repl(alloc);
+        },
+        .@"test" => {
+            const numFailed = try test_runner.run(alloc, arg0 orelse "test", .{
+                .jobs = testJobs,
+                .timing = testTiming,
+            });
+            if (numFailed > 0) {
+                exit(1);
+            }
+        },
         .help => {
             help();
         },
@@ -137,6 +168,8 @@ fn exit(code: u8) noreturn {
 const Command = enum {
     eval,
     compile,
+    repl,
+    @"test",
     help,
     version,
     none,
@@ -231,6 +264,125 @@ fn evalPath(alloc: std.mem.Allocator, path: []const u8) !void {
     }
 }
 
+/// Reads statements from stdin and evaluates them against one VM.
+/// Each input is compiled as a new chunk that sees the vars, funcs and types declared by previous inputs.
+/// The value of a trailing expression is printed unless it's `none`.
+fn repl(alloc: std.mem.Allocator) !void {
+    cy.verbose = verbose;
+
+    try vm.init(alloc);
+    cli.setupVMForCLI(@ptrCast(&vm));
+    defer vm.deinit(false);
+
+    const stdin = std.io.getStdIn();
+    const stdout = std.io.getStdOut().writer();
+    const interactive = stdin.isTty();
+    if (interactive) {
+        try stdout.print("Cyber {s} REPL. Press Ctrl-D to exit.\n", .{build_options.version});
+    }
+
+    var br = std.io.bufferedReader(stdin.reader());
+    const r = br.reader();
+
+    var input: std.ArrayListUnmanaged(u8) = .{};
+    defer input.deinit(alloc);
+    var line: std.ArrayListUnmanaged(u8) = .{};
+    defer line.deinit(alloc);
+
+    while (true) {
+        if (interactive) {
+            try stdout.writeAll(if (input.items.len == 0) "> " else "| ");
+        }
+        line.clearRetainingCapacity();
+        var eof = false;
+        r.streamUntilDelimiter(line.writer(alloc), '\n', null) catch |err| {
+            if (err != error.EndOfStream) {
+                return err;
+            }
+            eof = true;
+        };
+        if (line.items.len > 0 and line.items[line.items.len-1] == '\r') {
+            line.items.len -= 1;
+        }
+
+        if (input.items.len > 0) {
+            try input.append(alloc, '\n');
+        }
+        try input.appendSlice(alloc, line.items);
+
+        if (!eof and try needsMoreInput(alloc, input.items)) {
+            continue;
+        }
+        if (std.mem.trim(u8, input.items, " \t\n").len > 0) {
+            try evalReplInput(alloc, input.items);
+        }
+        input.clearRetainingCapacity();
+
+        if (eof) {
+            if (interactive) {
+                try stdout.writeAll("\n");
+            }
+            break;
+        }
+    }
+}
+
+/// Returns whether the REPL should keep reading lines before evaluating `input`.
+/// A parse error at the end of the input means the last statement is incomplete. eg. `if a:`
+/// Once a block has an indented line, it continues until an empty line.
+fn needsMoreInput(alloc: std.mem.Allocator, input: []const u8) !bool {
+    const lastStart = if (std.mem.lastIndexOfScalar(u8, input, '\n')) |idx| idx + 1 else 0;
+    const last = input[lastStart..];
+    if (std.mem.trim(u8, last, " \t").len == 0) {
+        return false;
+    }
+    if (lastStart > 0 and (last[0] == ' ' or last[0] == '\t')) {
+        return true;
+    }
+
+    // Incomplete input is expected here, so don't dump parse errors.
+    const prevSilent = cy.silentError;
+    cy.silentError = true;
+    defer cy.silentError = prevSilent;
+
+    var parser = cy.Parser.init(alloc);
+    defer parser.deinit();
+    const res = try parser.parse(input);
+    if (!res.has_error or res.isTokenError) {
+        return false;
+    }
+    return parser.last_err_pos >= std.mem.trimRight(u8, input, " \t").len;
+}
+
+fn evalReplInput(alloc: std.mem.Allocator, src: []const u8) !void {
+    const res = vm.evalRepl(src, .{
+        .enableFileModules = true,
+        .reload = reload,
+    }) catch |err| {
+        switch (err) {
+            error.Panic,
+            error.TokenError,
+            error.ParseError,
+            error.CompileError => {
+                if (!cy.silentError) {
+                    const report = try vm.allocLastErrorReport();
+                    defer alloc.free(report);
+                    cy.rt.writeStderr(report);
+                }
+                return;
+            },
+            else => {
+                return err;
+            },
+        }
+    };
+    defer cy.arc.release(&vm, res);
+    if (!res.isNone()) {
+        const str = try vm.getOrBufPrintValueStr(&cy.tempBuf, res);
+        cy.rt.print(&vm, str);
+    }
+}
+
 fn help() void {
     std.debug.print(
         \\Cyber {s}
@@ -240,6 +392,8 @@ fn help() void {
         \\Commands:
         \\  cyber [source]          Compile and run.
         \\  cyber compile [source]  Compile and dump the code.
+        \\  cyber repl              Start an interactive session.
+        \\  cyber test [dir?]       Run `*.cy` test files in parallel. Defaults to `test`.
         \\  cyber help              Print usage.
         \\  cyber version           Print version number.
         \\
@@ -260,6 +414,10 @@ fn help() void {
         \\`cyber compile` options:
         \\  -pc     Next arg is the pc to dump detailed bytecode at.
         \\
+        \\`cyber test` options:
+        \\  --jobs  Next arg is the number of tests to run at once. Defaults to the number of CPUs. `--jobs 1` runs them sequentially.
+        \\  --time  Print the duration of each test.
+        \\
     , .{build_options.version});
 }
 
@@ -37,6 +37,13 @@ pub const ValueMap = struct {
         return null;
     }
 
+    pub fn getPtr(self: ValueMap, key: cy.Value) linksection(cy.Section) ?*cy.Value {
+        if (self.getIndex(key)) |idx| {
+            return &self.entries.?[idx].value;
+        }
+        return null;
+    }
+
     pub fn getByString(self: ValueMap, key: []const u8) linksection(cy.Section) ?cy.Value {
         @setRuntimeSafety(debug);
         if (self.getIndexByString(key)) |idx| {
@@ -155,10 +162,25 @@ pub const ValueMap = struct {
             if (obj.getTypeId() == bt.String) {
                 return std.hash.Wyhash.hash(0, obj.string.getSlice());
             }
+        } else if (key.isSymbol() or key.isEnum()) {
+            // Symbols and enum tags are only equal if their payload bits are equal.
+            return mixBits(key.val);
         }
         return std.hash.Wyhash.hash(0, std.mem.asBytes(&key.val));
     }
 
+    /// Finalizer from MurmurHash3. Spreads the small payload ids across the low bits used for
+    /// the slot index and the high bits used for the fingerprint.
+    inline fn mixBits(val: u64) u64 {
+        var h = val;
+        h ^= h >> 33;
+        h *%= 0xff51afd7ed558ccd;
+        h ^= h >> 33;
+        h *%= 0xc4ceb9fe1a85ec53;
+        h ^= h >> 33;
+        return h;
+    }
+
     fn stringKeyEqual(a: []const u8, b: cy.Value) bool {
         if (!b.isPointer()) {
             return false;
@@ -96,6 +96,13 @@ pub const Parser = struct {
 
     inObjectDecl: bool,
 
+    /// Number of statement bodies (`if`, `for`, etc.) that enclose the current statement.
+    bodyDepth: u32,
+
+    /// Declares `var` statements at the root as static vars so that they persist across inputs.
+    /// Used by the REPL. Unlike `var .name`, their initializers run in statement order from the main block.
+    staticRootVars: bool,
+
     /// Whether to parse and accumulate comment tokens in `comments`.
     parseComments: bool,
     comments: std.ArrayListUnmanaged(cy.IndexSlice(u32)),
@@ -131,6 +138,8 @@ pub const Parser = struct {
             .tokenizeOpts = .{},
             .staticDecls = .{},
             .inObjectDecl = false,
+            .bodyDepth = 0,
+            .staticRootVars = false,
             .parseComments = false,
             .comments = .{},
         };
@@ -230,6 +239,7 @@ pub const Parser = struct {
         self.nodes.clearRetainingCapacity();
         self.blockStack.clearRetainingCapacity();
         self.cur_indent = 0;
+        self.bodyDepth = 0;
 
         const root_id = try self.pushNode(.root, 0);
 
@@ -304,6 +314,9 @@ pub const Parser = struct {
     }
 
     fn parseSingleOrIndentedBodyStmts(self: *Parser) !FirstLastStmt {
+        self.bodyDepth += 1;
+        defer self.bodyDepth -= 1;
+
         var token = self.peekToken();
         if (token.tag() != .new_line) {
             // Parse single statement only.
@@ -3101,6 +3114,10 @@ pub const Parser = struct {
         }
     }
 
+    fn isStaticRootVar(self: *Parser) bool {
+        return self.staticRootVars and self.blockStack.items.len == 1 and self.bodyDepth == 0;
+    }
+
     fn parseVarDecl(self: *Parser, modifierHead: cy.NodeId, typed: bool) !cy.NodeId {
         const start = self.next_pos;
         self.advanceToken();
@@ -3115,7 +3132,8 @@ pub const Parser = struct {
             return self.reportParseError("Expected local name identifier.", &.{});
         };
         const hasNamePath = self.nodes.items[name].next != cy.NullId;
-        const isStatic = hasNamePath or root;
+        const replRoot = !hasNamePath and !root and self.isStaticRootVar();
+        const isStatic = hasNamePath or root or replRoot;
 
         var typeSpecHead: cy.NodeId = cy.NullId;
         if (typed) {
@@ -3165,6 +3183,7 @@ pub const Parser = struct {
                     .right = right,
                     .typed = typed,
                     .root = root,
+                    .replRoot = replRoot,
                 },
             };
             try self.staticDecls.append(self.alloc, .{
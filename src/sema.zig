@@ -59,6 +59,10 @@ pub const LocalVar = struct {
     /// Last sub-block that mutated the dynamic var.
     dynamicLastMutBlockId: BlockId,
 
+    /// Type proven by a runtime cast of a `dynamic` or `any` var. `NullId` if not narrowed.
+    /// A narrowed var is read with this static type until it's reassigned or the narrowing block ends.
+    narrowT: TypeId = cy.NullId,
+
     /// Local register offset assigned to this var.
     /// Locals are relative to the stack frame's start position.
     local: RegisterId = undefined,
@@ -78,10 +82,15 @@ pub const LocalVar = struct {
             /// If declaration has an initializer.
             hasInit: bool,
 
-            /// Currently a captured var always needs to be lifted.
-            /// In the future, the concept of a immutable variable could change this.
+            /// A captured var is lifted into a box when it's captured.
+            /// If it's never reassigned, it's lowered again once its block ends
+            /// and closures copy the value instead.
             lifted: bool,
 
+            /// Whether the var can change after it's initialized.
+            /// Also set for `self` when its fields are captured since the closure reads through the box.
+            reassigned: bool,
+
             /// If var is hidden, user code can not reference it.
             hidden: bool,
 
@@ -258,6 +267,21 @@ pub const Proc = struct {
 
     nodeId: cy.NodeId,
 
+    /// Number of `coyield` exprs in the body and how many of them are statements outside of a try block.
+    /// Used to determine the `YieldKind` of a static function.
+    numYields: u32 = 0,
+    numStmtYields: u32 = 0,
+
+    /// Whether a static call that can yield or any dynamic call is in the body.
+    hasYieldingCall: bool = false,
+
+    /// Current try block depth.
+    tryDepth: u32 = 0,
+
+    /// Depth of subexpressions that can be skipped at runtime, such as the right side of `and`.
+    /// Casts inside them don't narrow locals.
+    condExprDepth: u32 = 0,
+
     pub fn init(nodeId: cy.NodeId, func: ?*cy.Func, firstBlockId: BlockId, isStaticFuncBlock: bool, varStart: u32) Proc {
         return .{
             .nameToVar = .{},
@@ -314,6 +338,9 @@ pub fn semaStmt(c: *cy.Chunk, nodeId: cy.NodeId) !void {
         .exprStmt => {
             const returnMain = node.head.exprStmt.isLastRootStmt;
             _ = try c.ir.pushStmt(c.alloc, .exprStmt, nodeId, .{ .isBlockResult = returnMain });
+            if (c.nodes[node.head.exprStmt.child].node_t == .coyield and c.proc().tryDepth == 0) {
+                c.proc().numStmtYields += 1;
+            }
             _ = try c.semaExpr(node.head.exprStmt.child, .{});
         },
         .breakStmt => {
@@ -339,36 +366,63 @@ pub fn semaStmt(c: *cy.Chunk, nodeId: cy.NodeId) !void {
                 }
             }
 
+            const leftId = node.head.opAssignStmt.left;
+            const mapUpdate = try semaMapUpdate(c, nodeId, leftId, op, leftId, node.head.opAssignStmt.right);
+
             const irIdx = try c.ir.pushStmt(c.alloc, .opSet, nodeId, .{ .op = op });
 
-            const leftId = node.head.opAssignStmt.left;
             try assignStmt(c, nodeId, leftId, nodeId, .{ .rhsOpAssignBinExpr = true });
 
             // Reset `opSet`'s next since pushed statements are appended to the top StmtBlock.
             c.ir.setStmtNext(irIdx, cy.NullId);
             c.ir.stmtBlockStack.items[c.ir.stmtBlockStack.items.len-1].last = irIdx;
+
+            if (mapUpdate) |updateIdx| {
+                endMapUpdate(c, updateIdx, irIdx);
+            }
         },
         .assign_stmt => {
-            try assignStmt(c, nodeId, node.head.left_right.left, node.head.left_right.right, .{});
+            const leftId = node.head.left_right.left;
+            const rightId = node.head.left_right.right;
+            var mapUpdate: ?u32 = null;
+            const right = c.nodes[rightId];
+            if (right.node_t == .binExpr) {
+                mapUpdate = try semaMapUpdate(c, nodeId, leftId, right.head.binExpr.op, right.head.binExpr.left, right.head.binExpr.right);
+            }
+
+            const irIdx: u32 = @intCast(c.ir.buf.items.len);
+            try assignStmt(c, nodeId, leftId, rightId, .{});
+
+            if (mapUpdate) |updateIdx| {
+                endMapUpdate(c, updateIdx, irIdx);
+            }
         },
         .hostObjectDecl,
         .objectDecl,
         .pass_stmt,
         .hostVarDecl,
         .hostFuncDecl,
-        .staticDecl,
         .typeAliasDecl,
         .enumDecl,
         .funcDecl,
         .funcDeclInit => {
             // Nop.
         },
+        .staticDecl => {
+            if (node.head.staticDecl.replRoot) {
+                try replRootVarDecl(c, nodeId);
+            }
+        },
         .forIterStmt => {
             const header = c.nodes[node.head.forIterStmt.header];
 
             try preLoop(c, nodeId);
             const irIdx = try c.ir.pushEmptyStmt(c.alloc, .forIterStmt, nodeId);
-            _ = try c.semaExpr(header.head.forIterHeader.iterable, .{});
+            const iterable = try c.semaExpr(header.head.forIterHeader.iterable, .{});
+            if (iterable.type.dynamic or iterable.type.id == bt.Any or c.sema.isUserObjectType(iterable.type.id)) {
+                // `iterator()` and `next()` can be user methods.
+                markDynamicCall(c);
+            }
             try pushBlock(c, nodeId);
 
             var eachLocal: ?u8 = null;
@@ -426,6 +480,7 @@ pub fn semaStmt(c: *cy.Chunk, nodeId: cy.NodeId) !void {
                 c.ir.setStmtData(destrIdx, .destrElemsStmt, .{
                     .numLocals = eachClause.head.seqDestructure.numArgs,
                     .right = right,
+                    .moveRight = true,
                 });
                 c.dataU8Stack.items.len = seqIrVarStart;
             }
@@ -555,7 +610,9 @@ pub fn semaStmt(c: *cy.Chunk, nodeId: cy.NodeId) !void {
                     break;
                 } else {
                     const irElseIdx = try c.ir.pushEmptyExpr(c.alloc, .elseBlock, elseBlockId);
+                    c.proc().condExprDepth += 1;
                     _ = try c.semaExpr(elseBlock.head.elseBlock.cond, .{});
+                    c.proc().condExprDepth -= 1;
 
                     try pushBlock(c, elseBlockId);
                     try semaStmts(c, elseBlock.head.elseBlock.bodyHead);
@@ -580,7 +637,9 @@ pub fn semaStmt(c: *cy.Chunk, nodeId: cy.NodeId) !void {
             var data: ir.TryStmt = undefined;
             const irIdx = try c.ir.pushEmptyStmt(c.alloc, .tryStmt, nodeId);
             try pushBlock(c, nodeId);
+            c.proc().tryDepth += 1;
             try semaStmts(c, node.head.tryStmt.tryFirstStmt);
+            c.proc().tryDepth -= 1;
             var stmtBlock = try popBlock(c);
             data.bodyHead = stmtBlock.first;
 
@@ -727,7 +786,11 @@ fn assignStmt(c: *cy.Chunk, nodeId: cy.NodeId, leftId: cy.NodeId, rightId: cy.No
                 .varSym         => c.ir.setStmtCode(irStart, .setVarSym),
                 .func           => c.ir.setStmtCode(irStart, .setFuncSym),
                 .local          => c.ir.setStmtCode(irStart, .setLocal),
-                .capturedLocal  => c.ir.setStmtCode(irStart, .setCaptured),
+                .capturedLocal  => {
+                    const pId = c.capVarDescs.get(leftRes.data.local).?.user;
+                    c.varStack.items[pId].inner.local.reassigned = true;
+                    c.ir.setStmtCode(irStart, .setCaptured);
+                },
                 else => {
                     log.tracev("leftRes {s} {}", .{@tagName(leftRes.resType), leftRes.type});
                     return c.reportErrorAt("Assignment to the left `{}` is unsupported.", &.{v(left.node_t)}, nodeId);
@@ -740,6 +803,119 @@ fn assignStmt(c: *cy.Chunk, nodeId: cy.NodeId, leftId: cy.NodeId, rightId: cy.No
     }
 }
 
+/// Returns the local var if `nodeId` is an identifier of a local in the current function.
+fn getLocalIdentVar(c: *cy.Chunk, nodeId: cy.NodeId) ?*LocalVar {
+    if (c.nodes[nodeId].node_t != .ident) {
+        return null;
+    }
+    const info = c.proc().nameToVar.get(c.getNodeStringById(nodeId)) orelse {
+        return null;
+    };
+    const svar = &c.varStack.items[info.varId];
+    if (svar.type != .local or svar.inner.local.lifted) {
+        return null;
+    }
+    return svar;
+}
+
+/// Whether the operand can be evaluated again without side effects and without a retained temp.
+fn isRereadableOperand(c: *cy.Chunk, nodeId: cy.NodeId, allowSymbol: bool) bool {
+    return switch (c.nodes[nodeId].node_t) {
+        .number,
+        .float => true,
+        .symbolLit => allowSymbol,
+        .ident => getLocalIdentVar(c, nodeId) != null,
+        else => false,
+    };
+}
+
+fn isSameOperand(c: *cy.Chunk, a: cy.NodeId, b: cy.NodeId) bool {
+    if (c.nodes[a].node_t != c.nodes[b].node_t) {
+        return false;
+    }
+    return std.mem.eql(u8, c.getNodeStringById(a), c.getNodeStringById(b));
+}
+
+/// Recognizes a read-modify-write of a map entry with the same map and key:
+///     m[k] += e
+///     m[k] = m[k] + e
+///     m[k] = m.get(k, d) + e
+/// Pushes a `mapUpdate` stmt and returns its index. The caller then pushes the unfused stmt
+/// which becomes the fallback.
+fn semaMapUpdate(c: *cy.Chunk, nodeId: cy.NodeId, leftId: cy.NodeId, op: cy.BinaryExprOp, readId: cy.NodeId, rightId: cy.NodeId) !?u32 {
+    switch (op) {
+        .plus,
+        .minus,
+        .star => {},
+        else => return null,
+    }
+    const left = c.nodes[leftId];
+    if (left.node_t != .indexExpr) {
+        return null;
+    }
+    const recvId = left.head.indexExpr.left;
+    const keyId = left.head.indexExpr.right;
+    const recvVar = getLocalIdentVar(c, recvId) orelse {
+        return null;
+    };
+    if (recvVar.vtype.id != bt.Map) {
+        return null;
+    }
+    if (!isRereadableOperand(c, keyId, true) or !isRereadableOperand(c, rightId, false)) {
+        return null;
+    }
+
+    var defaultId: cy.NodeId = cy.NullId;
+    const read = c.nodes[readId];
+    if (read.node_t == .indexExpr) {
+        if (!isSameOperand(c, read.head.indexExpr.left, recvId) or !isSameOperand(c, read.head.indexExpr.right, keyId)) {
+            return null;
+        }
+    } else if (read.node_t == .callExpr) {
+        // `m.get(k, d)`
+        const callee = c.nodes[read.head.callExpr.callee];
+        if (callee.node_t != .accessExpr or read.head.callExpr.numArgs != 2) {
+            return null;
+        }
+        if (!isSameOperand(c, callee.head.accessExpr.left, recvId) or
+            !std.mem.eql(u8, c.getNodeStringById(callee.head.accessExpr.right), "get")) {
+            return null;
+        }
+        const argId = read.head.callExpr.arg_head;
+        defaultId = c.nodes[argId].next;
+        if (!isSameOperand(c, argId, keyId) or !isRereadableOperand(c, defaultId, false)) {
+            return null;
+        }
+    } else {
+        return null;
+    }
+
+    const irIdx = try c.ir.pushEmptyStmt(c.alloc, .mapUpdate, nodeId);
+    const recv = try c.semaExpr(recvId, .{});
+    const index = try c.semaExpr(keyId, .{});
+    const right = try c.semaExpr(rightId, .{});
+    var default: u32 = cy.NullId;
+    if (defaultId != cy.NullId) {
+        default = (try c.semaExpr(defaultId, .{})).irIdx;
+    }
+    c.ir.setStmtData(irIdx, .mapUpdate, .{
+        .op = op,
+        .recv = recv.irIdx,
+        .index = index.irIdx,
+        .right = right.irIdx,
+        .default = default,
+        .slow = cy.NullId,
+    });
+    return irIdx;
+}
+
+/// Detaches the unfused stmt that was appended after `mapUpdate` and keeps it as the fallback.
+fn endMapUpdate(c: *cy.Chunk, irIdx: u32, slowIdx: u32) void {
+    c.ir.getStmtDataPtr(irIdx, .mapUpdate).slow = slowIdx;
+    c.ir.setStmtNext(irIdx, cy.NullId);
+    c.ir.stmtBlockStack.items[c.ir.stmtBlockStack.items.len-1].last = irIdx;
+}
+
 fn checkGetFieldFromObjMod(c: *cy.Chunk, obj: *cy.sym.ObjectType, fieldName: []const u8, nodeId: cy.NodeId) !FieldResult {
     if (obj.head.getMod().?.getSym(fieldName)) |sym| {
         if (sym.type != .field) {
@@ -880,6 +1056,12 @@ pub fn declareEnumMembers(c: *cy.Chunk, sym: *cy.sym.EnumType, nodeId: cy.NodeId
     }
     sym.members = members.ptr;
     sym.numMembers = @intCast(members.len);
+
+    // Enums have no declared methods, so `name()` is added to each type. A member called `name` takes precedence.
+    if (!sym.isChoiceType and sym.getMember("name") == null) {
+        const enumName = cy.builtins.zErrFunc2(cy.builtins.enumName);
+        _ = try c.declareHostFuncSig(@ptrCast(sym), "name", &.{ sym.type }, bt.String, nodeId, enumName, true);
+    }
 }
 
 pub fn declareHostObject(c: *cy.Chunk, nodeId: cy.NodeId) !*cy.sym.HostObjectType {
@@ -1222,6 +1404,7 @@ fn declareParam(c: *cy.Chunk, paramId: cy.NodeId, isSelf: bool, paramIdx: u32, d
             .isParamCopied = false,
             .hasInit = false,
             .lifted = false,
+            .reassigned = false,
             .declIrStart = cy.NullId,
             .hidden = false,
         },
@@ -1291,6 +1474,8 @@ fn declareLocalName2(c: *cy.Chunk, name: []const u8, declType: TypeId, hidden: b
         .isParamCopied = false,
         .hasInit = hasInit,
         .lifted = false,
+        // Vars without an initializer are written by the construct that declares them.
+        .reassigned = !hasInit,
         .hidden = hidden,
         .declIrStart = @intCast(irIdx),
     }};
@@ -1360,6 +1545,7 @@ fn localDecl(c: *cy.Chunk, nodeId: cy.NodeId) !void {
         // Update recent static type.
         svar.vtype.id = right.type.id;
     }
+    svar.narrowT = getNarrowingType(c, svar, node.head.localDecl.right, right);
 
     try c.assignedVarStack.append(c.alloc, varId);
 }
@@ -1390,6 +1576,24 @@ pub fn staticDecl(c: *cy.Chunk, sym: *Sym, nodeId: cy.NodeId) !void {
     });
 }
 
+/// Unlike `staticDecl`, the initializer is evaluated in statement order so it can refer to the input's locals.
+fn replRootVarDecl(c: *cy.Chunk, nodeId: cy.NodeId) !void {
+    const node = c.nodes[nodeId];
+    const varSpec = c.nodes[node.head.staticDecl.varSpec];
+    const name = c.ast.getNamePathStr(varSpec.head.varSpec.name);
+    const sym = c.sym.getMod().getSym(name).?;
+
+    const irIdx = try c.ir.pushEmptyStmt(c.alloc, .setVarSym, nodeId);
+    _ = try c.ir.pushExpr(c.alloc, .varSym, nodeId, .{ .sym = sym });
+    const symType = CompactType.init(try sym.getValueType());
+    const right = try semaExprType(c, node.head.staticDecl.right, symType);
+    c.ir.setStmtData(irIdx, .setVarSym, .{ .generic = .{
+        .leftT = symType,
+        .rightT = right.type,
+        .right = right.irIdx,
+    }});
+}
+
 const SemaExprOptions = struct {
     preferType: TypeId = bt.Any,
     hasTypeCstr: bool = false,
@@ -1612,6 +1816,9 @@ fn semaLocal(c: *cy.Chunk, id: LocalVarId, nodeId: cy.NodeId) !ExprResult {
     switch (svar.type) {
         .local => {
             const irIdx = try c.ir.pushExpr(c.alloc, .local, nodeId, .{ .id = svar.inner.local.id });
+            if (svar.narrowT != cy.NullId) {
+                return ExprResult.initCustom(irIdx, .local, CompactType.initStatic(svar.narrowT), .{ .local = id });
+            }
             return ExprResult.initCustom(irIdx, .local, svar.vtype, .{ .local = id });
         },
         .objectMemberAlias => {
@@ -1630,7 +1837,7 @@ fn semaLocal(c: *cy.Chunk, id: LocalVarId, nodeId: cy.NodeId) !ExprResult {
         },
         .parentLocalAlias => {
             const irIdx = try c.ir.pushExpr(c.alloc, .captured, nodeId, .{ .idx = svar.inner.parentLocalAlias.capturedIdx });
-            return ExprResult.initCustom(irIdx, .capturedLocal, svar.vtype, undefined);
+            return ExprResult.initCustom(irIdx, .capturedLocal, svar.vtype, .{ .local = id });
         },
         else => {
             return c.reportError("Unsupported: {}", &.{v(svar.type)});
@@ -1885,6 +2092,8 @@ fn updateFuncDeclNamePath(c: *cy.Chunk, decl: *FuncDecl, parent: *Sym, nameId: c
 pub fn popProc(self: *cy.Chunk) !cy.ir.StmtBlock {
     const stmtBlock = try popBlock(self);
     const proc = self.proc();
+    // Params and vars in the root block.
+    lowerImmutableCaptures(self, self.varStack.items[proc.varStart..]);
     proc.deinit(self.alloc);
     self.semaProcs.items.len -= 1;
     self.varStack.items.len = proc.varStart;
@@ -1918,10 +2127,11 @@ pub fn semaMainBlock(compiler: *cy.VMcompiler, mainc: *cy.Chunk) !u32 {
     mainc.mainSemaProcId = id;
 
     // Emit IR for initializers. DFS order. Stop at circular dependency.
+    // Chunks before the main chunk were initialized by a previous REPL input.
     // TODO: Allow circular dependency between chunks but not symbols.
-    for (compiler.chunks.items) |c| {
+    for (compiler.chunks.items[mainc.id..]) |c| {
         if (c.hasStaticInit and !c.initializerVisited) {
-            try visitChunkInit(compiler, c, );
+            try visitChunkInit(compiler, mainc, c);
         }
     }
 
@@ -1942,7 +2152,7 @@ pub fn semaMainBlock(compiler: *cy.VMcompiler, mainc: *cy.Chunk) !u32 {
     return irIdx;
 }
 
-fn visitChunkInit(self: *cy.VMcompiler, c: *cy.Chunk) !void {
+fn visitChunkInit(self: *cy.VMcompiler, mainChunk: *cy.Chunk, c: *cy.Chunk) !void {
     c.initializerVisiting = true;
     var iter = c.symInitChunkDeps.keyIterator();
 
@@ -1954,10 +2164,9 @@ fn visitChunkInit(self: *cy.VMcompiler, c: *cy.Chunk) !void {
         if (depChunk.initializerVisiting) {
             return c.reportErrorAt("Referencing `{}` created a circular module dependency.", &.{v(c.srcUri)}, cy.NullId);
         }
-        try visitChunkInit(self, depChunk);
+        try visitChunkInit(self, mainChunk, depChunk);
     }
     // Once all deps are visited, emit IR.
-    const mainChunk = self.chunks.items[0];
 
     const func = c.sym.getMod().getSym("$init").?.cast(.func).first;
     _ = try mainChunk.ir.pushStmt(c.alloc, .exprStmt, cy.NullId, .{ .isBlockResult = false });
@@ -1987,6 +2196,49 @@ pub fn pushProc(self: *cy.Chunk, func: ?*cy.Func) !ProcId {
     return @intCast(idx);
 }
 
+/// Whether a value of `typeId` is checked with an exact runtime type id.
+fn isExactType(c: *cy.Chunk, typeId: TypeId) bool {
+    const sym = c.sema.getTypeSym(typeId);
+    return switch (sym.type) {
+        .object => true,
+        .predefinedType => types.toRtConcreteType(typeId) != null,
+        else => false,
+    };
+}
+
+fn isNarrowable(svar: *const LocalVar) bool {
+    return (svar.declT == bt.Dynamic or svar.declT == bt.Any) and !svar.inner.local.lifted;
+}
+
+/// Narrows a local to `typeId` after a runtime cast proved its type.
+/// Captured locals are skipped since a closure can reassign them.
+fn narrowLocal(c: *cy.Chunk, id: LocalVarId, typeId: TypeId) !void {
+    if (c.proc().condExprDepth > 0) {
+        return;
+    }
+    const svar = &c.varStack.items[id];
+    if (!isNarrowable(svar) or !isExactType(c, typeId)) {
+        return;
+    }
+    svar.narrowT = typeId;
+    // Recorded so that the narrowing ends with the block.
+    try c.assignedVarStack.append(c.alloc, id);
+}
+
+/// Returns the narrowed type of a local assigned from `right`.
+/// Only casts and narrowed locals prove a type. Other static types are just a recent type.
+fn getNarrowingType(c: *cy.Chunk, svar: *const LocalVar, nodeId: cy.NodeId, right: ExprResult) TypeId {
+    if (!isNarrowable(svar) or right.type.dynamic or !isExactType(c, right.type.id)) {
+        return cy.NullId;
+    }
+    const narrowing = switch (c.nodes[nodeId].node_t) {
+        .castExpr => true,
+        .ident => right.resType == .local and c.varStack.items[right.data.local].narrowT != cy.NullId,
+        else => false,
+    };
+    return if (narrowing) right.type.id else cy.NullId;
+}
+
 fn preLoop(c: *cy.Chunk, nodeId: cy.NodeId) !void {
     const proc = c.proc();
     const b = c.block();
@@ -1996,6 +2248,8 @@ fn preLoop(c: *cy.Chunk, nodeId: cy.NodeId) !void {
     const vars = c.varStack.items[proc.varStart..];
     for (vars, 0..) |*svar, i| {
         if (svar.type == .local) {
+            // The rest of the loop can reassign the var before the next iteration.
+            svar.narrowT = cy.NullId;
             if (svar.isDynamic()) {
                 if (svar.vtype.id != bt.Any) {
                     // Dynamic vars enter the loop with a recent type of `any`
@@ -2013,6 +2267,28 @@ fn preLoop(c: *cy.Chunk, nodeId: cy.NodeId) !void {
     b.preLoopVarSaveStart = @intCast(start);
 }
 
+/// A captured var that is never reassigned doesn't need a box.
+/// Closures copy its value when they are created instead.
+fn lowerImmutableCaptures(c: *cy.Chunk, vars: []LocalVar) void {
+    for (vars) |*svar| {
+        if (svar.type != .local) {
+            continue;
+        }
+        const local = &svar.inner.local;
+        if (!local.lifted or local.reassigned) {
+            continue;
+        }
+        local.lifted = false;
+        if (local.isParam) {
+            // Only copied because it was captured.
+            local.isParamCopied = false;
+        } else {
+            // Vars without an initializer are always reassigned.
+            c.ir.getStmtDataPtr(local.declIrStart, .declareLocalInit).lifted = false;
+        }
+    }
+}
+
 fn popBlock(c: *cy.Chunk) !cy.ir.StmtBlock {
     const proc = c.proc();
     const b = c.block();
@@ -2032,6 +2308,8 @@ fn popBlock(c: *cy.Chunk) !cy.ir.StmtBlock {
         // Merge types to parent sub block.
         for (curAssignedVars) |varId| {
             const svar = &c.varStack.items[varId];
+            // Narrowing doesn't outlive the block since it may not have been entered.
+            svar.narrowT = cy.NullId;
             // log.tracev("merging {s}", .{self.getVarName(varId)});
             if (b.prevVarTypes.get(varId)) |prevt| {
                 // Merge recent static type.
@@ -2057,6 +2335,7 @@ fn popBlock(c: *cy.Chunk) !cy.ir.StmtBlock {
     if (proc.blockDepth > 1) {
         // Remove dead vars.
         const varDecls = c.varStack.items[b.varStart..];
+        lowerImmutableCaptures(c, varDecls);
         for (varDecls) |decl| {
             if (decl.type == .local and decl.inner.local.hidden) {
                 continue;
@@ -2228,6 +2507,7 @@ fn pushCapturedObjectMemberAlias(self: *cy.Chunk, name: []const u8, parentVarId:
 
     const pvar = &self.varStack.items[parentVarId];
     pvar.inner.local.lifted = true;
+    pvar.inner.local.reassigned = true;
 
     try self.capVarDescs.put(self.alloc, id, .{
         .user = parentVarId,
@@ -2250,6 +2530,8 @@ fn pushCapturedVar(c: *cy.Chunk, name: []const u8, parentVarId: LocalVarId, vtyp
 
     const pvar = &c.varStack.items[parentVarId];
     pvar.inner.local.lifted = true;
+    // The closure can reassign the var.
+    pvar.narrowT = cy.NullId;
 
     // Patch local IR.
     if (!pvar.inner.local.isParam) {
@@ -2258,6 +2540,10 @@ fn pushCapturedVar(c: *cy.Chunk, name: []const u8, parentVarId: LocalVarId, vtyp
         if (pvar.inner.local.hasInit) {
             const data = c.ir.getStmtDataPtr(declIrStart, .declareLocalInit);
             data.lifted = true;
+            if (data.init == cy.NullId) {
+                // Captured by its own initializer, so the closure is created before the var is set.
+                pvar.inner.local.reassigned = true;
+            }
         } else {
             const data = c.ir.getStmtDataPtr(declIrStart, .declareLocal);
             data.lifted = true;
@@ -2395,6 +2681,10 @@ fn getOrLookupVar(self: *cy.Chunk, name: []const u8, staticLookup: bool, nodeId:
             if (!resVar.inner.local.isParamCopied) {
                 resVar.inner.local.isParamCopied = true;
             }
+            if (self.isInStaticInitializer()) {
+                // The initializer can run before the local is set.
+                resVar.inner.local.reassigned = true;
+            }
             const id = try pushCapturedVar(self, name, res.varId, parentVar.vtype);
             return VarLookupResult{
                 .local = id,
@@ -2612,6 +2902,11 @@ fn checkTypeCstr(c: *cy.Chunk, ctype: CompactType, cstrTypeId: TypeId, nodeId: c
     }
 }
 
+/// The callee of a dynamic call isn't known until runtime and may yield.
+fn markDynamicCall(c: *cy.Chunk) void {
+    c.proc().hasYieldingCall = true;
+}
+
 fn pushExprRes(c: *cy.Chunk, res: ExprResult) !void {
     try c.exprResStack.append(c.alloc, res);
 }
@@ -2806,9 +3101,13 @@ pub const ChunkExt = struct {
 
     pub fn semaSwitchBody(c: *cy.Chunk, info: SwitchInfo, nodeId: cy.NodeId, exprLoc: u32) !u32 {
         const node = c.nodes[nodeId];
+        // A choice switch matches on the integer tag.
+        const bitEq = info.exprIsChoiceType or
+            (!info.exprType.dynamic and c.sema.isBitEqType(info.exprType.id));
         const irIdx = try c.ir.pushExpr(c.alloc, .switchExpr, nodeId, .{
             .numCases = node.head.switchBlock.numCases,
             .expr = exprLoc,
+            .bitEq = bitEq,
         });
         const irCasesIdx = try c.ir.pushEmptyArray(c.alloc, u32, node.head.switchBlock.numCases);
 
@@ -3364,6 +3663,7 @@ pub const ChunkExt = struct {
                 const irIdx = try c.ir.pushEmptyExpr(c.alloc, .condExpr, nodeId);
 
                 _ = try c.semaExpr(node.head.condExpr.cond, .{});
+                c.proc().condExprDepth += 1;
                 const body = try c.semaExpr(node.head.condExpr.bodyExpr, .{});
                 var elseBody: ExprResult = undefined;
                 if (node.head.condExpr.elseExpr != cy.NullId) {
@@ -3371,6 +3671,7 @@ pub const ChunkExt = struct {
                 } else {
                     elseBody = try c.semaNone(nodeId);
                 }
+                c.proc().condExprDepth -= 1;
                 c.ir.setExprData(irIdx, .condExpr, .{ .body = body.irIdx, .elseBody = elseBody.irIdx });
 
                 const dynamic = body.type.dynamic or elseBody.type.dynamic;
@@ -3397,6 +3698,10 @@ pub const ChunkExt = struct {
                         }
                     }
                 }
+                if (child.resType == .local) {
+                    // The local has the cast type for the rest of the block.
+                    try narrowLocal(c, child.data.local, typeId);
+                }
                 return ExprResult.init(irIdx, CompactType.init(typeId));
             },
             .callExpr => {
@@ -3425,6 +3730,7 @@ pub const ChunkExt = struct {
                 } else {
                     const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any, index.type.id }, bt.Any);
                     c.ir.setExprCode(preIdx, .preCallObjSymBinOp);
+                    markDynamicCall(c);
                     c.ir.setExprData(preIdx, .preCallObjSymBinOp, .{ .callObjSymBinOp = .{
                         .op = .index, .funcSigId = funcSigId, .right = index.irIdx,
                     }});
@@ -3468,6 +3774,7 @@ pub const ChunkExt = struct {
                         c.ir.setArrayItem(irExtraIdx, u32, 1, right.irIdx);
                         const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any, left.type.id, right.type.id }, bt.Any);
                         c.ir.setExprCode(preIdx, .preCallObjSym);
+                        markDynamicCall(c);
                         c.ir.setExprData(preIdx, .preCallObjSym, .{ .callObjSym = .{
                             .name = "$slice",
                             .funcSigId = funcSigId,
@@ -3571,16 +3878,20 @@ pub const ChunkExt = struct {
                 }
 
                 i = 0;
+                var allStrs = true;
                 curId = node.head.stringTemplate.exprHead;
                 while (curId != cy.NullId) {
                     var exprN = c.nodes[curId];
                     const argRes = try c.semaExpr(curId, .{});
                     c.ir.setArrayItem(irArgsIdx, u32, i, argRes.irIdx);
+                    if (argRes.type.dynamic or argRes.type.id != bt.String) {
+                        allStrs = false;
+                    }
                     curId = exprN.next;
                     i += 1;
                 }
 
-                c.ir.setExprData(irIdx, .stringTemplate, .{ .numExprs = numExprs, .args = irArgsIdx });
+                c.ir.setExprData(irIdx, .stringTemplate, .{ .numExprs = numExprs, .allStrs = allStrs, .args = irArgsIdx });
                 return ExprResult.initStatic(irIdx, bt.String);
             },
             .group => {
@@ -3639,6 +3950,9 @@ pub const ChunkExt = struct {
                 }
                 const irIdx = try c.ir.pushEmptyExpr(c.alloc, .tryExpr, nodeId);
 
+                // An error can skip the rest of the child expr.
+                c.proc().condExprDepth += 1;
+                defer c.proc().condExprDepth -= 1;
                 if (catchError) {
                     const child = try c.semaExpr(node.head.tryExpr.expr, .{});
                     c.ir.setExprData(irIdx, .tryExpr, .{ .catchBody = cy.NullId });
@@ -3691,6 +4005,7 @@ pub const ChunkExt = struct {
                 return ExprResult.initStatic(irIdx, bt.Fiber);
             },
             .coyield => {
+                c.proc().numYields += 1;
                 const irIdx = try c.ir.pushExpr(c.alloc, .coyield, nodeId, {});
                 return ExprResult.initStatic(irIdx, bt.Any);
             },
@@ -3855,6 +4170,13 @@ pub const ChunkExt = struct {
 
         const func = try mustFindCompatFuncForSym(c, funcSym, args.types, reqRet, calleeId);
         try referenceSym(c, @ptrCast(funcSym), calleeId);
+        if (func.type == .userFunc) {
+            // Callees that haven't been analyzed yet are assumed to yield.
+            const kind = c.compiler.sema.yieldKinds.get(func) orelse .fiber;
+            if (kind != .none) {
+                c.proc().hasYieldingCall = true;
+            }
+        }
 
         c.ir.setExprCode(preIdx, .preCallFuncSym);
         c.ir.setExprData(preIdx, .preCallFuncSym, .{ .callFuncSym = .{
@@ -3866,6 +4188,7 @@ pub const ChunkExt = struct {
     pub fn semaCallValue(c: *cy.Chunk, preIdx: u32, numArgs: u32, irArgsIdx: u32) !ExprResult {
         // Dynamic call.
         c.ir.setExprCode(preIdx, .preCall);
+        markDynamicCall(c);
         c.ir.setExprData(preIdx, .preCall, .{ .call = .{ .numArgs = @as(u8, @intCast(numArgs)), .args = irArgsIdx }});
         return ExprResult.initDynamic(preIdx, bt.Any);
     }
@@ -3882,6 +4205,7 @@ pub const ChunkExt = struct {
         const funcSigId = try c.sema.ensureFuncSig(sigTypes, reqRet);
 
         c.ir.setExprCode(preIdx, .preCallObjSym);
+        markDynamicCall(c);
         c.ir.setExprData(preIdx, .preCallObjSym, .{ .callObjSym = .{
             .funcSigId = funcSigId, .name = name, .numArgs = @as(u8, @intCast(calleeAndArgs.len-1)),
             .args = irArgsIdx,
@@ -3913,6 +4237,7 @@ pub const ChunkExt = struct {
                         // Generic callObjSym.
                         const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any }, bt.Any);
                         c.ir.setExprCode(irIdx, .preCallObjSymUnOp);
+                        markDynamicCall(c);
                         c.ir.setExprData(irIdx, .preCallObjSymUnOp, .{ .callObjSymUnOp = .{
                             .op = op, .funcSigId = funcSigId,
                         }});
@@ -3956,6 +4281,7 @@ pub const ChunkExt = struct {
                 } else {
                     const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any }, bt.Any);
                     c.ir.setExprCode(irIdx, .preCallObjSymUnOp);
+                    markDynamicCall(c);
                     c.ir.setExprData(irIdx, .preCallObjSymUnOp, .{ .callObjSymUnOp = .{
                         .op = op, .funcSigId = funcSigId,
                     }});
@@ -3974,7 +4300,9 @@ pub const ChunkExt = struct {
             .or_op => {
                 const preIdx = try c.ir.pushEmptyExpr(c.alloc, .preBinOp, nodeId);
                 const left = try c.semaExpr(leftId, .{});
+                c.proc().condExprDepth += 1;
                 const right = try c.semaExpr(rightId, .{});
+                c.proc().condExprDepth -= 1;
                 c.ir.setExprData(preIdx, .preBinOp, .{ .binOp = .{
                     .leftT = left.type.id,
                     .rightT = right.type.id,
@@ -4012,6 +4340,7 @@ pub const ChunkExt = struct {
                     // Generic callObjSym.
                     const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any, right.type.id }, bt.Any);
                     c.ir.setExprCode(preIdx, .preCallObjSymBinOp);
+                    markDynamicCall(c);
                     c.ir.setExprData(preIdx, .preCallObjSymBinOp, .{ .callObjSymBinOp = .{
                         .op = op, .funcSigId = funcSigId, .right = right.irIdx,
                     }});
@@ -4047,6 +4376,7 @@ pub const ChunkExt = struct {
                         // Generic callObjSym.
                         const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any, right.type.id }, bt.Any);
                         c.ir.setExprCode(preIdx, .preCallObjSymBinOp);
+                        markDynamicCall(c);
                         c.ir.setExprData(preIdx, .preCallObjSymBinOp, .{ .callObjSymBinOp = .{
                             .op = op, .funcSigId = funcSigId, .right = right.irIdx,
                         }});
@@ -4095,6 +4425,7 @@ pub const ChunkExt = struct {
                         // Generic callObjSym.
                         const funcSigId = try c.sema.ensureFuncSig(&.{ bt.Any, right.type.id }, bt.Any);
                         c.ir.setExprCode(preIdx, .preCallObjSymBinOp);
+                        markDynamicCall(c);
                         c.ir.setExprData(preIdx, .preCallObjSymBinOp, .{ .callObjSymBinOp = .{
                             .op = op, .funcSigId = funcSigId, .right = right.irIdx,
                         }});
@@ -4125,6 +4456,9 @@ pub const ChunkExt = struct {
                 const rightPreferT = if (left.type.id == bt.Float or left.type.id == bt.Integer) left.type.id else bt.Any;
                 const right = try c.semaExprPrefer(rightId, rightPreferT);
 
+                const bitEq = (!left.type.dynamic and c.sema.isBitEqType(left.type.id)) or
+                    (!right.type.dynamic and c.sema.isBitEqType(right.type.id));
+
                 c.ir.setExprCode(preIdx, .preBinOp);
                 c.ir.setExprData(preIdx, .preBinOp, .{
                     .binOp = .{
@@ -4132,6 +4466,7 @@ pub const ChunkExt = struct {
                         .rightT = right.type.id,
                         .op = op,
                         .right = right.irIdx,
+                        .bitEq = bitEq,
                     },
                 });
                 return ExprResult.initStatic(preIdx, bt.Boolean);
@@ -4260,6 +4595,7 @@ fn assignToLocalVar(c: *cy.Chunk, localRes: ExprResult, rhs: cy.NodeId, opts: As
     const right = try c.semaExprOrOpAssignBinExpr(rightExpr, opts.rhsOpAssignBinExpr);
     // Refresh pointer after rhs.
     svar = &c.varStack.items[id];
+    svar.inner.local.reassigned = true;
 
     if (svar.inner.local.isParam) {
         if (!svar.inner.local.isParamCopied) {
@@ -4281,6 +4617,7 @@ fn assignToLocalVar(c: *cy.Chunk, localRes: ExprResult, rhs: cy.NodeId, opts: As
             svar.vtype.id = right.type.id;
         }
     }
+    svar.narrowT = getNarrowingType(c, svar, rhs, right);
 
     try c.assignedVarStack.append(c.alloc, id);
     return right;
@@ -4360,6 +4697,14 @@ pub fn popFuncBlock(c: *cy.Chunk) !void {
     const func = proc.func.?;
     const parentType = if (func.isMethod) params[0].declT else cy.NullId;
 
+    if (func.type == .userFunc) {
+        var kind: YieldKind = .none;
+        if (proc.numYields > 0 or proc.hasYieldingCall) {
+            kind = if (proc.numYields == proc.numStmtYields and !proc.hasYieldingCall) .stackless else .fiber;
+        }
+        try c.compiler.sema.yieldKinds.put(c.compiler.sema.alloc, func, kind);
+    }
+
     // Patch `pushFuncBlock` with maxLocals and param copies.
     c.ir.setStmtData(proc.irStart, .funcBlock, .{
         .maxLocals = proc.maxLocals,
@@ -4421,6 +4766,19 @@ const FuncSigKey = struct {
     ret: TypeId,
 };
 
+/// How a static function can yield.
+pub const YieldKind = enum(u8) {
+    /// Never yields, even from a nested call.
+    none,
+
+    /// Only yields from statements in its own body.
+    /// `coinit` creates a stackless generator for it, see `CoinitGen`.
+    stackless,
+
+    /// Yields from an expression, a try block, a static call, or may yield from a dynamic call. Requires a fiber.
+    fiber,
+};
+
 pub const Sema = struct {
     alloc: std.mem.Allocator,
     compiler: *cy.VMcompiler,
@@ -4431,6 +4789,9 @@ pub const Sema = struct {
     funcSigs: std.ArrayListUnmanaged(FuncSig),
     funcSigMap: std.HashMapUnmanaged(FuncSigKey, FuncSigId, FuncSigKeyContext, 80),
 
+    /// Recorded for user functions after their bodies are analyzed.
+    yieldKinds: std.AutoHashMapUnmanaged(*cy.Func, YieldKind),
+
     pub fn init(alloc: std.mem.Allocator, compiler: *cy.VMcompiler) Sema {
         return .{
             .alloc = alloc,
@@ -4438,6 +4799,7 @@ pub const Sema = struct {
             .funcSigs = .{},
             .funcSigMap = .{},
             .types = .{},
+            .yieldKinds = .{},
         };
     }
 
@@ -4449,13 +4811,20 @@ pub const Sema = struct {
             self.types.clearRetainingCapacity();
             self.funcSigs.clearRetainingCapacity();
             self.funcSigMap.clearRetainingCapacity();
+            self.yieldKinds.clearRetainingCapacity();
         } else {
             self.types.deinit(alloc);
             self.funcSigs.deinit(alloc);
             self.funcSigMap.deinit(alloc);
+            self.yieldKinds.deinit(alloc);
         }
     }
 
+    /// Whether `coinit` can create a stackless generator for `func`.
+    pub fn isStacklessGen(s: *const Sema, func: *cy.Func) bool {
+        return s.yieldKinds.get(func) == .stackless;
+    }
+
     pub fn ensureUntypedFuncSig(s: *Sema, numParams: u32) !FuncSigId {
         const buf = std.mem.bytesAsSlice(cy.TypeId, &cy.tempBuf);
         if (buf.len < numParams) return error.TooBig;
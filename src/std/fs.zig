@@ -11,6 +11,7 @@ const cc = @import("../capi.zig");
 pub var FileT: cy.TypeId = undefined;
 pub var DirT: cy.TypeId = undefined;
 pub var DirIterT: cy.TypeId = undefined;
+pub var MappedFileT: cy.TypeId = undefined;
 
 pub const File = extern struct {
     readBuf: [*]u8,
@@ -24,6 +25,13 @@ pub const File = extern struct {
     closeOnFree: bool,
     closed: bool,
 
+    /// Astring object that owns the buffer of `os.readLine`, `os.stdinLines`, and `Pipeline` lines.
+    /// Only used by `os.stdin` and the output of a `Pipeline`.
+    /// Unread bytes are at `[lineStart..lineEnd]`. Long lines are returned as slices of it.
+    lineBuf: ?*cy.HeapObject,
+    lineStart: u32,
+    lineEnd: u32,
+
     pub fn getStdFile(self: *const File) std.fs.File {
         return std.fs.File{
             .handle = self.fd,
@@ -48,6 +56,9 @@ pub fn fileFinalizer(vm_: ?*cc.VM, obj: ?*anyopaque) callconv(.C) void {
         if (file.hasReadBuf) {
             vm.alloc.free(file.readBuf[0..file.readBufCap]);
         }
+        if (file.lineBuf) |buf| {
+            cy.arc.releaseObject(vm, buf);
+        }
         if (file.closeOnFree) {
             file.close();
         }
@@ -131,6 +142,9 @@ pub fn allocFile(vm: *cy.VM, fd: if (cy.hasStdFiles) std.os.fd_t else u32) links
         .readBufEnd = 0,
         .closed = false,
         .closeOnFree = true,
+        .lineBuf = null,
+        .lineStart = 0,
+        .lineEnd = 0,
     };
     return Value.initHostNoCycPtr(file);
 }
@@ -307,12 +321,26 @@ pub fn fileWrite(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
         return rt.prepThrowError(vm, .Closed);
     }
 
-    var buf = try vm.getOrBufPrintValueRawStr(&cy.tempBuf, args[1]);
+    const buf = try getWriteBytes(vm, args[1]);
     const file = fileo.getStdFile();
     const numWritten = try file.write(buf);
     return Value.initInt(@intCast(numWritten));
 }
 
+/// Returns the bytes of a `String` or `Array` without copying.
+/// Other values are printed to the VM's temp string.
+pub fn getWriteBytes(vm: *cy.VM, val: Value) ![]const u8 {
+    if (val.isArray()) {
+        return val.asArray();
+    } else if (val.isString()) {
+        return val.asString();
+    } else {
+        const w = vm.clearTempString();
+        try vm.writeValue(w, val);
+        return vm.getTempString();
+    }
+}
+
 pub fn fileClose(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
 
@@ -553,6 +581,125 @@ pub fn dirIteratorNext(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
     }
 }
 
+pub const hasMmap = cy.hasStdFiles and builtin.os.tag != .windows;
+
+/// Holds the file mapping. Views are slice objects with the `MappedFile` as their parent,
+/// so the mapping stays alive while any view does.
+pub const MappedFile = extern struct {
+    ptr: [*]align(std.mem.page_size) const u8,
+    len: usize,
+
+    fn pages(self: *const MappedFile) []align(std.mem.page_size) const u8 {
+        return self.ptr[0..self.len];
+    }
+
+    /// Returns the bytes from `start` to `end` after checking that they can be referenced by a slice object.
+    fn getView(self: *const MappedFile, start: i48, end: i48, maxLen: u32) ![]const u8 {
+        if (start < 0 or end < start or end > self.len) {
+            return error.OutOfBounds;
+        }
+        const ustart: usize = @intCast(start);
+        const uend: usize = @intCast(end);
+        if (uend - ustart > maxLen) {
+            return error.InvalidArgument;
+        }
+        return self.ptr[ustart..uend];
+    }
+};
+
+pub fn allocMappedFile(vm: *cy.VM, file: std.fs.File) !Value {
+    const len = (try file.stat()).size;
+    var ptr: [*]align(std.mem.page_size) const u8 = undefined;
+    if (len > 0) {
+        const pages = try std.os.mmap(null, len, std.os.PROT.READ, std.os.MAP.PRIVATE, file.handle, 0);
+        ptr = pages.ptr;
+    }
+    errdefer if (len > 0) std.os.munmap(ptr[0..len]);
+    const mfile: *MappedFile = @ptrCast(@alignCast(try cy.heap.allocHostNoCycObject(vm, MappedFileT, @sizeOf(MappedFile))));
+    mfile.* = .{
+        .ptr = ptr,
+        .len = len,
+    };
+    return Value.initHostNoCycPtr(mfile);
+}
+
+pub fn mappedFileFinalizer(_: ?*cc.VM, obj: ?*anyopaque) callconv(.C) void {
+    if (hasMmap) {
+        const mfile: *MappedFile = @ptrCast(@alignCast(obj));
+        if (mfile.len > 0) {
+            std.os.munmap(mfile.pages());
+        }
+    }
+}
+
+pub fn mappedFileAdvise(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (!hasMmap) return vm.prepPanic("Unsupported.");
+    const mfile = args[0].castHostObject(*MappedFile);
+    const advice: u32 = switch (try std.meta.intToEnum(cy.bindings.Symbol, args[1].asSymbolId())) {
+        .normal => std.os.MADV.NORMAL,
+        .sequential => std.os.MADV.SEQUENTIAL,
+        .random => std.os.MADV.RANDOM,
+        .willNeed => std.os.MADV.WILLNEED,
+        else => return error.InvalidArgument,
+    };
+    if (mfile.len > 0) {
+        const pages = mfile.pages();
+        try std.os.madvise(@constCast(pages.ptr), pages.len, advice);
+    }
+    return Value.None;
+}
+
+pub fn mappedFileLen(_: *cy.VM, args: [*]const Value, _: u8) Value {
+    const mfile = args[0].castHostObject(*MappedFile);
+    return Value.initInt(@intCast(mfile.len));
+}
+
+pub fn mappedFileArray(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const mfile = args[0].castHostObject(*MappedFile);
+    return allocMappedArray(vm, args[0], 0, @intCast(mfile.len));
+}
+
+pub fn mappedFileArray2(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return allocMappedArray(vm, args[0], args[1].asInteger(), args[2].asInteger());
+}
+
+fn allocMappedArray(vm: *cy.VM, mfilev: Value, start: i48, end: i48) !Value {
+    const mfile = mfilev.castHostObject(*MappedFile);
+    const view = try mfile.getView(start, end, 0x7fffffff);
+    if (view.len == 0) {
+        return vm.allocArray("");
+    }
+    const parent = mfilev.asHeapObject();
+    vm.retainObject(parent);
+    return vm.allocArraySlice(view, parent);
+}
+
+pub fn mappedFileString(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    const mfile = args[0].castHostObject(*MappedFile);
+    return allocMappedString(vm, args[0], 0, @intCast(mfile.len));
+}
+
+pub fn mappedFileString2(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    return allocMappedString(vm, args[0], args[1].asInteger(), args[2].asInteger());
+}
+
+fn allocMappedString(vm: *cy.VM, mfilev: Value, start: i48, end: i48) !Value {
+    const mfile = mfilev.castHostObject(*MappedFile);
+    const view = try mfile.getView(start, end, 0x3fffffff);
+    if (view.len == 0) {
+        vm.retain(vm.emptyString);
+        return vm.emptyString;
+    }
+    const charLen = cy.validateUtf8(view) orelse return error.Unicode;
+    const parent = mfilev.asHeapObject();
+    vm.retainObject(parent);
+    if (charLen == view.len) {
+        return vm.allocAstringSlice(view, parent);
+    } else {
+        return vm.allocUstringSlice(view, @intCast(charLen), parent);
+    }
+}
+
 pub fn prepareThrowSymbol(vm: *cy.UserVM, sym: cy.bindings.Symbol) Value {
     return vm.prepareThrowSymbol(@intFromEnum(sym));
 }
\ No newline at end of file
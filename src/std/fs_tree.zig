@@ -0,0 +1,412 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const cy = @import("../cyber.zig");
+
+const log = cy.log.scoped(.fs_tree);
+
+/// Size of each worker's read buffer.
+const BufSize = 64 * 1024;
+const MaxWorkers = 64;
+
+pub const CopyOptions = struct {
+    /// Existing files in the destination are skipped when false.
+    overwrite: bool = true,
+    /// 0 uses the number of cpus.
+    numWorkers: u32 = 0,
+};
+
+pub const HashAlgo = enum {
+    xxhash64,
+    wyhash,
+    sha256,
+};
+
+pub const Digest = struct {
+    buf: [32]u8,
+    len: u8,
+
+    pub fn slice(self: *const Digest) []const u8 {
+        return self.buf[0..self.len];
+    }
+};
+
+/// Files found by walking a tree. Paths are relative to the root and use the native separator.
+const FileList = struct {
+    paths: std.ArrayListUnmanaged([]const u8) = .{},
+
+    fn deinit(self: *FileList, alloc: std.mem.Allocator) void {
+        for (self.paths.items) |path| {
+            alloc.free(path);
+        }
+        self.paths.deinit(alloc);
+    }
+};
+
+/// Only regular files and directories are visited. `dstDir` receives the directory structure when not null.
+fn collectFiles(alloc: std.mem.Allocator, root: std.fs.IterableDir, dstDir: ?std.fs.Dir) !FileList {
+    var list = FileList{};
+    errdefer list.deinit(alloc);
+    var walker = try root.walk(alloc);
+    defer walker.deinit();
+    while (try walker.next()) |entry| {
+        switch (entry.kind) {
+            .file => {
+                try list.paths.append(alloc, try alloc.dupe(u8, entry.path));
+            },
+            .directory => {
+                if (dstDir) |dir| {
+                    try dir.makePath(entry.path);
+                }
+            },
+            else => {
+                log.tracev("skipping {s}", .{entry.path});
+            },
+        }
+    }
+    return list;
+}
+
+/// Shared by the workers of a tree op. Each worker claims the next file index until all files are done
+/// or a worker fails.
+fn Pool(comptime Ctx: type, comptime workFn: fn (ctx: *Ctx, idx: usize, buf: []u8) anyerror!void) type {
+    return struct {
+        ctx: *Ctx,
+        numFiles: usize,
+        bufs: []u8,
+        next: usize = 0,
+        failed: bool = false,
+        err: anyerror = undefined,
+        mutex: std.Thread.Mutex = .{},
+
+        const Self = @This();
+
+        fn run(self: *Self, alloc: std.mem.Allocator, reqWorkers: u32) !void {
+            if (self.numFiles == 0) {
+                return;
+            }
+            const numCpus: u32 = @intCast(std.Thread.getCpuCount() catch 1);
+            const maxWorkers = if (reqWorkers == 0) numCpus else reqWorkers;
+            const numWorkers = @min(@min(self.numFiles, maxWorkers), MaxWorkers);
+
+            self.bufs = try alloc.alloc(u8, numWorkers * BufSize);
+            defer alloc.free(self.bufs);
+
+            var threads: [MaxWorkers]std.Thread = undefined;
+            var numSpawned: usize = 0;
+            // The calling thread also works so a failed spawn only reduces concurrency.
+            while (numSpawned < numWorkers - 1) : (numSpawned += 1) {
+                threads[numSpawned] = std.Thread.spawn(.{}, worker, .{ self, numSpawned + 1 }) catch break;
+            }
+            worker(self, 0);
+            for (threads[0..numSpawned]) |thread| {
+                thread.join();
+            }
+            if (self.failed) {
+                return self.err;
+            }
+        }
+
+        fn worker(self: *Self, workerIdx: usize) void {
+            const buf = self.bufs[workerIdx * BufSize ..][0..BufSize];
+            while (!@atomicLoad(bool, &self.failed, .SeqCst)) {
+                const idx = @atomicRmw(usize, &self.next, .Add, 1, .SeqCst);
+                if (idx >= self.numFiles) {
+                    return;
+                }
+                workFn(self.ctx, idx, buf) catch |err| {
+                    self.mutex.lock();
+                    defer self.mutex.unlock();
+                    if (!self.failed) {
+                        self.err = err;
+                        @atomicStore(bool, &self.failed, true, .SeqCst);
+                    }
+                    return;
+                };
+            }
+        }
+    };
+}
+
+const CopyContext = struct {
+    srcDir: std.fs.Dir,
+    dstDir: std.fs.Dir,
+    files: []const []const u8,
+    overwrite: bool,
+    numCopied: usize = 0,
+};
+
+/// Copies the regular files and directories under `srcPath` into `dstPath`, creating `dstPath` if needed.
+/// Returns the number of files copied. Returns `error.InvalidArgument` if `dstPath` is inside `srcPath`.
+pub fn copyTree(alloc: std.mem.Allocator, srcPath: []const u8, dstPath: []const u8, opts: CopyOptions) !usize {
+    var src = try std.fs.cwd().openIterableDir(srcPath, .{});
+    defer src.close();
+    const dstExisted = if (std.fs.cwd().access(dstPath, .{})) true else |_| false;
+    try std.fs.cwd().makePath(dstPath);
+    var dst = try std.fs.cwd().openDir(dstPath, .{});
+    defer dst.close();
+
+    // The walk would find the copies and keep descending into them.
+    if (try isInsideDir(alloc, src.dir, dst)) {
+        if (!dstExisted) {
+            std.fs.cwd().deleteDir(dstPath) catch {};
+        }
+        return error.InvalidArgument;
+    }
+
+    var files = try collectFiles(alloc, src, dst);
+    defer files.deinit(alloc);
+
+    var ctx = CopyContext{
+        .srcDir = src.dir,
+        .dstDir = dst,
+        .files = files.paths.items,
+        .overwrite = opts.overwrite,
+    };
+    var pool = Pool(CopyContext, copyWork){
+        .ctx = &ctx,
+        .numFiles = files.paths.items.len,
+        .bufs = undefined,
+    };
+    try pool.run(alloc, opts.numWorkers);
+    return ctx.numCopied;
+}
+
+/// Returns whether `dir` is `parent` or one of its descendants. Symlinks are resolved.
+fn isInsideDir(alloc: std.mem.Allocator, parent: std.fs.Dir, dir: std.fs.Dir) !bool {
+    const parentPath = try parent.realpathAlloc(alloc, ".");
+    defer alloc.free(parentPath);
+    const dirPath = try dir.realpathAlloc(alloc, ".");
+    defer alloc.free(dirPath);
+    if (!std.mem.startsWith(u8, dirPath, parentPath)) {
+        return false;
+    }
+    return dirPath.len == parentPath.len or std.fs.path.isSep(dirPath[parentPath.len]) or
+        std.fs.path.isSep(parentPath[parentPath.len-1]);
+}
+
+fn copyWork(ctx: *CopyContext, idx: usize, buf: []u8) !void {
+    const path = ctx.files[idx];
+    const src = try ctx.srcDir.openFile(path, .{});
+    defer src.close();
+    const stat = try src.stat();
+    const dst = ctx.dstDir.createFile(path, .{
+        .mode = stat.mode,
+        .exclusive = !ctx.overwrite,
+    }) catch |err| {
+        if (err == error.PathAlreadyExists and !ctx.overwrite) {
+            return;
+        }
+        return err;
+    };
+    defer dst.close();
+    try copyContents(src, dst, buf);
+    _ = @atomicRmw(usize, &ctx.numCopied, .Add, 1, .SeqCst);
+}
+
+/// Uses `copy_file_range` on Linux so the kernel copies the data without a round trip through `buf`.
+/// Falls back to a read/write loop from the current file positions when the kernel can't offload the copy.
+fn copyContents(src: std.fs.File, dst: std.fs.File, buf: []u8) !void {
+    if (builtin.os.tag == .linux) {
+        const linux = std.os.linux;
+        while (true) {
+            const rc = linux.copy_file_range(src.handle, null, dst.handle, null, std.math.maxInt(i32), 0);
+            switch (linux.getErrno(rc)) {
+                .SUCCESS => {
+                    if (rc == 0) {
+                        return;
+                    }
+                },
+                .INTR => continue,
+                // Cross filesystem, unsupported file types, or an old kernel.
+                .XDEV, .INVAL, .NOSYS, .OPNOTSUPP => break,
+                .IO => return error.InputOutput,
+                .NOSPC => return error.NoSpaceLeft,
+                .FBIG => return error.FileTooBig,
+                else => |errno| return std.os.unexpectedErrno(errno),
+            }
+        }
+    }
+    while (true) {
+        const n = try src.read(buf);
+        if (n == 0) {
+            return;
+        }
+        try dst.writeAll(buf[0..n]);
+    }
+}
+
+const HashContext = struct {
+    dir: std.fs.Dir,
+    files: []const []const u8,
+    algo: HashAlgo,
+    digests: []Digest,
+};
+
+pub const HashResult = struct {
+    files: FileList,
+    digests: []Digest,
+
+    pub fn paths(self: *const HashResult) []const []const u8 {
+        return self.files.paths.items;
+    }
+
+    pub fn deinit(self: *HashResult, alloc: std.mem.Allocator) void {
+        self.files.deinit(alloc);
+        alloc.free(self.digests);
+    }
+};
+
+/// Hashes every regular file under `path`. Digests are in the same order as `paths()`.
+pub fn hashTree(alloc: std.mem.Allocator, path: []const u8, algo: HashAlgo, numWorkers: u32) !HashResult {
+    var dir = try std.fs.cwd().openIterableDir(path, .{});
+    defer dir.close();
+
+    var files = try collectFiles(alloc, dir, null);
+    errdefer files.deinit(alloc);
+    const digests = try alloc.alloc(Digest, files.paths.items.len);
+    errdefer alloc.free(digests);
+
+    var ctx = HashContext{
+        .dir = dir.dir,
+        .files = files.paths.items,
+        .algo = algo,
+        .digests = digests,
+    };
+    var pool = Pool(HashContext, hashWork){
+        .ctx = &ctx,
+        .numFiles = files.paths.items.len,
+        .bufs = undefined,
+    };
+    try pool.run(alloc, numWorkers);
+    return .{
+        .files = files,
+        .digests = digests,
+    };
+}
+
+fn hashWork(ctx: *HashContext, idx: usize, buf: []u8) !void {
+    const file = try ctx.dir.openFile(ctx.files[idx], .{});
+    defer file.close();
+    const digest = &ctx.digests[idx];
+    switch (ctx.algo) {
+        .xxhash64 => {
+            var hasher = std.hash.XxHash64.init(0);
+            try hashFile(file, buf, &hasher);
+            std.mem.writeIntBig(u64, digest.buf[0..8], hasher.final());
+            digest.len = 8;
+        },
+        .wyhash => {
+            var hasher = std.hash.Wyhash.init(0);
+            try hashFile(file, buf, &hasher);
+            std.mem.writeIntBig(u64, digest.buf[0..8], hasher.final());
+            digest.len = 8;
+        },
+        .sha256 => {
+            var hasher = std.crypto.hash.sha2.Sha256.init(.{});
+            try hashFile(file, buf, &hasher);
+            hasher.final(digest.buf[0..32]);
+            digest.len = 32;
+        },
+    }
+}
+
+fn hashFile(file: std.fs.File, buf: []u8, hasher: anytype) !void {
+    while (true) {
+        const n = try file.read(buf);
+        if (n == 0) {
+            return;
+        }
+        hasher.update(buf[0..n]);
+    }
+}
+
+pub const ReadResult = union(enum) {
+    /// The file's bytes start after the requested header length.
+    data: []align(8) u8,
+    err: anyerror,
+};
+
+const ReadContext = struct {
+    alloc: std.mem.Allocator,
+    files: []const []const u8,
+    maxSize: usize,
+    headerLen: usize,
+    results: []ReadResult,
+};
+
+/// Reads each file in `paths` with a pool of threads. Results are in the same order as `paths`.
+/// A failed read is stored in its result instead of stopping the other reads. The caller owns the data.
+/// Each file's data is preceded by `headerLen` unused bytes, so the caller can add a header without copying the data.
+pub fn readFiles(alloc: std.mem.Allocator, paths: []const []const u8, maxSize: usize, headerLen: usize, numWorkers: u32) ![]ReadResult {
+    const results = try alloc.alloc(ReadResult, paths.len);
+    errdefer alloc.free(results);
+    var ctx = ReadContext{
+        .alloc = alloc,
+        .files = paths,
+        .maxSize = maxSize,
+        .headerLen = headerLen,
+        .results = results,
+    };
+    var pool = Pool(ReadContext, readWork){
+        .ctx = &ctx,
+        .numFiles = paths.len,
+        .bufs = undefined,
+    };
+    try pool.run(alloc, numWorkers);
+    return results;
+}
+
+fn readWork(ctx: *ReadContext, idx: usize, buf: []u8) !void {
+    if (readFileBuffered(ctx.alloc, ctx.files[idx], ctx.maxSize, ctx.headerLen, buf)) |data| {
+        ctx.results[idx] = .{ .data = data };
+    } else |err| {
+        ctx.results[idx] = .{ .err = err };
+    }
+}
+
+/// Files that fit in `buf` are read without a `stat` and only their exact size is allocated.
+/// Larger files are read directly into a buffer sized by `stat`.
+fn readFileBuffered(alloc: std.mem.Allocator, path: []const u8, maxSize: usize, headerLen: usize, buf: []u8) ![]align(8) u8 {
+    const file = try std.fs.cwd().openFile(path, .{});
+    defer file.close();
+    const n = try file.readAll(buf);
+    if (n > maxSize) {
+        return error.FileTooBig;
+    }
+    if (n < buf.len) {
+        const res = try alloc.alignedAlloc(u8, 8, headerLen + n);
+        @memcpy(res[headerLen..], buf[0..n]);
+        return res;
+    }
+    const size = (try file.stat()).size;
+    if (size > maxSize) {
+        return error.FileTooBig;
+    }
+    var res = try alloc.alignedAlloc(u8, 8, headerLen + @max(size, n));
+    errdefer alloc.free(res);
+    @memcpy(res[headerLen..headerLen + n], buf[0..n]);
+    var len = headerLen + n;
+    while (true) {
+        if (len == res.len) {
+            // The file grew since `stat`.
+            if (len - headerLen >= maxSize) {
+                var extra: [1]u8 = undefined;
+                if (try file.read(&extra) > 0) {
+                    return error.FileTooBig;
+                }
+                return res;
+            }
+            res = try alloc.realloc(res, @min(headerLen + maxSize, res.len + BufSize));
+        }
+        const numRead = try file.read(res[len..]);
+        if (numRead == 0) {
+            break;
+        }
+        len += numRead;
+    }
+    if (len < res.len) {
+        // The file shrank since `stat`.
+        res = try alloc.realloc(res, len);
+    }
+    return res;
+}
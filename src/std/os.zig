@@ -20,6 +20,8 @@ const ffi = @import("os_ffi.zig");
 const http = @import("../http.zig");
 const cache = @import("../cache.zig");
 const fs = @import("fs.zig");
+const fs_tree = @import("fs_tree.zig");
+const pipeline = @import("pipeline.zig");
 
 const log = cy.log.scoped(.os);
 
@@ -42,9 +44,13 @@ const NameFunc = struct { []const u8, cy.ZHostFuncFn };
 const funcs = [_]NameFunc{
     // Top level
     .{"access",         zErrFunc2(access)},
+    .{"appendFile",     zErrFunc2(appendFile)},
     .{"args",           zErrFunc2(osArgs)},
     .{"cacheUrl",       zErrFunc2(cacheUrl)},
     .{"copyFile",       zErrFunc(copyFile)},
+    .{"copyTree",       zErrFunc2(copyTree)},
+    .{"copyTree",       zErrFunc2(copyTreeExt)},
+    .{"cpuNanos",       cpuNanos},
     .{"createDir",      zErrFunc(createDir)},
     .{"createFile",     zErrFunc2(createFile)},
     .{"cstr",           zErrFunc2(cstr)},
@@ -57,24 +63,33 @@ const funcs = [_]NameFunc{
     .{"free",           free},
     .{"getEnv",         zErrFunc2(getEnv)},
     .{"getEnvAll",      zErrFunc2(getEnvAll)},
+    .{"hashTree",       zErrFunc2(hashTree)},
     .{"malloc",         zErrFunc(malloc)},
+    .{"mapFile",        zErrFunc2(mapFile)},
     .{"milliTime",      milliTime},
+    .{"monoNanos",      monoNanos},
     .{"newFFI",         newFFI},
+    .{"newTimer",       zErrFunc2(newTimer)},
     .{"now",            zErrFunc2(now)},
     .{"openDir",        zErrFunc2(openDir)},
     .{"openDir",        zErrFunc2(openDir2)},
     .{"openFile",       zErrFunc2(openFile)},
     .{"parseArgs",      zErrFunc2(parseArgs)},
+    .{"pipeline",       zErrFunc2(osPipeline)},
+    .{"pipeline",       zErrFunc2(osPipelineExt)},
     .{"readAll",        zErrFunc2(readAll)},
     .{"readFile",       zErrFunc2(readFile)},
+    .{"readFiles",      zErrFunc2(readFiles)},
     .{"readLine",       zErrFunc2(readLine)},
     .{"realPath",       zErrFunc2(realPath)},
     .{"removeDir",      zErrFunc(removeDir)},
     .{"removeFile",     zErrFunc(removeFile)},
-    .{"setEnv",         zErrFunc(setEnv)},
+    .{"setEnv",         zErrFunc2(setEnv)},
     .{"sleep",          sleep},
+    .{"stdinLines",     zErrFunc2(stdinLines)},
     .{"unsetEnv",       unsetEnv},
     .{"writeFile",      zErrFunc2(writeFile)},
+    .{"writeFileAtomic", zErrFunc2(writeFileAtomic)},
 
     // File
     .{"close",          fs.fileClose},
@@ -107,6 +122,28 @@ const funcs = [_]NameFunc{
     .{"cfunc",          zErrFunc2(ffi.ffiCfunc)},
     .{"new",            zErrFunc2(ffi.ffiNew)},
     .{"unbindObjPtr",   zErrFunc2(ffi.ffiUnbindObjPtr)},
+
+    // StdinLines
+    .{"iterator",       stdinLinesIterator},
+    .{"next",           zErrFunc2(stdinLinesNext)},
+
+    // MappedFile
+    .{"advise",         zErrFunc2(fs.mappedFileAdvise)},
+    .{"array",          zErrFunc2(fs.mappedFileArray)},
+    .{"array",          zErrFunc2(fs.mappedFileArray2)},
+    .{"len",            fs.mappedFileLen},
+    .{"string",         zErrFunc2(fs.mappedFileString)},
+    .{"string",         zErrFunc2(fs.mappedFileString2)},
+
+    // Pipeline
+    .{"iterator",       pipelineIterator},
+    .{"next",           zErrFunc2(pipelineNext)},
+    .{"wait",           zErrFunc2(pipelineWait)},
+
+    // Timer
+    .{"lap",            timerLap},
+    .{"read",           timerRead},
+    .{"reset",          timerReset},
 };
 
 const NameValue = struct { []const u8, cy.Value };
@@ -126,6 +163,10 @@ const types = [_]NameType{
     .{"Dir", &fs.DirT, null, fs.dirFinalizer },
     .{"DirIterator", &fs.DirIterT, fs.dirIteratorGetChildren, fs.dirIteratorFinalizer },
     .{"FFI", &ffi.FFIT, ffi.ffiGetChildren, ffi.ffiFinalizer },
+    .{"StdinLines", &StdinLinesT, null, stdinLinesFinalizer },
+    .{"MappedFile", &fs.MappedFileT, null, fs.mappedFileFinalizer },
+    .{"Pipeline", &PipelineT, null, pipelineFinalizer },
+    .{"Timer", &TimerT, null, timerFinalizer },
 };
 
 pub fn typeLoader(_: ?*cc.VM, info: cc.TypeInfo, out_: [*c]cc.TypeResult) callconv(.C) bool {
@@ -181,6 +222,14 @@ pub fn zPostTypeLoad(c: *cy.VMcompiler, mod: cc.ApiModule) !void {
         stdout.castHostObject(*fs.File).closed = true;
         vars[4] = .{ "stdout", stdout };
     }
+    // The VM keeps its own reference to stdin, so its line buffer outlives a reassigned `os.stdin`.
+    const cache = try getProcCache(c.vm);
+    if (cache.stdin) |old| {
+        c.vm.release(old);
+    }
+    c.vm.retain(vars[3].@"1");
+    cache.stdin = vars[3].@"1";
+
     vars[5] = .{ "system", try cy.heap.allocStringOrFail(c.vm, @tagName(builtin.os.tag)) };
     
     if (comptime std.simd.suggestVectorSize(u8)) |VecSize| {
@@ -194,6 +243,7 @@ pub fn zPostTypeLoad(c: *cy.VMcompiler, mod: cc.ApiModule) !void {
     CArrayT = chunkMod.getSym("CArray").?.cast(.object).type;
     CDimArrayT = chunkMod.getSym("CDimArray").?.cast(.object).type;
     nextUniqId = 1;
+    monoBaseOnce.call();
 }
 
 pub fn onLoad(vm_: ?*cc.VM, mod: cc.ApiModule) callconv(.C) void {
@@ -214,6 +264,181 @@ fn zPostLoad(self: *cy.VMcompiler, mod: cc.ApiModule) anyerror!void {
     }
 }
 
+pub fn onDestroy(vm_: ?*cc.VM, _: cc.ApiModule) callconv(.C) void {
+    const vm: *cy.VM = @ptrCast(@alignCast(vm_));
+    if (vm.osProcCache) |ptr| {
+        const cache: *ProcessCache = @ptrCast(@alignCast(ptr));
+        cache.deinit(vm);
+        vm.alloc.destroy(cache);
+        vm.osProcCache = null;
+    }
+}
+
+/// Max number of option specs with a cached `parseArgs` result.
+const MaxParsedArgs = 8;
+
+const ParsedArgs = struct {
+    options: []const ArgOption,
+    res: Value,
+};
+
+/// Per VM process state. The snapshots of the environment and arguments are made of interned strings.
+/// Each is built on first use and kept until it's invalidated. The environment is invalidated by `setEnv` and `unsetEnv`.
+/// The snapshots are returned to user code as is, so they are marked as GC roots by `markProcCache`.
+const ProcessCache = struct {
+    /// The `File` loaded as `os.stdin`. Its line buffer is shared by `readLine`, `readAll` and `stdinLines`.
+    stdin: ?Value = null,
+    env: ?Value = null,
+    args: ?Value = null,
+    /// `parseArgs` results by option spec, oldest first.
+    parsedArgs: std.ArrayListUnmanaged(ParsedArgs) = .{},
+
+    fn getEnv(self: *ProcessCache, vm: *cy.VM) !Value {
+        if (self.env) |env| {
+            return env;
+        }
+        var envMap = try std.process.getEnvMap(vm.alloc);
+        defer envMap.deinit();
+
+        const map = try vm.allocEmptyMap();
+        errdefer vm.release(map);
+        var iter = envMap.iterator();
+        while (iter.next()) |entry| {
+            const key = try vm.allocStringOrFail(entry.key_ptr.*);
+            const val = try vm.allocStringOrFail(entry.value_ptr.*);
+            defer {
+                vm.release(key);
+                vm.release(val);
+            }
+            try map.asHeapObject().map.set(vm, key, val);
+        }
+        self.env = map;
+        return map;
+    }
+
+    fn getArgs(self: *ProcessCache, vm: *cy.VM) !Value {
+        if (self.args) |args| {
+            return args;
+        }
+        var iter = try std.process.argsWithAllocator(vm.alloc);
+        defer iter.deinit();
+        const listv = try vm.allocEmptyList();
+        errdefer vm.release(listv);
+        const listo = listv.asHeapObject();
+        while (iter.next()) |arg| {
+            const str = try vm.allocStringOrFail(arg);
+            try listo.list.append(vm.alloc, str);
+        }
+        self.args = listv;
+        return listv;
+    }
+
+    fn findParsedArgs(self: *ProcessCache, options: []const ArgOption) ?Value {
+        outer: for (self.parsedArgs.items) |parsed| {
+            if (parsed.options.len != options.len) {
+                continue;
+            }
+            for (parsed.options, options) |a, b| {
+                if (!a.eql(b)) {
+                    continue :outer;
+                }
+            }
+            return parsed.res;
+        }
+        return null;
+    }
+
+    /// Takes ownership of `res` if successful.
+    fn putParsedArgs(self: *ProcessCache, vm: *cy.VM, options: []const ArgOption, res: Value) !void {
+        if (self.parsedArgs.items.len == MaxParsedArgs) {
+            releaseParsedArgs(vm, self.parsedArgs.orderedRemove(0));
+        }
+        const dupe = try vm.alloc.dupe(ArgOption, options);
+        for (dupe) |opt| {
+            vm.retain(opt.name);
+            vm.retain(opt.default);
+        }
+        self.parsedArgs.append(vm.alloc, .{ .options = dupe, .res = res }) catch |err| {
+            releaseParsedArgs(vm, .{ .options = dupe, .res = Value.None });
+            return err;
+        };
+    }
+
+    fn releaseParsedArgs(vm: *cy.VM, parsed: ParsedArgs) void {
+        for (parsed.options) |opt| {
+            vm.release(opt.name);
+            vm.release(opt.default);
+        }
+        vm.alloc.free(parsed.options);
+        vm.release(parsed.res);
+    }
+
+    fn mark(self: *ProcessCache, vm: *cy.VM) void {
+        if (self.env) |env| {
+            cy.arc.markValue(vm, env);
+        }
+        if (self.args) |args| {
+            cy.arc.markValue(vm, args);
+        }
+        for (self.parsedArgs.items) |parsed| {
+            cy.arc.markValue(vm, parsed.res);
+            for (parsed.options) |opt| {
+                if (opt.default.isCycPointer()) {
+                    cy.arc.markValue(vm, opt.default);
+                }
+            }
+        }
+    }
+
+    fn invalidateEnv(self: *ProcessCache, vm: *cy.VM) void {
+        if (self.env) |env| {
+            vm.release(env);
+            self.env = null;
+        }
+    }
+
+    fn deinit(self: *ProcessCache, vm: *cy.VM) void {
+        if (self.stdin) |stdin| {
+            vm.release(stdin);
+        }
+        self.invalidateEnv(vm);
+        if (self.args) |args| {
+            vm.release(args);
+            self.args = null;
+        }
+        for (self.parsedArgs.items) |parsed| {
+            releaseParsedArgs(vm, parsed);
+        }
+        self.parsedArgs.deinit(vm.alloc);
+        self.* = .{};
+    }
+};
+
+fn getProcCache(vm: *cy.VM) !*ProcessCache {
+    if (vm.osProcCache) |ptr| {
+        return @ptrCast(@alignCast(ptr));
+    }
+    const cache = try vm.alloc.create(ProcessCache);
+    cache.* = .{};
+    vm.osProcCache = cache;
+    return cache;
+}
+
+/// Called by the cycle collector, since the snapshots are only referenced by the VM.
+pub fn markProcCache(vm: *cy.VM) void {
+    if (vm.osProcCache) |ptr| {
+        const cache: *ProcessCache = @ptrCast(@alignCast(ptr));
+        cache.mark(vm);
+    }
+}
+
+fn invalidateEnvCache(vm: *cy.VM) void {
+    if (vm.osProcCache) |ptr| {
+        const cache: *ProcessCache = @ptrCast(@alignCast(ptr));
+        cache.invalidateEnv(vm);
+    }
+}
+
 fn openDir(vm: *cy.VM, args: [*]const Value, nargs: u8) linksection(cy.StdSection) anyerror!Value {
     if (cy.isWasm) return vm.prepPanic("Unsupported.");
     return openDir2(vm, &[_]Value{ args[0], Value.False }, nargs);
@@ -252,6 +477,56 @@ fn copyFile(vm: *cy.UserVM, args: [*]const Value, _: u8) linksection(cy.StdSecti
     return Value.None;
 }
 
+fn copyTree(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const numCopied = try fs_tree.copyTree(vm.alloc, args[0].asString(), args[1].asString(), .{});
+    return Value.initInt(@intCast(numCopied));
+}
+
+fn copyTreeExt(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const opts = args[2].asHeapObject().map.map();
+    var config: fs_tree.CopyOptions = .{};
+    if (opts.getByString("overwrite")) |overwrite| {
+        config.overwrite = overwrite.toBool();
+    }
+    if (opts.getByString("workers")) |workers| {
+        if (!workers.isInteger() or workers.asInteger() < 1) {
+            return error.InvalidArgument;
+        }
+        config.numWorkers = @intCast(@min(workers.asInteger(), std.math.maxInt(u32)));
+    }
+    const numCopied = try fs_tree.copyTree(vm.alloc, args[0].asString(), args[1].asString(), config);
+    return Value.initInt(@intCast(numCopied));
+}
+
+fn hashTree(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const algo: fs_tree.HashAlgo = switch (try std.meta.intToEnum(Symbol, args[1].asSymbolId())) {
+        .xxhash64 => .xxhash64,
+        .wyhash => .wyhash,
+        .sha256 => .sha256,
+        else => return error.InvalidArgument,
+    };
+    var res = try fs_tree.hashTree(vm.alloc, args[0].asString(), algo, 0);
+    defer res.deinit(vm.alloc);
+
+    const map = try vm.allocEmptyMap();
+    errdefer vm.release(map);
+    var hexBuf: [64]u8 = undefined;
+    for (res.paths(), res.digests) |path, digest| {
+        const hex = std.fmt.bufPrint(&hexBuf, "{}", .{std.fmt.fmtSliceHexLower(digest.slice())}) catch cy.fatal();
+        const key = try vm.allocStringOrFail(path);
+        const val = try vm.allocStringOrFail(hex);
+        defer {
+            vm.release(key);
+            vm.release(val);
+        }
+        try map.asHeapObject().map.set(vm, key, val);
+    }
+    return map;
+}
+
 fn removeFile(vm: *cy.UserVM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
     if (cy.isWasm) return vm.returnPanic("Unsupported.");
     const path = args[0].asString();
@@ -292,6 +567,14 @@ pub fn access(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
     return Value.None;
 }
 
+pub fn mapFile(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (!fs.hasMmap) return vm.prepPanic("Unsupported.");
+    const path = args[0].asString();
+    const file = try std.fs.cwd().openFile(path, .{});
+    defer file.close();
+    return fs.allocMappedFile(vm, file);
+}
+
 fn openFile(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
     if (cy.isWasm) return vm.prepPanic("Unsupported.");
     const path = args[0].asString();
@@ -308,26 +591,25 @@ fn openFile(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection)
     return fs.allocFile(vm, file.handle);
 }
 
-fn parseArgs(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
-    if (cy.isWasm) return vm.prepPanic("Unsupported.");
+const ArgOptionType = enum {
+    string,
+    float,
+    bool,
+};
 
-    const list = args[0].asHeapObject().list.items();
+const ArgOption = struct {
+    name: Value,
+    type: ArgOptionType,
+    default: Value,
 
-    // Build options map.
-    const OptionType = enum {
-        string,
-        float,
-        bool,
-    };
-    const Option = struct {
-        name: Value,
-        type: OptionType,
-        default: Value,
+    fn eql(self: ArgOption, other: ArgOption) bool {
+        // Defaults are compared by value bits, so an equal default in a different object only misses the cache.
+        return self.type == other.type and self.default.val == other.default.val and
+            std.mem.eql(u8, self.name.asString(), other.name.asString());
+    }
+};
 
-        found: bool,
-    };
-    var optionMap: std.StringHashMapUnmanaged(Option) = .{};
-    defer optionMap.deinit(vm.alloc);
+fn readArgOptions(vm: *cy.VM, list: []const Value, out: *std.ArrayListUnmanaged(ArgOption)) !void {
     for (list) |opt| {
         if (opt.isObjectType(bt.Map)) {
             const entry = opt.asHeapObject().map.map();
@@ -339,7 +621,7 @@ fn parseArgs(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
             if (!entryType.isObjectType(bt.MetaType)) {
                 return error.InvalidArgument;
             }
-            var optType: OptionType = undefined;
+            var optType: ArgOptionType = undefined;
             switch (entryType.asHeapObject().metatype.type) {
                 bt.String => {
                     optType = .string;
@@ -355,50 +637,97 @@ fn parseArgs(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
                 },
             }
             const default = entry.getByString("default") orelse Value.None;
-            try optionMap.put(vm.alloc, name.asString(), .{
+            try out.append(vm.alloc, .{
                 .name = name,
                 .type = optType,
                 .default = default,
-                .found = false,
             });
         } else {
             return error.InvalidArgument;
         }
     }
+}
+
+fn parseArgs(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (cy.isWasm) return vm.prepPanic("Unsupported.");
+
+    var options: std.ArrayListUnmanaged(ArgOption) = .{};
+    defer options.deinit(vm.alloc);
+    try readArgOptions(vm, args[0].asHeapObject().list.items(), &options);
+
+    const cache = try getProcCache(vm);
+    if (cache.findParsedArgs(options.items)) |res| {
+        vm.retain(res);
+        return res;
+    }
+    const res = try parseArgsFor(vm, try cache.getArgs(vm), options.items);
+    cache.putParsedArgs(vm, options.items, res) catch |err| {
+        vm.release(res);
+        return err;
+    };
+    vm.retain(res);
+    return res;
+}
+
+fn parseArgsFor(vm: *cy.VM, argsv: Value, options: []const ArgOption) !Value {
+    // Build options map.
+    const Option = struct {
+        opt: ArgOption,
+        found: bool,
+    };
+    var optionMap: std.StringHashMapUnmanaged(Option) = .{};
+    defer optionMap.deinit(vm.alloc);
+    for (options) |opt| {
+        try optionMap.put(vm.alloc, opt.name.asString(), .{
+            .opt = opt,
+            .found = false,
+        });
+    }
 
     const res = try vm.allocEmptyMap();
+    errdefer vm.release(res);
     const map = res.asHeapObject().map.map();
 
-    var iter = try std.process.argsWithAllocator(vm.alloc);
-    defer iter.deinit();
+    const argList = argsv.asHeapObject().list.items();
     const rest = try vm.allocEmptyList();
+    try map.put(vm.alloc, try vm.retainOrAllocAstring("rest"), rest);
     const restList = rest.asHeapObject().list.getList();
-    while (iter.next()) |arg| {
-        if (arg[0] == '-') {
+    var i: usize = 0;
+    while (i < argList.len) : (i += 1) {
+        const argv = argList[i];
+        if (!argv.isString()) {
+            // The args snapshot is shared with user code.
+            return error.InvalidArgument;
+        }
+        const arg = argv.asString();
+        if (arg.len > 0 and arg[0] == '-') {
             const optName = arg[1..];
-            if (optionMap.getPtr(optName)) |opt| {
-                if (opt.found) {
+            if (optionMap.getPtr(optName)) |entry| {
+                if (entry.found) {
                     continue;
                 }
+                const opt = entry.opt;
                 switch (opt.type) {
                     .string => {
-                        if (iter.next()) |nextArg| {
-                            const val = try vm.allocStringOrFail(nextArg);
+                        if (i + 1 < argList.len) {
+                            i += 1;
+                            vm.retain(argList[i]);
                             vm.retain(opt.name);
-                            try map.put(vm.alloc, opt.name, val);
-                            opt.found = true;
+                            try map.put(vm.alloc, opt.name, argList[i]);
+                            entry.found = true;
                         } else {
                             return error.InvalidArgument;
                         }
                     },
                     .float => {
-                        if (iter.next()) |nextArg| {
-                            const num = std.fmt.parseFloat(f64, nextArg) catch {
+                        if (i + 1 < argList.len) {
+                            i += 1;
+                            const num = std.fmt.parseFloat(f64, argList[i].asString()) catch {
                                 return error.InvalidArgument;
                             };
                             vm.retain(opt.name);
                             try map.put(vm.alloc, opt.name, Value.initF64(num));
-                            opt.found = true;
+                            entry.found = true;
                         } else {
                             return error.InvalidArgument;
                         }
@@ -406,41 +735,33 @@ fn parseArgs(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
                     .bool => {
                         vm.retain(opt.name);
                         try map.put(vm.alloc, opt.name, Value.True);
-                        opt.found = true;
+                        entry.found = true;
                     }
                 }
                 continue;
             }
         }
-        const str = try vm.allocStringOrFail(arg);
-        try restList.append(vm.alloc, str);
+        vm.retain(argv);
+        try restList.append(vm.alloc, argv);
     }
 
     // Fill missing with defaults.
     var optIter = optionMap.valueIterator();
-    while (optIter.next()) |opt| {
-        if (!opt.*.found) {
-            vm.retain(opt.*.name);
-            vm.retain(opt.*.default);
-            try map.put(vm.alloc, opt.*.name, opt.*.default);
+    while (optIter.next()) |entry| {
+        if (!entry.found) {
+            vm.retain(entry.opt.name);
+            vm.retain(entry.opt.default);
+            try map.put(vm.alloc, entry.opt.name, entry.opt.default);
         }
     }
-
-    try map.put(vm.alloc, try vm.retainOrAllocAstring("rest"), rest);
     return res;
 }
 
 fn osArgs(vm: *cy.VM, _: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
     if (cy.isWasm) return vm.prepPanic("Unsupported.");
-    var iter = try std.process.argsWithAllocator(vm.alloc);
-    defer iter.deinit();
-    const listv = try vm.allocEmptyList();
-    const listo = listv.asHeapObject();
-    while (iter.next()) |arg| {
-        const str = try vm.allocStringOrFail(arg);
-        try listo.list.append(vm.alloc, str);
-    }
-    return listv;
+    const list = try (try getProcCache(vm)).getArgs(vm);
+    vm.retain(list);
+    return list;
 }
 
 pub fn cwd(vm: *cy.VM, _: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
@@ -461,28 +782,21 @@ pub fn exePath(vm: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
 
 pub fn getEnv(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
     if (cy.isWasm or builtin.os.tag == .windows) return vm.prepPanic("Unsupported.");
-    const key = args[0].asString();
-    const res = std.os.getenv(key) orelse return Value.None;
-    return vm.allocStringOrFail(res);
+    const env = try (try getProcCache(vm)).getEnv(vm);
+    const res = env.asHeapObject().map.map().getByString(args[0].asString()) orelse return Value.None;
+    if (!res.isString()) {
+        // The env snapshot is shared with user code.
+        return Value.None;
+    }
+    vm.retain(res);
+    return res;
 }
 
 pub fn getEnvAll(vm: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
     if (cy.isWasm or builtin.os.tag == .windows) return vm.prepPanic("Unsupported.");
-    var env = try std.process.getEnvMap(vm.alloc);
-    defer env.deinit();
-
-    const map = try vm.allocEmptyMap();
-    var iter = env.iterator();
-    while (iter.next()) |entry| {
-        const key = try vm.allocStringOrFail(entry.key_ptr.*);
-        const val = try vm.allocStringOrFail(entry.value_ptr.*);
-        defer {
-            vm.release(key);
-            vm.release(val);
-        }
-        try map.asHeapObject().map.set(vm, key, val);
-    }
-    return map;
+    const env = try (try getProcCache(vm)).getEnv(vm);
+    vm.retain(env);
+    return env;
 }
 
 pub fn free(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
@@ -535,6 +849,84 @@ pub fn now(_: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
     return Value.initF64(@as(f64, @floatFromInt(ns)) / @as(f64, std.time.ns_per_s));
 }
 
+/// Monotonic readings are relative to when the module was first loaded so they fit in an `int` for about 39 hours.
+/// The base is shared by every VM in the process so readings never go backwards.
+var monoBase: if (builtin.os.tag == .linux) u64 else std.time.Instant = undefined;
+var monoBaseOnce = std.once(initMonoBase);
+
+fn initMonoBase() void {
+    if (builtin.os.tag == .linux) {
+        monoBase = 0;
+        monoBase = monoNow() catch 0;
+    } else {
+        monoBase = std.time.Instant.now() catch std.mem.zeroes(std.time.Instant);
+    }
+}
+
+fn timespecNanos(ts: std.os.timespec) u64 {
+    return @as(u64, @intCast(ts.tv_sec)) * std.time.ns_per_s + @as(u64, @intCast(ts.tv_nsec));
+}
+
+fn monoNow() !u64 {
+    if (builtin.os.tag == .linux) {
+        // `Instant` reads `CLOCK_BOOTTIME` which also advances while suspended.
+        return timespecNanos(try std.os.clock_gettime(std.os.CLOCK.MONOTONIC)) -% monoBase;
+    } else {
+        return (try std.time.Instant.now()).since(monoBase);
+    }
+}
+
+fn initNanos(ns: u64) Value {
+    return Value.initInt(@intCast(@min(ns, std.math.maxInt(i48))));
+}
+
+pub fn monoNanos(vm: *cy.VM, _: [*]const Value, _: u8) Value {
+    const ns = monoNow() catch return vm.prepPanic("Unsupported.");
+    return initNanos(ns);
+}
+
+pub fn cpuNanos(vm: *cy.VM, _: [*]const Value, _: u8) Value {
+    if (cy.isWasm or builtin.os.tag == .windows) return vm.prepPanic("Unsupported.");
+    const ts = std.os.clock_gettime(std.os.CLOCK.THREAD_CPUTIME_ID) catch return vm.prepPanic("Unsupported.");
+    return initNanos(timespecNanos(ts));
+}
+
+pub fn newTimer(vm: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
+    const start = monoNow() catch return vm.prepPanic("Unsupported.");
+    const timer: *Timer = @ptrCast(@alignCast(try cy.heap.allocHostNoCycObject(vm, TimerT, @sizeOf(Timer))));
+    timer.* = .{ .start = start };
+    return Value.initHostNoCycPtr(timer);
+}
+
+pub const Timer = extern struct {
+    /// Monotonic reading of the last `lap` or `reset`.
+    start: u64,
+};
+
+pub var TimerT: cy.TypeId = undefined;
+
+/// Timers own no resources, but the heap only frees host objects that have a finalizer.
+pub fn timerFinalizer(_: ?*cc.VM, _: ?*anyopaque) callconv(.C) void {}
+
+pub fn timerLap(vm: *cy.VM, args: [*]const Value, _: u8) Value {
+    const timer = args[0].castHostObject(*Timer);
+    const cur = monoNow() catch return vm.prepPanic("Unsupported.");
+    defer timer.start = cur;
+    return initNanos(cur -| timer.start);
+}
+
+pub fn timerRead(vm: *cy.VM, args: [*]const Value, _: u8) Value {
+    const timer = args[0].castHostObject(*Timer);
+    const cur = monoNow() catch return vm.prepPanic("Unsupported.");
+    return initNanos(cur -| timer.start);
+}
+
+pub fn timerReset(vm: *cy.VM, args: [*]const Value, _: u8) Value {
+    const timer = args[0].castHostObject(*Timer);
+    timer.start = monoNow() catch return vm.prepPanic("Unsupported.");
+    return Value.None;
+}
+
 pub fn milliTime(_: *cy.VM, _: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     return Value.initF64(@floatFromInt(stdx.time.getMilliTimestamp()));
 }
@@ -558,16 +950,17 @@ pub fn realPath(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
     return vm.allocStringOrFail(res);
 }
 
-pub fn setEnv(vm: *cy.UserVM, args: [*]const Value, _: u8) anyerror!Value {
-    if (cy.isWasm or builtin.os.tag == .windows) return vm.returnPanic("Unsupported.");
+pub fn setEnv(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (cy.isWasm or builtin.os.tag == .windows) return vm.prepPanic("Unsupported.");
     const key = args[0].asString();
-    const keyz = try vm.allocator().dupeZ(u8, key);
-    defer vm.allocator().free(keyz);
+    const keyz = try vm.alloc.dupeZ(u8, key);
+    defer vm.alloc.free(keyz);
 
     const value = args[1].asString();
-    const valuez = try vm.allocator().dupeZ(u8, value);
-    defer vm.allocator().free(valuez);
+    const valuez = try vm.alloc.dupeZ(u8, value);
+    defer vm.alloc.free(valuez);
     _ = setenv(keyz, valuez, 1);
+    invalidateEnvCache(vm);
     return Value.None;
 }
 pub extern "c" fn setenv(name: [*:0]const u8, value: [*:0]const u8, overwrite: c_int) c_int;
@@ -597,6 +990,7 @@ pub fn unsetEnv(vm: *cy.VM, args: [*]const Value, _: u8) Value {
     const keyz = vm.alloc.dupeZ(u8, key) catch cy.fatal();
     defer vm.alloc.free(keyz);
     _ = unsetenv(keyz);
+    invalidateEnvCache(vm);
     return Value.None;
 }
 pub extern "c" fn unsetenv(name: [*:0]const u8) c_int;
@@ -709,6 +1103,167 @@ pub fn execCmd(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSectio
     return map;
 }
 
+/// Converts each stage's arguments to strings. The result is owned by `arena`.
+fn allocStageArgs(vm: *cy.VM, arena: std.mem.Allocator, stagesv: Value) ![]const []const []const u8 {
+    const stages = stagesv.asHeapObject().list.items();
+    const argvs = try arena.alloc([]const []const u8, stages.len);
+    for (stages, argvs) |stage, *argv| {
+        if (!stage.isList()) {
+            return error.InvalidArgument;
+        }
+        const stageArgs = stage.asHeapObject().list.items();
+        const strs = try arena.alloc([]const u8, stageArgs.len);
+        for (stageArgs, strs) |arg, *str| {
+            str.* = try arena.dupe(u8, try vm.getOrBufPrintValueStr(&cy.tempBuf, arg));
+        }
+        argv.* = strs;
+    }
+    return argvs;
+}
+
+fn spawnPipeline(vm: *cy.VM, stagesv: Value, stages: *[]pipeline.Stage) !pipeline.Fd {
+    var arena = std.heap.ArenaAllocator.init(vm.alloc);
+    defer arena.deinit();
+    const argvs = try allocStageArgs(vm, arena.allocator(), stagesv);
+    stages.* = try vm.alloc.alloc(pipeline.Stage, argvs.len);
+    errdefer vm.alloc.free(stages.*);
+    return pipeline.spawn(vm.alloc, argvs, stages.*);
+}
+
+fn allocExitCodes(vm: *cy.VM, stages: []const pipeline.Stage) !Value {
+    const codes = try vm.alloc.alloc(Value, stages.len);
+    defer vm.alloc.free(codes);
+    for (stages, codes) |stage, *code| {
+        if (stage.exitCode()) |exitCode| {
+            code.* = Value.initInt(exitCode);
+        } else {
+            code.* = Value.None;
+        }
+    }
+    return cy.heap.allocList(vm, codes);
+}
+
+fn osPipeline(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!pipeline.Supported) return vm.prepPanic("Unsupported.");
+    var stages: []pipeline.Stage = undefined;
+    const fd = try spawnPipeline(vm, args[0], &stages);
+    defer vm.alloc.free(stages);
+
+    const file = std.fs.File{ .handle = fd };
+    const res = file.readToEndAlloc(vm.alloc, std.math.maxInt(usize));
+    // Closing the output first lets the last stage exit if reading failed.
+    file.close();
+    pipeline.waitAll(stages);
+    const out = try res;
+    defer vm.alloc.free(out);
+
+    const map = try vm.allocEmptyMap();
+    errdefer vm.release(map);
+    const outKey = try vm.retainOrAllocAstring("out");
+    const exitedKey = try vm.retainOrAllocAstring("exited");
+    defer {
+        vm.release(outKey);
+        vm.release(exitedKey);
+    }
+    const outv = try vm.allocStringInternOrArray(out);
+    defer vm.release(outv);
+    try map.asHeapObject().map.set(vm, outKey, outv);
+    const exited = try allocExitCodes(vm, stages);
+    defer vm.release(exited);
+    try map.asHeapObject().map.set(vm, exitedKey, exited);
+    return map;
+}
+
+fn osPipelineExt(vm: *cy.VM, args: [*]const Value, nargs: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!pipeline.Supported) return vm.prepPanic("Unsupported.");
+    const opts = args[1].asHeapObject().map.map();
+    const lines = if (opts.getByString("lines")) |lines| lines.toBool() else false;
+    if (!lines) {
+        return osPipeline(vm, args, nargs);
+    }
+
+    var stages: []pipeline.Stage = undefined;
+    const fd = try spawnPipeline(vm, args[0], &stages);
+    const p: *Pipeline = @ptrCast(@alignCast(cy.heap.allocHostNoCycObject(vm, PipelineT, @sizeOf(Pipeline)) catch |err| {
+        std.os.close(fd);
+        pipeline.waitAll(stages);
+        vm.alloc.free(stages);
+        return err;
+    }));
+    p.* = .{
+        .out = .{
+            .fd = fd,
+            .curPos = 0,
+            .iterLines = false,
+            .hasReadBuf = false,
+            .readBuf = undefined,
+            .readBufCap = 0,
+            .readBufEnd = 0,
+            .closed = false,
+            .closeOnFree = true,
+            .lineBuf = null,
+            .lineStart = 0,
+            .lineEnd = 0,
+        },
+        .stages = stages.ptr,
+        .numStages = @intCast(stages.len),
+        .done = false,
+    };
+    return Value.initHostNoCycPtr(p);
+}
+
+/// Running stages whose final output is read line by line.
+pub const Pipeline = extern struct {
+    /// Read end of the last stage's stdout.
+    out: fs.File,
+    stages: [*]pipeline.Stage,
+    numStages: u32,
+    done: bool,
+
+    fn getStages(self: *Pipeline) []pipeline.Stage {
+        return self.stages[0..self.numStages];
+    }
+
+    /// Closing the output first ensures the last stage doesn't block on a full pipe.
+    fn wait(self: *Pipeline) void {
+        self.out.close();
+        self.done = true;
+        pipeline.waitAll(self.getStages());
+    }
+};
+
+pub var PipelineT: cy.TypeId = undefined;
+
+pub fn pipelineFinalizer(vm_: ?*cc.VM, obj: ?*anyopaque) callconv(.C) void {
+    const vm: *cy.VM = @ptrCast(@alignCast(vm_));
+    if (pipeline.Supported) {
+        const p: *Pipeline = @ptrCast(@alignCast(obj));
+        if (p.out.lineBuf) |buf| {
+            cy.arc.releaseObject(vm, buf);
+        }
+        p.wait();
+        vm.alloc.free(p.getStages());
+    }
+}
+
+pub fn pipelineIterator(vm: *cy.VM, args: [*]const Value, _: u8) Value {
+    vm.retain(args[0]);
+    return args[0];
+}
+
+pub fn pipelineNext(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (!pipeline.Supported) return vm.prepPanic("Unsupported.");
+    const p = args[0].castHostObject(*Pipeline);
+    return nextBufferedLine(vm, &p.out, &p.done);
+}
+
+pub fn pipelineWait(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (!pipeline.Supported) return vm.prepPanic("Unsupported.");
+    const p = args[0].castHostObject(*Pipeline);
+    p.wait();
+    return allocExitCodes(vm, p.getStages());
+}
+
 pub fn exit(_: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) Value {
     const status: u8 = @intCast(args[0].asInteger());
     std.os.exit(status);
@@ -730,20 +1285,195 @@ pub fn fetchUrl(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
 
 extern fn hostFetchUrl(url: [*]const u8, urlLen: usize) void;
 
+/// Initial capacity of a line buffer. Stdin's buffer is shared by `readLine`, `readAll`, and `stdinLines`.
+const LineBufSize = 64 * 1024;
+
+fn getStdin(vm: *cy.VM) *fs.File {
+    const cache: *ProcessCache = @ptrCast(@alignCast(vm.osProcCache.?));
+    return cache.stdin.?.castHostObject(*fs.File);
+}
+
+fn getPendingBytes(file: *fs.File) []const u8 {
+    if (file.lineBuf) |buf| {
+        return buf.astring.getSlice()[file.lineStart..file.lineEnd];
+    } else return &.{};
+}
+
+/// Reads more of the file into the line buffer after the unread bytes.
+/// Returns `false` at the end of the file.
+fn fillLineBuf(vm: *cy.VM, file: *fs.File) !bool {
+    const cap: u32 = if (file.lineBuf) |buf| @intCast(buf.astring.getSlice().len) else 0;
+    if (file.lineEnd == cap) {
+        const pending = file.lineEnd - file.lineStart;
+        var newCap: u32 = LineBufSize;
+        while (newCap <= pending) {
+            newCap *= 2;
+        }
+        if (newCap == cap and file.lineBuf.?.head.rc == 1) {
+            // No lines are sliced from the buffer so the unread bytes can be moved to the front.
+            const bytes = file.lineBuf.?.astring.getMutSlice();
+            std.mem.copyForwards(u8, bytes[0..pending], bytes[file.lineStart..file.lineEnd]);
+        } else {
+            const newBuf = try vm.allocUnsetAstringObject(newCap);
+            @memcpy(newBuf.astring.getMutSlice()[0..pending], getPendingBytes(file));
+            if (file.lineBuf) |buf| {
+                vm.releaseObject(buf);
+            }
+            file.lineBuf = newBuf;
+        }
+        file.lineStart = 0;
+        file.lineEnd = pending;
+    }
+    const bytes = file.lineBuf.?.astring.getMutSlice();
+    const numRead = try file.getStdFile().read(bytes[file.lineEnd..]);
+    file.lineEnd += @intCast(numRead);
+    return numRead > 0;
+}
+
+/// Returns the next buffered line without the `\n` and consumes it.
+/// Returns null if the file ends before the next `\n`. The unread bytes are then left in the buffer.
+/// The line is only valid until the next read.
+fn readBufferedLine(vm: *cy.VM, file: *fs.File) !?[]const u8 {
+    var searched: u32 = 0;
+    while (true) {
+        const pending = getPendingBytes(file);
+        if (cy.indexOfChar(pending[searched..], '\n')) |idx| {
+            const end = searched + idx;
+            file.lineStart += @intCast(end + 1);
+            return pending[0..end];
+        }
+        searched = @intCast(pending.len);
+        if (!try fillLineBuf(vm, file)) {
+            return null;
+        }
+    }
+}
+
+/// Allocates a string for a line of the line buffer.
+/// Short lines are interned copies. Longer lines are slices that share the buffer.
+fn allocBufferedLine(vm: *cy.VM, file: *fs.File, line: []const u8) !Value {
+    if (line.len <= cy.heap.DefaultStringInternMaxByteLen) {
+        return vm.allocStringOrFail(line);
+    }
+    const charLen = cy.validateUtf8(line) orelse return error.Unicode;
+    const buf = file.lineBuf.?;
+    vm.retainObject(buf);
+    if (charLen == line.len) {
+        return vm.allocAstringSlice(line, buf);
+    } else {
+        return vm.allocUstringSlice(line, @intCast(charLen), buf);
+    }
+}
+
 pub fn readLine(vm: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
     if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
-    const input = try std.io.getStdIn().reader().readUntilDelimiterAlloc(vm.alloc, '\n', 10e8);
-    defer vm.alloc.free(input);
-    // TODO: Use allocOwnedString
-    return vm.allocStringOrFail(input);
+    const file = getStdin(vm);
+    const line = (try readBufferedLine(vm, file)) orelse return error.EndOfStream;
+    return allocBufferedLine(vm, file, line);
 }
 
 pub fn readAll(vm: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
     if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
-    const input = try std.io.getStdIn().readToEndAlloc(vm.alloc, 10e8);
-    defer vm.alloc.free(input);
-    // TODO: Use allocOwnString.
-    return vm.allocStringOrFail(input);
+    const file = getStdin(vm);
+    const pending = getPendingBytes(file);
+    const stdFile = file.getStdFile();
+
+    const stat = try stdFile.stat();
+    if (stat.kind == .file) {
+        // The size of a redirected file is known so it's read directly into the returned string.
+        const rest: usize = @intCast(stat.size -| try stdFile.getPos());
+        const obj = try vm.allocUnsetAstringObject(pending.len + rest);
+        const dst = obj.astring.getMutSlice();
+        @memcpy(dst[0..pending.len], pending);
+        const numRead = stdFile.readAll(dst[pending.len..]) catch |err| {
+            vm.releaseObject(obj);
+            return err;
+        };
+        file.lineStart = file.lineEnd;
+        if (numRead < rest) {
+            // Truncated while reading.
+            defer vm.releaseObject(obj);
+            return vm.allocStringOrFail(dst[0..pending.len + numRead]);
+        }
+        if (cy.validateUtf8(dst)) |charLen| {
+            if (charLen == dst.len) {
+                return vm.allocOwnedAstring(obj);
+            } else {
+                defer vm.releaseObject(obj);
+                return cy.heap.allocUstring(vm, dst, @intCast(charLen));
+            }
+        } else {
+            vm.releaseObject(obj);
+            return error.Unicode;
+        }
+    }
+
+    const tempBuf = &vm.u8Buf;
+    tempBuf.clearRetainingCapacity();
+    defer tempBuf.ensureMaxCapOrClear(vm.alloc, 4096) catch cy.fatal();
+    try tempBuf.appendSlice(vm.alloc, pending);
+    file.lineStart = file.lineEnd;
+
+    const MinReadBufSize = 4096;
+    while (true) {
+        try tempBuf.ensureUnusedCapacity(vm.alloc, MinReadBufSize);
+        const buf = tempBuf.buf[tempBuf.len..tempBuf.buf.len];
+        const numRead = try stdFile.read(buf);
+        if (numRead == 0) {
+            return vm.allocStringOrFail(tempBuf.items());
+        }
+        tempBuf.len += numRead;
+    }
+}
+
+pub fn stdinLines(vm: *cy.VM, _: [*]const Value, _: u8) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const lines: *StdinLines = @ptrCast(@alignCast(try cy.heap.allocHostNoCycObject(vm, StdinLinesT, @sizeOf(StdinLines))));
+    lines.* = .{ .done = false };
+    return Value.initHostNoCycPtr(lines);
+}
+
+pub const StdinLines = extern struct {
+    /// Set once stdin has ended so a terminal isn't read again.
+    done: bool,
+};
+
+pub var StdinLinesT: cy.TypeId = undefined;
+
+/// Stdin's buffer is owned by the VM's stdin `File`, so there is nothing to release.
+/// Needed so the object itself is freed.
+pub fn stdinLinesFinalizer(_: ?*cc.VM, _: ?*anyopaque) callconv(.C) void {}
+
+pub fn stdinLinesIterator(vm: *cy.VM, args: [*]const Value, _: u8) Value {
+    vm.retain(args[0]);
+    return args[0];
+}
+
+pub fn stdinLinesNext(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const lines = args[0].castHostObject(*StdinLines);
+    return nextBufferedLine(vm, getStdin(vm), &lines.done);
+}
+
+/// Returns the next line without the line ending or `none` once `done` is set.
+fn nextBufferedLine(vm: *cy.VM, file: *fs.File, done: *bool) !Value {
+    if (done.*) {
+        return Value.None;
+    }
+    var line = (try readBufferedLine(vm, file)) orelse b: {
+        done.* = true;
+        // The last line doesn't need to end with a `\n`.
+        const rest = getPendingBytes(file);
+        if (rest.len == 0) {
+            return Value.None;
+        }
+        file.lineStart = file.lineEnd;
+        break :b rest;
+    };
+    if (line.len > 0 and line[line.len-1] == '\r') {
+        line = line[0..line.len-1];
+    }
+    return allocBufferedLine(vm, file, line);
 }
 
 pub fn readFile(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
@@ -756,10 +1486,141 @@ pub fn readFile(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
     return vm.allocStringOrFail(content);
 }
 
+/// Reads are IO bound, so the pool can have more threads than cpus.
+const ReadFilesWorkers = 16;
+
+pub fn readFiles(vm: *cy.VM, args: [*]const Value, _: u8) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const pathvs = args[0].asHeapObject().list.items();
+    const paths = try vm.alloc.alloc([]const u8, pathvs.len);
+    defer vm.alloc.free(paths);
+    for (pathvs, paths) |pathv, *path| {
+        if (!pathv.isString()) {
+            return error.InvalidArgument;
+        }
+        path.* = pathv.asString();
+    }
+
+    var numTaken: usize = 0;
+    const results = try fs_tree.readFiles(vm.alloc, paths, 10e8, cy.heap.OwnedBufHeaderLen, ReadFilesWorkers);
+    defer {
+        // Buffers before `numTaken` were handed over to the VM.
+        for (results[numTaken..]) |res| {
+            if (res == .data) {
+                vm.alloc.free(res.data);
+            }
+        }
+        vm.alloc.free(results);
+    }
+    const elems = try vm.alloc.alloc(Value, results.len);
+    var numElems: usize = 0;
+    errdefer {
+        for (elems[0..numElems]) |elem| {
+            vm.release(elem);
+        }
+        vm.alloc.free(elems);
+    }
+    for (results, 0..) |res, i| {
+        switch (res) {
+            .data => |data| {
+                // Takes ownership of `data` even on failure.
+                numTaken = i + 1;
+                elems[i] = try vm.allocOwnedStringOrArray(data);
+            },
+            .err => |err| {
+                elems[i] = Value.initErrorSymbol(@intFromEnum(builtins.zErrorSymbol(err)));
+            },
+        }
+        numElems += 1;
+    }
+    return cy.heap.allocOwnedList(vm, elems);
+}
+
 pub fn writeFile(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
     if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
     const path = args[0].asString();
-    const content = try vm.getOrBufPrintValueRawStr(&cy.tempBuf, args[1]);
-    try std.fs.cwd().writeFile(path, content);
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    try writeContents(vm, file, args[1], 0);
+    return Value.None;
+}
+
+pub fn appendFile(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const path = args[0].asString();
+    const file = try std.fs.cwd().createFile(path, .{ .truncate = false });
+    defer file.close();
+    try file.seekFromEnd(0);
+    try writeContents(vm, file, args[1], null);
+    return Value.None;
+}
+
+pub fn writeFileAtomic(vm: *cy.VM, args: [*]const Value, _: u8) linksection(cy.StdSection) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+    const path = args[0].asString();
+    var atomic = try std.fs.cwd().atomicFile(path, .{});
+    defer atomic.deinit();
+    try writeContents(vm, atomic.file, args[1], 0);
+    try atomic.finish();
     return Value.None;
+}
+
+/// Max number of parts written with one vectored write.
+const MaxWriteParts = 64;
+
+/// Writes `contents` at `offset`, or at the current position if `offset` is null.
+/// A `List` of parts is written with vectored writes instead of being concatenated.
+fn writeContents(vm: *cy.VM, file: std.fs.File, contents: Value, offset: ?u64) !void {
+    if (!contents.isList()) {
+        const bytes = try fs.getWriteBytes(vm, contents);
+        if (offset) |off| {
+            try file.pwriteAll(bytes, off);
+        } else {
+            try file.writeAll(bytes);
+        }
+        return;
+    }
+
+    var iovecs: [MaxWriteParts]std.os.iovec_const = undefined;
+    var numIovecs: usize = 0;
+    var pos = offset;
+    const parts = contents.asHeapObject().list.items();
+    for (parts) |part| {
+        if (!part.isString() and !part.isArray()) {
+            // Printed parts share the temp string so they are written separately.
+            try writeIovecs(file, iovecs[0..numIovecs], &pos);
+            numIovecs = 0;
+            const bytes = try fs.getWriteBytes(vm, part);
+            var iovec = [1]std.os.iovec_const{ .{ .iov_base = bytes.ptr, .iov_len = bytes.len } };
+            try writeIovecs(file, &iovec, &pos);
+            continue;
+        }
+        const bytes = if (part.isString()) part.asString() else part.asArray();
+        if (bytes.len == 0) {
+            continue;
+        }
+        iovecs[numIovecs] = .{ .iov_base = bytes.ptr, .iov_len = bytes.len };
+        numIovecs += 1;
+        if (numIovecs == MaxWriteParts) {
+            try writeIovecs(file, &iovecs, &pos);
+            numIovecs = 0;
+        }
+    }
+    try writeIovecs(file, iovecs[0..numIovecs], &pos);
+}
+
+fn writeIovecs(file: std.fs.File, iovecs: []std.os.iovec_const, pos: *?u64) !void {
+    if (iovecs.len == 0) {
+        return;
+    }
+    if (pos.*) |off| {
+        var len: u64 = 0;
+        for (iovecs) |iovec| {
+            len += iovec.iov_len;
+        }
+        try file.pwritevAll(iovecs, off);
+        pos.* = off + len;
+    } else {
+        try file.writevAll(iovecs);
+    }
 }
\ No newline at end of file
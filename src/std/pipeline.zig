@@ -0,0 +1,108 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const cy = @import("../cyber.zig");
+
+const log = cy.log.scoped(.pipeline);
+
+pub const Supported = cy.hasStdFiles and builtin.os.tag != .windows;
+pub const Pid = if (Supported) std.os.pid_t else i32;
+pub const Fd = if (Supported) std.os.fd_t else i32;
+
+/// Exit code reported for a stage that could not be started. Matches the shell's code for a missing command.
+const ExecFailedCode = 127;
+
+pub const Stage = extern struct {
+    pid: Pid,
+    /// Raw `waitpid` status. Only valid once `waited` is set.
+    status: u32,
+    waited: bool,
+
+    /// Returns null if the stage was terminated by a signal.
+    pub fn exitCode(self: *const Stage) ?u8 {
+        if (std.os.W.IFEXITED(self.status)) {
+            return std.os.W.EXITSTATUS(self.status);
+        }
+        return null;
+    }
+};
+
+/// Starts every stage with its stdout connected to the next stage's stdin by a pipe.
+/// The first stage reads from `/dev/null`. Returns the read end of the last stage's stdout.
+/// Data between stages never passes through the caller.
+pub fn spawn(alloc: std.mem.Allocator, argvs: []const []const []const u8, out: []Stage) !Fd {
+    if (argvs.len == 0) {
+        return error.InvalidArgument;
+    }
+    for (argvs) |argv| {
+        if (argv.len == 0) {
+            return error.InvalidArgument;
+        }
+    }
+
+    // Everything the children need is prepared before forking so a child never allocates.
+    var arena = std.heap.ArenaAllocator.init(alloc);
+    defer arena.deinit();
+    const cargvs = try arena.allocator().alloc([:null]?[*:0]const u8, argvs.len);
+    for (argvs, cargvs) |argv, *cargv| {
+        cargv.* = try arena.allocator().allocSentinel(?[*:0]const u8, argv.len, null);
+        for (argv, 0..) |arg, i| {
+            cargv.*[i] = try arena.allocator().dupeZ(u8, arg);
+        }
+    }
+    const envp: [*:null]const ?[*:0]const u8 = if (builtin.link_libc) std.c.environ else @ptrCast(std.os.environ.ptr);
+
+    var prevRead = try std.os.openZ("/dev/null", std.os.O.RDONLY | std.os.O.CLOEXEC, 0);
+    var numSpawned: usize = 0;
+    errdefer {
+        std.os.close(prevRead);
+        for (out[0..numSpawned]) |*stage| {
+            std.os.kill(stage.pid, std.os.SIG.KILL) catch {};
+            wait(stage);
+        }
+    }
+    for (cargvs) |cargv| {
+        const fds = try std.os.pipe2(std.os.O.CLOEXEC);
+        const pid = std.os.fork() catch |err| {
+            std.os.close(fds[0]);
+            std.os.close(fds[1]);
+            return err;
+        };
+        if (pid == 0) {
+            // `dup2` clears `CLOEXEC` on the new descriptors. Every other pipe end is closed by `exec`.
+            std.os.dup2(prevRead, std.os.STDIN_FILENO) catch childExit();
+            std.os.dup2(fds[1], std.os.STDOUT_FILENO) catch childExit();
+            std.os.execvpeZ(cargv[0].?, cargv.ptr, envp) catch {};
+            childExit();
+        }
+        log.tracev("spawned {s} pid={}", .{cargv[0].?, pid});
+        out[numSpawned] = .{ .pid = pid, .status = 0, .waited = false };
+        numSpawned += 1;
+
+        // Only the children keep the ends they were given.
+        std.os.close(fds[1]);
+        std.os.close(prevRead);
+        prevRead = fds[0];
+    }
+    return prevRead;
+}
+
+/// Skips `atexit` handlers registered in the parent.
+fn childExit() noreturn {
+    if (builtin.link_libc) {
+        std.c._exit(ExecFailedCode);
+    }
+    std.os.exit(ExecFailedCode);
+}
+
+pub fn wait(stage: *Stage) void {
+    if (!stage.waited) {
+        stage.status = std.os.waitpid(stage.pid, 0).status;
+        stage.waited = true;
+    }
+}
+
+pub fn waitAll(stages: []Stage) void {
+    for (stages) |*stage| {
+        wait(stage);
+    }
+}
@@ -0,0 +1,5 @@
+/// Cooperative fiber scheduler and channels.
+/// The module is written in Cyber since only bytecode can switch fibers.
+/// Parked fibers are removed from the run queue and are only resumed again by the
+/// channel operation or sleep deadline that unparks them.
+pub const Src = @embedFile("sched.cy");
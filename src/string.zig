@@ -274,39 +274,184 @@ pub fn isAstring(str: []const u8) linksection(cy.Section) bool {
     }
 }
 
+/// Shift based UTF-8 DFA. Each state is a bit offset into a row of `Utf8Dfa` and the
+/// row for the next byte holds the next state of every current state.
+/// States: accept, reject, need 1 continuation, need 2, after E0, after ED,
+/// need 3, after F0, after F4. Rejects overlong encodings, surrogates and code points above U+10FFFF.
+const Utf8Accept: u64 = 0;
+const Utf8Reject: u64 = 6;
+const Utf8Dfa: [256]u64 = b: {
+    @setEvalBranchQuota(10000);
+    const accept = 0;
+    const reject = 1;
+    const cont1 = 2;
+    const cont2 = 3;
+    const afterE0 = 4;
+    const afterED = 5;
+    const cont3 = 6;
+    const afterF0 = 7;
+    const afterF4 = 8;
+    var table: [256]u64 = undefined;
+    for (&table, 0..) |*row, byte| {
+        const next = [9]u64{
+            // accept
+            switch (byte) {
+                0x00...0x7f => accept,
+                0xc2...0xdf => cont1,
+                0xe0 => afterE0,
+                0xe1...0xec, 0xee...0xef => cont2,
+                0xed => afterED,
+                0xf0 => afterF0,
+                0xf1...0xf3 => cont3,
+                0xf4 => afterF4,
+                else => reject,
+            },
+            reject,
+            if (byte >= 0x80 and byte <= 0xbf) accept else reject,
+            if (byte >= 0x80 and byte <= 0xbf) cont1 else reject,
+            if (byte >= 0xa0 and byte <= 0xbf) cont1 else reject,
+            if (byte >= 0x80 and byte <= 0x9f) cont1 else reject,
+            if (byte >= 0x80 and byte <= 0xbf) cont2 else reject,
+            if (byte >= 0x90 and byte <= 0xbf) cont2 else reject,
+            if (byte >= 0x80 and byte <= 0x8f) cont2 else reject,
+        };
+        row.* = 0;
+        for (next, 0..) |nextState, state| {
+            row.* |= (nextState * 6) << @as(u6, @intCast(state * 6));
+        }
+    }
+    break :b table;
+};
+
+inline fn utf8DfaStep(state: u64, byte: u8) u64 {
+    return (Utf8Dfa[byte] >> @intCast(state)) & 63;
+}
+
+fn utf8DfaRun(state_: u64, s: []const u8) linksection(cy.Section) u64 {
+    var state = state_;
+    for (s) |byte| {
+        state = utf8DfaStep(state, byte);
+    }
+    return state;
+}
+
+/// Number of bytes that are not continuation bytes.
+fn countRuneStarts(s: []const u8) linksection(cy.Section) usize {
+    var n: usize = 0;
+    for (s) |byte| {
+        n += @intFromBool(byte & 0xc0 != 0x80);
+    }
+    return n;
+}
+
 /// Validates a UTF-8 string and returns the char length.
 /// If the char length returned is the same as the byte len, it's also a valid ascii string.
-/// TODO: Implement SIMD version.
+/// Blocks of ASCII are skipped with a vector test. Other blocks are validated by the DFA
+/// while their runes are counted with a vector compare.
 pub fn validateUtf8(s: []const u8) linksection(cy.Section) ?usize {
+    var state = Utf8Accept;
     var charLen: usize = 0;
     var i: usize = 0;
-    while (i < s.len) {
-        const cp_len = std.unicode.utf8ByteSequenceLength(s[i]) catch return null;
-        if (i + cp_len > s.len) {
-            return null;
+    if (comptime std.simd.suggestVectorSize(u8)) |VecSize| {
+        const MaskInt = std.meta.Int(.unsigned, VecSize);
+        const contMask: @Vector(VecSize, u8) = @splat(@as(u8, 0xc0));
+        const contTag: @Vector(VecSize, u8) = @splat(@as(u8, 0x80));
+        while (i + VecSize <= s.len) : (i += VecSize) {
+            const vbuf: @Vector(VecSize, u8) = s[i..i+VecSize][0..VecSize].*;
+            if (state == Utf8Accept and @reduce(.Or, vbuf) & 0x80 == 0) {
+                charLen += VecSize;
+                continue;
+            }
+            const conts: MaskInt = @bitCast((vbuf & contMask) == contTag);
+            charLen += VecSize - @popCount(conts);
+            state = utf8DfaRun(state, s[i..i+VecSize]);
+            if (state == Utf8Reject) {
+                return null;
+            }
         }
-        _ = std.unicode.utf8Decode(s[i .. i + cp_len]) catch {
-            return null;
-        };
-        i += cp_len;
-        charLen += 1;
     }
-    return charLen;
+    // Remaining use cpu.
+    state = utf8DfaRun(state, s[i..]);
+    if (state != Utf8Accept) {
+        return null;
+    }
+    return charLen + countRuneStarts(s[i..]);
 }
 
 /// Assumes valid UTF-8 sequence.
 pub fn utf8Len(s: []const u8) linksection(cy.Section) usize {
     var len: usize = 0;
     var i: usize = 0;
-    while (i < s.len) {
-        const cp_len = std.unicode.utf8ByteSequenceLength(s[i]) catch return cy.fatal();
-        if (i + cp_len == s.len) {
-            return len;
+    if (comptime std.simd.suggestVectorSize(u8)) |VecSize| {
+        const MaskInt = std.meta.Int(.unsigned, VecSize);
+        const contMask: @Vector(VecSize, u8) = @splat(@as(u8, 0xc0));
+        const contTag: @Vector(VecSize, u8) = @splat(@as(u8, 0x80));
+        while (i + VecSize <= s.len) : (i += VecSize) {
+            const vbuf: @Vector(VecSize, u8) = s[i..i+VecSize][0..VecSize].*;
+            const conts: MaskInt = @bitCast((vbuf & contMask) == contTag);
+            len += VecSize - @popCount(conts);
+        }
+    }
+    return len + countRuneStarts(s[i..]);
+}
+
+test "validateUtf8()" {
+    try t.eq(validateUtf8(""), 0);
+    try t.eq(validateUtf8("abc"), 3);
+    try t.eq(validateUtf8("abc🦊xyz"), 7);
+    try t.eq(validateUtf8("日本語"), 3);
+    // Overlong, surrogate, too large, truncated and stray continuation.
+    try t.eq(validateUtf8("\xc0\xaf"), null);
+    try t.eq(validateUtf8("\xed\xa0\x80"), null);
+    try t.eq(validateUtf8("\xf4\x90\x80\x80"), null);
+    try t.eq(validateUtf8("abc\xe6\x97"), null);
+    try t.eq(validateUtf8("\x80abc"), null);
+
+    // Sequence split across vector blocks.
+    var buf: [100]u8 = undefined;
+    @memset(&buf, 'a');
+    for (0..buf.len - 4) |i| {
+        @memset(&buf, 'a');
+        @memcpy(buf[i..i+4], "🦊");
+        try t.eq(validateUtf8(&buf), buf.len - 3);
+        try t.eq(utf8Len(&buf), buf.len - 3);
+        try t.eq(validateUtf8(buf[0..i+3]), null);
+    }
+}
+
+test "validateUtf8() matches scalar reference." {
+    var prng = std.rand.DefaultPrng.init(0);
+    const rand = prng.random();
+    const samples = [_][]const u8{ "a", "z", "é", "ß", "日", "本", "🦊", "€", "\x7f", "\u{10ffff}" };
+    var buf: [300]u8 = undefined;
+    for (0..5000) |_| {
+        // Build a valid string from samples.
+        var len: usize = 0;
+        while (true) {
+            const sample = samples[rand.uintLessThan(usize, samples.len)];
+            if (len + sample.len > buf.len) {
+                break;
+            }
+            @memcpy(buf[len..len+sample.len], sample);
+            len += sample.len;
+            if (rand.uintLessThan(u32, 64) == 0) {
+                break;
+            }
+        }
+        const str = buf[0..len];
+        const expLen = try std.unicode.utf8CountCodepoints(str);
+        try t.eq(validateUtf8(str), expLen);
+        try t.eq(utf8Len(str), expLen);
+
+        // Corrupt random bytes.
+        const numCorrupt = rand.uintLessThan(usize, 3);
+        for (0..numCorrupt) |_| {
+            if (len == 0) break;
+            buf[rand.uintLessThan(usize, len)] = rand.int(u8);
         }
-        i += cp_len;
-        len += 1;
+        const exp: ?usize = if (std.unicode.utf8ValidateSlice(str)) try std.unicode.utf8CountCodepoints(str) else null;
+        try t.eq(validateUtf8(str), exp);
     }
-    return len;
 }
 
 pub fn utf8CharSliceAt(str: []const u8, idx: usize) linksection(cy.Section) ?[]const u8 {
@@ -438,79 +583,333 @@ fn indexOfCharSimdFixed(comptime VecSize: usize, buf: []const u8, needle: u8) ?u
 const hasAvx2 = std.Target.x86.featureSetHasAny(builtin.cpu.features, .{ .avx2 });
 const NullId = std.math.maxInt(u32);
 
-fn indexOfScalar(str: []const u8, needle: []const u8) linksection(cy.StdSection) ?usize {
-    return std.mem.indexOf(u8, str, needle);
-}
-
-/// `needle` can be any UTF-8 string.
-/// `str` is assumed to have `needle.len` additional bytes so that an offset buffer can loaded without bounds check.
-fn indexOfSimdFixed(comptime VecSize: usize, str: []const u8, needle: []const u8) linksection(cy.StdSection) ?usize {
-    const MaskInt = std.meta.Int(.unsigned, VecSize);
-    // Algorithm based on: http://0x80.pl/articles/simd-strfind.html.
-
-    // Set up hashing. Hash end is currently always the last char position in needle.
-    const offset = needle.len - 1;
-    const first: @Vector(VecSize, u8) = @splat(needle[0]);
-    const last: @Vector(VecSize, u8) = @splat(needle[needle.len-1]);
+/// Approximate byte frequency rank in text and source code. Higher is more common.
+/// Used to pick the rarest needle bytes for the `Finder` prefilter.
+const byteRanks = b: {
+    @setEvalBranchQuota(10000);
+    var ranks: [256]u8 = undefined;
+    for (&ranks, 0..) |*rank, i| {
+        const c: u8 = @intCast(i);
+        rank.* = if (c == ' ')
+            255
+        else if (std.ascii.isLower(c))
+            160
+        else if (std.ascii.isDigit(c))
+            130
+        else if (std.mem.indexOfScalar(u8, "\n\t,.-_/:=\"'()", c) != null)
+            120
+        else if (std.ascii.isUpper(c))
+            110
+        else if (c >= 0x80 and c <= 0xbf)
+            // UTF-8 continuation bytes.
+            90
+        else if (c >= 0xc2 and c <= 0xf4)
+            // UTF-8 lead bytes.
+            70
+        else if (std.ascii.isPrint(c))
+            60
+        else
+            0;
+    }
+    for ("etaoinsrhldcumfpgwybvkxjqz", 0..) |c, i| {
+        ranks[c] = 250 - i * 3;
+    }
+    break :b ranks;
+};
 
-    var i: usize = 0;
-    while (i + VecSize <= str.len) : (i += VecSize) {
-        const buf1: @Vector(VecSize, u8) = str[i..i + VecSize][0..VecSize].*;
-        const firstMask: MaskInt = @bitCast(buf1 == first);
-        if (firstMask > 0) {
-            const buf2: @Vector(VecSize, u8) = @as([*]const u8, @ptrCast(str.ptr + i + offset))[0..VecSize].*;
-            const lastMask: MaskInt = @bitCast(buf2 == last);
-            if (lastMask > 0) {
-                var hitMask = firstMask & lastMask;
-                // Visit each potential substring match until a match is found.
-                while (hitMask > 0) {
-                    const idx = @ctz(hitMask);
-                    if (std.mem.eql(u8, @as([*]const u8, @ptrCast(str.ptr + i + idx))[0..needle.len], needle)) {
-                        return i + idx;
-                    }
-                    hitMask = unsetLowestBit(hitMask, idx);
-                }
+/// Searches for a needle that is preprocessed once and can be reused across haystacks.
+///
+/// A SIMD prefilter tests the two rarest needle bytes at their offsets and verifies each candidate.
+/// If the prefilter produces too many false candidates, eg. for periodic or low-entropy text,
+/// the search switches to Two-Way from the current position so that the worst case stays linear.
+pub const Finder = struct {
+    needle: []const u8,
+    rare1Idx: u32,
+    rare2Idx: u32,
+    twoWay: TwoWay,
+
+    pub fn init(needle: []const u8) Finder {
+        var res = Finder{
+            .needle = needle,
+            .rare1Idx = 0,
+            .rare2Idx = 0,
+            .twoWay = undefined,
+        };
+        if (needle.len < 2) {
+            return res;
+        }
+        for (needle, 0..) |c, i| {
+            if (byteRanks[c] < byteRanks[needle[res.rare1Idx]]) {
+                res.rare1Idx = @intCast(i);
             }
         }
+        // Prefer a different byte for the second filter since the same byte adds little selectivity.
+        const rare1 = needle[res.rare1Idx];
+        var rare2Idx: ?u32 = null;
+        for (needle, 0..) |c, i| {
+            if (c == rare1) {
+                continue;
+            }
+            if (rare2Idx == null or byteRanks[c] < byteRanks[needle[rare2Idx.?]]) {
+                rare2Idx = @intCast(i);
+            }
+        }
+        // Every byte is the same, use the farthest position instead.
+        res.rare2Idx = rare2Idx orelse @intCast(needle.len - 1);
+        res.twoWay = TwoWay.init(needle);
+        return res;
     }
-    return null;
-}
 
-/// `str.len` can be assumed to be >= 1 and < VecSize + needle.len.
-fn indexOfSimdRemain(comptime VecSize: usize, str_: []const u8, needle: []const u8) linksection(cy.StdSection) ?usize {
-    const MaskInt = std.meta.Int(.unsigned, VecSize);
+    pub fn find(self: *const Finder, str: []const u8) linksection(cy.StdSection) ?usize {
+        const needle = self.needle;
+        if (needle.len == 0) {
+            return 0;
+        }
+        if (needle.len > str.len) {
+            return null;
+        }
+        if (needle.len == 1) {
+            return indexOfChar(str, needle[0]);
+        }
+        if (comptime std.simd.suggestVectorSize(u8)) |VecSize| {
+            return self.findPrefilter(VecSize, str);
+        } else {
+            return self.twoWay.find(needle, str, 0);
+        }
+    }
+
+    /// Algorithm based on: http://0x80.pl/articles/simd-strfind.html with the rarest bytes
+    /// instead of the first and last bytes.
+    fn findPrefilter(self: *const Finder, comptime VecSize: usize, str: []const u8) linksection(cy.StdSection) ?usize {
+        const MaskInt = std.meta.Int(.unsigned, VecSize);
+        const needle = self.needle;
+        const rare1: @Vector(VecSize, u8) = @splat(needle[self.rare1Idx]);
+        const rare2: @Vector(VecSize, u8) = @splat(needle[self.rare2Idx]);
 
-    // This will check up to `VecSize` bytes and any extras after that
-    // can be discarded since the length will be < `needle.len`.
-    const str = if (str_.len > VecSize) str_[0..VecSize] else str_;
-
-    // Algorithm based on: http://0x80.pl/articles/simd-strfind.html.
-
-    // Set up hashing. Hash end is currently always the last char position in needle.
-    const offset = needle.len - 1;
-    const first: @Vector(VecSize, u8) = @splat(needle[0]);
-    const last: @Vector(VecSize, u8) = @splat(needle[needle.len-1]);
-
-    // Don't need a remainMask since the eq op on `first` and `last` will be false.
-    const buf1 = cy.simd.load(VecSize, u8, str);
-    const firstMask: MaskInt = @bitCast(buf1 == first);
-    if (firstMask > 0) {
-        const buf2 = cy.simd.load(VecSize, u8, str_[offset..]);
-        const lastMask: MaskInt = @bitCast(buf2 == last);
-        if (lastMask > 0) {
-            var hitMask = firstMask & lastMask;
+        // Number of candidate positions. Loads at the rare offsets never read past `str`.
+        const numStarts = str.len - needle.len + 1;
+
+        // Verification work allowed in addition to the scanned bytes before switching to Two-Way.
+        var budget: isize = @intCast(4 * needle.len + 256);
+
+        var i: usize = 0;
+        while (i + VecSize <= numStarts) : (i += VecSize) {
+            const buf1: @Vector(VecSize, u8) = @as([*]const u8, @ptrCast(str.ptr + i + self.rare1Idx))[0..VecSize].*;
+            const buf2: @Vector(VecSize, u8) = @as([*]const u8, @ptrCast(str.ptr + i + self.rare2Idx))[0..VecSize].*;
+            const mask1: MaskInt = @bitCast(buf1 == rare1);
+            const mask2: MaskInt = @bitCast(buf2 == rare2);
+            var hitMask = mask1 & mask2;
+            budget += VecSize;
             // Visit each potential substring match until a match is found.
             while (hitMask > 0) {
                 const idx = @ctz(hitMask);
-                if (std.mem.eql(u8, @as([*]const u8, @ptrCast(str.ptr + idx))[0..needle.len], needle)) {
-                    return idx;
+                if (std.mem.eql(u8, str[i + idx..][0..needle.len], needle)) {
+                    return i + idx;
                 }
+                budget -= @intCast(needle.len);
                 hitMask = unsetLowestBit(hitMask, idx);
             }
+            if (budget < 0) {
+                return self.twoWay.find(needle, str, i + VecSize);
+            }
         }
+        // Remaining starts are fewer than `VecSize`.
+        return self.twoWay.find(needle, str, i);
     }
-    return null;
-}
+};
+
+/// Crochemore-Perrin Two-Way string matching. Linear time and constant space.
+const TwoWay = struct {
+    /// Critical factorization position.
+    crit: u32,
+    period: u32,
+    /// When the needle is not periodic, `period` is a lower bound used as the shift and
+    /// the matched prefix is not remembered between shifts.
+    longPeriod: bool,
+
+    fn init(needle: []const u8) TwoWay {
+        const less = maximalSuffix(needle, false);
+        const greater = maximalSuffix(needle, true);
+        const suffix = if (less.pos > greater.pos) less else greater;
+        const crit = suffix.pos;
+        const period = suffix.period;
+
+        if (crit + period <= needle.len and std.mem.eql(u8, needle[0..crit], needle[period..period + crit])) {
+            return .{
+                .crit = @intCast(crit),
+                .period = @intCast(period),
+                .longPeriod = false,
+            };
+        } else {
+            return .{
+                .crit = @intCast(crit),
+                .period = @intCast(@max(crit, needle.len - crit) + 1),
+                .longPeriod = true,
+            };
+        }
+    }
+
+    const Suffix = struct {
+        pos: usize,
+        period: usize,
+    };
+
+    /// Computes the maximal suffix of `needle` for the byte ordering given by `greater`.
+    fn maximalSuffix(needle: []const u8, comptime greater: bool) Suffix {
+        var left: usize = 0;
+        var right: usize = 1;
+        var offset: usize = 0;
+        var period: usize = 1;
+        while (right + offset < needle.len) {
+            const a = needle[right + offset];
+            const b = needle[left + offset];
+            if ((!greater and a < b) or (greater and a > b)) {
+                right += offset + 1;
+                offset = 0;
+                period = right - left;
+            } else if (a == b) {
+                if (offset + 1 == period) {
+                    right += offset + 1;
+                    offset = 0;
+                } else {
+                    offset += 1;
+                }
+            } else {
+                left = right;
+                right += 1;
+                offset = 0;
+                period = 1;
+            }
+        }
+        return .{ .pos = left, .period = period };
+    }
+
+    fn find(self: TwoWay, needle: []const u8, str: []const u8, start: usize) linksection(cy.StdSection) ?usize {
+        const n = needle.len;
+        var pos = start;
+        // Length of the needle prefix known to match at `pos` (periodic needles only).
+        var memory: usize = 0;
+        while (pos + n <= str.len) {
+            // Match the right half.
+            var i: usize = if (self.longPeriod) self.crit else @max(self.crit, memory);
+            while (i < n and needle[i] == str[pos + i]) {
+                i += 1;
+            }
+            if (i < n) {
+                pos += i - self.crit + 1;
+                memory = 0;
+                continue;
+            }
+
+            // Match the left half.
+            const lo: usize = if (self.longPeriod) 0 else memory;
+            var j: usize = self.crit;
+            while (j > lo and needle[j - 1] == str[pos + j - 1]) {
+                j -= 1;
+            }
+            if (j > lo) {
+                pos += self.period;
+                if (!self.longPeriod) {
+                    memory = n - self.period;
+                }
+                continue;
+            }
+            return pos;
+        }
+        return null;
+    }
+};
+
+/// Caches `Finder`s for small needles. Each VM owns a cache.
+/// Entries are keyed by the needle object and are invalidated when the object is freed.
+/// Only objects that own their bytes are cached since a slice can't be told apart from a new one at the same address.
+pub const FinderCache = struct {
+    keys: [NumSlots]?*const cy.HeapObject = .{null} ** NumSlots,
+    finders: [NumSlots]Finder = undefined,
+
+    const NumSlots = 32;
+
+    fn getSlot(obj: *const cy.HeapObject) usize {
+        // Drop the low bits that are always zero from the object alignment.
+        // Pool objects are 40 bytes apart, so consecutive objects still map to different slots.
+        const shift = comptime std.math.log2_int(usize, @alignOf(cy.HeapObject));
+        return (@intFromPtr(obj) >> shift) % NumSlots;
+    }
+
+    /// Returns a `Finder` for the needle string `obj`. Strings that can't be cached are
+    /// preprocessed into `buf`.
+    pub fn get(self: *FinderCache, obj: *const cy.HeapObject, buf: *Finder) *const Finder {
+        const stype = obj.string.getType();
+        if (stype == .astring or stype == .ustring) {
+            return self.getCached(obj, obj.string.getSlice(), buf);
+        }
+        buf.* = Finder.init(obj.string.getSlice());
+        return buf;
+    }
+
+    /// Same as `get` for a needle `Array`.
+    pub fn getArray(self: *FinderCache, obj: *const cy.HeapObject, buf: *Finder) *const Finder {
+        if (!obj.array.isSlice()) {
+            return self.getCached(obj, obj.array.getSlice(), buf);
+        }
+        buf.* = Finder.init(obj.array.getSlice());
+        return buf;
+    }
+
+    fn getCached(self: *FinderCache, obj: *const cy.HeapObject, needle: []const u8, buf: *Finder) *const Finder {
+        if (needle.len <= MaxNeedleLen) {
+            const slot = getSlot(obj);
+            if (self.keys[slot] != obj) {
+                self.finders[slot] = Finder.init(needle);
+                self.keys[slot] = obj;
+            }
+            return &self.finders[slot];
+        }
+        buf.* = Finder.init(needle);
+        return buf;
+    }
+
+    /// Needles up to the interned string length are cached.
+    pub const MaxNeedleLen = cy.heap.DefaultStringInternMaxByteLen;
+
+    pub fn invalidate(self: *FinderCache, obj: *const cy.HeapObject) void {
+        const slot = getSlot(obj);
+        if (self.keys[slot] == obj) {
+            self.keys[slot] = null;
+        }
+    }
+
+    pub fn clear(self: *FinderCache) void {
+        self.keys = .{null} ** NumSlots;
+    }
+};
+
+/// Like `std.mem.split` except the delimiter is a preprocessed `Finder`.
+pub const SplitIterator = struct {
+    str: []const u8,
+    finder: *const Finder,
+    idx: ?usize,
+
+    /// `finder.needle` is assumed to be non-empty.
+    pub fn init(str: []const u8, finder: *const Finder) SplitIterator {
+        return .{
+            .str = str,
+            .finder = finder,
+            .idx = 0,
+        };
+    }
+
+    pub fn next(self: *SplitIterator) ?[]const u8 {
+        const start = self.idx orelse return null;
+        if (self.finder.find(self.str[start..])) |i| {
+            self.idx = start + i + self.finder.needle.len;
+            return self.str[start..start + i];
+        } else {
+            self.idx = null;
+            return self.str[start..];
+        }
+    }
+};
 
 inline fn unsetLowestBit(mask: anytype, idx: anytype) @TypeOf(mask) {
     const Mask = @TypeOf(mask);
@@ -518,29 +917,51 @@ inline fn unsetLowestBit(mask: anytype, idx: anytype) @TypeOf(mask) {
     return mask & ~(@as(Mask, 1) << @intCast(idx));
 }
 
-/// `needle.len` is assumed to be at most `str.len`.
+/// Preprocesses `needle` for a single search. Use a `Finder` directly to reuse the preprocessing.
 pub fn indexOf(str: []const u8, needle: []const u8) linksection(cy.StdSection) ?usize {
-    if (comptime std.simd.suggestVectorSize(u8)) |VecSize| {
-        var i: usize = 0;
-        // Ensure that there is `needle.len` additional bytes after the fixed width.
-        const iters = @divTrunc(str.len - needle.len, VecSize);
-        if (iters > 0) {
-            if (indexOfSimdFixed(VecSize, str[0..iters * VecSize], needle)) |idx| {
-                return idx;
-            }
-            i += iters * VecSize;
+    const finder = Finder.init(needle);
+    return finder.find(str);
+}
+
+test "Finder matches std.mem.indexOf." {
+    var prng = std.rand.DefaultPrng.init(0);
+    const rand = prng.random();
+    var strBuf: [300]u8 = undefined;
+    var needleBuf: [20]u8 = undefined;
+    for (0..5000) |_| {
+        // Small alphabets produce periodic needles and many prefilter candidates.
+        const alphabet = rand.intRangeAtMost(u8, 1, 4);
+        const str = strBuf[0..rand.uintAtMost(usize, strBuf.len)];
+        for (str) |*c| {
+            c.* = 'a' + rand.uintLessThan(u8, alphabet);
         }
-        if (i < str.len) {
-            if (indexOfSimdRemain(VecSize, str[i..], needle)) |idx| {
-                return i + idx;
-            }
+        const needle = needleBuf[0..rand.intRangeAtMost(usize, 1, needleBuf.len)];
+        for (needle) |*c| {
+            c.* = 'a' + rand.uintLessThan(u8, alphabet);
         }
-        return null;
-    } else {
-        return indexOfScalar(str, needle);
+        const finder = Finder.init(needle);
+        try t.eq(finder.find(str), std.mem.indexOf(u8, str, needle));
     }
 }
 
+test "Finder worst cases." {
+    var str: [4096]u8 = undefined;
+    @memset(&str, 'a');
+    try t.eq(indexOf(&str, "aaaaaaaaab"), null);
+    try t.eq(indexOf(&str, "baaaaaaaaa"), null);
+    str[4000] = 'b';
+    try t.eq(indexOf(&str, "aaaaaaaaab"), 3991);
+    try t.eq(indexOf(&str, "baaaaaaaaa"), 4000);
+    try t.eq(indexOf(&str, "abababab"), null);
+
+    var iter = SplitIterator.init("a--b----c", &Finder.init("--"));
+    try t.eqStr(iter.next().?, "a");
+    try t.eqStr(iter.next().?, "b");
+    try t.eqStr(iter.next().?, "");
+    try t.eqStr(iter.next().?, "c");
+    try t.eq(iter.next(), null);
+}
+
 fn indexOfAsciiSetScalar(str: []const u8, set: []const u8) linksection(cy.StdSection) ?usize {
     for (str, 0..) |code, i| {
         if (indexOfChar(set, code) != null) {
@@ -833,20 +1254,17 @@ pub fn getLineEnd(buf: []const u8) linksection(cy.StdSection) ?usize {
 }
 
 /// Like std.mem.replacementSize but also records the idxes.
-pub fn prepReplacement(str: []const u8, needle: []const u8, replacement: []const u8, idxesWriter: anytype) linksection(cy.StdSection) !usize {
+pub fn prepReplacement(str: []const u8, finder: *const Finder, replacement: []const u8, idxesWriter: anytype) linksection(cy.StdSection) !usize {
+    const needle = finder.needle;
     if (needle.len == 0) {
         return str.len;
     }
     var i: usize = 0;
     var size: usize = str.len;
-    while (i < str.len) {
-        if (std.mem.startsWith(u8, str[i..], needle)) {
-            size = size - needle.len + replacement.len;
-            _ = try idxesWriter.write(std.mem.asBytes(&@as(u32, @intCast(i))));
-            i += needle.len;
-        } else {
-            i += 1;
-        }
+    while (finder.find(str[i..])) |idx| {
+        size = size - needle.len + replacement.len;
+        _ = try idxesWriter.write(std.mem.asBytes(&@as(u32, @intCast(i + idx))));
+        i += idx + needle.len;
     }
     return size;
 }
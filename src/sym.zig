@@ -381,6 +381,12 @@ pub const EnumMember = extern struct {
     type: cy.TypeId,
     val: u32,
     payloadType: cy.Nullable(cy.TypeId),
+
+    /// Interned `Type.member` string, created on first conversion. Owned by the VM's `staticObjects`.
+    str: ?*anyopaque = null,
+
+    /// Interned `member` string, created on first `name()`. Owned by the VM's `staticObjects`.
+    nameStr: ?*anyopaque = null,
 };
 
 const Import = extern struct {
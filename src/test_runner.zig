@@ -0,0 +1,301 @@
+const std = @import("std");
+const stdx = @import("stdx");
+const t = stdx.testing;
+
+/// Runs `*.cy` test files found under a directory on a worker pool.
+/// Each file is evaluated by a child `cyber` process so that every test gets a fresh VM
+/// and its own stdout/stderr. VMs in the same process share globals (eg. `cy.tempBuf`, `cy.silentError`)
+/// and can't be run on separate threads.
+///
+/// A file is considered a test if it contains a `--cytest: pass` or `--cytest: error` marker,
+/// the same convention used by the behavior tests. For `error` tests, the child's stderr must begin with
+/// the expected report. As in the behavior tests, `main` stands for the test file and `@AbsPath(path)`
+/// for `path` relative to the current directory.
+pub const Options = struct {
+    /// Defaults to the number of CPUs.
+    jobs: ?u32 = null,
+
+    /// Print the duration of each test.
+    timing: bool = false,
+};
+
+const Expect = enum {
+    pass,
+    err,
+};
+
+const TestCase = struct {
+    path: []const u8,
+    expect: Expect,
+
+    /// Expected error report with the comment markers removed.
+    expErr: []const u8,
+
+    // Filled in by the worker.
+    passed: bool = false,
+    term: std.ChildProcess.Term = undefined,
+    stdout: []const u8 = "",
+    stderr: []const u8 = "",
+    runErr: ?anyerror = null,
+    durationNs: u64 = 0,
+};
+
+const Context = struct {
+    alloc: std.mem.Allocator,
+    exe: []const u8,
+};
+
+/// Returns the number of failed tests.
+pub fn run(alloc: std.mem.Allocator, dir: []const u8, opts: Options) !u32 {
+    const exe = try std.fs.selfExePathAlloc(alloc);
+    defer alloc.free(exe);
+
+    var cases: std.ArrayListUnmanaged(TestCase) = .{};
+    defer {
+        for (cases.items) |case| {
+            alloc.free(case.path);
+            alloc.free(case.expErr);
+            alloc.free(case.stdout);
+            alloc.free(case.stderr);
+        }
+        cases.deinit(alloc);
+    }
+    try discover(alloc, dir, &cases);
+
+    // Sort so the report is deterministic regardless of directory order and scheduling.
+    std.sort.pdq(TestCase, cases.items, {}, S.lessThan);
+
+    const ctx = Context{
+        .alloc = alloc,
+        .exe = exe,
+    };
+
+    var timer = try std.time.Timer.start();
+
+    var pool: std.Thread.Pool = undefined;
+    try pool.init(.{
+        .allocator = alloc,
+        .n_jobs = opts.jobs,
+    });
+    defer pool.deinit();
+
+    var wg: std.Thread.WaitGroup = .{};
+    for (cases.items) |*case| {
+        wg.start();
+        try pool.spawn(runCaseWorker, .{ &ctx, case, &wg });
+    }
+    pool.waitAndWork(&wg);
+
+    const totalNs = timer.read();
+    return report(cases.items, opts, totalNs);
+}
+
+const S = struct {
+    fn lessThan(_: void, a: TestCase, b: TestCase) bool {
+        return std.mem.lessThan(u8, a.path, b.path);
+    }
+};
+
+fn discover(alloc: std.mem.Allocator, dir: []const u8, cases: *std.ArrayListUnmanaged(TestCase)) !void {
+    var idir = try std.fs.cwd().openIterableDir(dir, .{});
+    defer idir.close();
+
+    var walker = try idir.walk(alloc);
+    defer walker.deinit();
+
+    while (try walker.next()) |entry| {
+        if (entry.kind != .file) {
+            continue;
+        }
+        if (!std.mem.endsWith(u8, entry.basename, ".cy")) {
+            continue;
+        }
+        const path = try std.fs.path.join(alloc, &.{ dir, entry.path });
+        errdefer alloc.free(path);
+
+        const src = try std.fs.cwd().readFileAlloc(alloc, path, 1e9);
+        defer alloc.free(src);
+
+        var expErr: []const u8 = "";
+        const expect = parseExpect(src, &expErr) orelse {
+            // Not a test file. eg. An imported module.
+            alloc.free(path);
+            continue;
+        };
+        try cases.append(alloc, .{
+            .path = path,
+            .expect = expect,
+            .expErr = try allocExpectedReport(alloc, expErr),
+        });
+    }
+}
+
+/// For `error` tests, `outExpErr` receives the comment block following the marker.
+fn parseExpect(src: []const u8, outExpErr: *[]const u8) ?Expect {
+    var idx = std.mem.indexOf(u8, src, "cytest:") orelse {
+        return null;
+    };
+    const rest = src[idx+7..];
+    idx = std.mem.indexOfScalar(u8, rest, '\n') orelse rest.len;
+    const testT = std.mem.trim(u8, rest[0..idx], " \r");
+    if (std.mem.eql(u8, testT, "pass")) {
+        return .pass;
+    } else if (std.mem.eql(u8, testT, "error")) {
+        // The expected report follows as comments. Same scan as the behavior tests.
+        const start = @min(idx+1, rest.len);
+        while (rest[idx..].len >= 3 and rest[idx] == '\n' and rest[idx+1] == '-' and rest[idx+2] == '-') {
+            idx = std.mem.indexOfScalarPos(u8, rest, idx+1, '\n') orelse rest.len;
+        }
+        outExpErr.* = rest[start..idx];
+        return .err;
+    } else {
+        return null;
+    }
+}
+
+/// Removes the comment markers and expands `@AbsPath(path)`.
+fn allocExpectedReport(alloc: std.mem.Allocator, block: []const u8) ![]const u8 {
+    const report = try std.mem.replaceOwned(u8, alloc, block, "--", "");
+    defer alloc.free(report);
+
+    var buf: std.ArrayListUnmanaged(u8) = .{};
+    errdefer buf.deinit(alloc);
+    var rest: []const u8 = report;
+    while (std.mem.indexOf(u8, rest, "@AbsPath(")) |idx| {
+        const end = std.mem.indexOfScalarPos(u8, rest, idx, ')') orelse break;
+        try buf.appendSlice(alloc, rest[0..idx]);
+        const cwd = try std.fs.realpathAlloc(alloc, ".");
+        defer alloc.free(cwd);
+        const absPath = try std.fs.path.join(alloc, &.{ cwd, rest[idx+9..end] });
+        defer alloc.free(absPath);
+        try buf.appendSlice(alloc, absPath);
+        rest = rest[end+1..];
+    }
+    try buf.appendSlice(alloc, rest);
+    return buf.toOwnedSlice(alloc);
+}
+
+/// The child reports the test file by its path while the expected report calls it `main`.
+/// Both spellings are accepted so reports that use `@AbsPath` for the test file also match.
+fn matchesReport(alloc: std.mem.Allocator, stderr: []const u8, testPath: []const u8, exp: []const u8) !bool {
+    if (std.mem.startsWith(u8, stderr, exp)) {
+        return true;
+    }
+    const absPath = try std.fs.realpathAlloc(alloc, testPath);
+    defer alloc.free(absPath);
+    for ([_][]const u8{ absPath, testPath }) |path| {
+        const norm = try std.mem.replaceOwned(u8, alloc, stderr, path, "main");
+        defer alloc.free(norm);
+        if (std.mem.startsWith(u8, norm, exp)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+fn runCaseWorker(ctx: *const Context, case: *TestCase, wg: *std.Thread.WaitGroup) void {
+    defer wg.finish();
+    runCase(ctx, case) catch |err| {
+        case.runErr = err;
+        case.passed = false;
+    };
+}
+
+fn runCase(ctx: *const Context, case: *TestCase) !void {
+    var timer = try std.time.Timer.start();
+    const res = try std.ChildProcess.exec(.{
+        .allocator = ctx.alloc,
+        .argv = &.{ ctx.exe, case.path },
+        .max_output_bytes = 1024 * 1024 * 10,
+    });
+    case.durationNs = timer.read();
+    case.term = res.term;
+    case.stdout = res.stdout;
+    case.stderr = res.stderr;
+
+    const exitedOk = res.term == .Exited and res.term.Exited == 0;
+    switch (case.expect) {
+        .pass => {
+            case.passed = exitedOk;
+        },
+        .err => {
+            if (exitedOk or res.term != .Exited) {
+                // Expected a user error report, not a success or a crash.
+                case.passed = false;
+                return;
+            }
+            // Debug builds print a Zig error trace after the report.
+            case.passed = try matchesReport(ctx.alloc, res.stderr, case.path, case.expErr);
+        },
+    }
+}
+
+fn report(cases: []const TestCase, opts: Options, totalNs: u64) !u32 {
+    const w = std.io.getStdOut().writer();
+    var numFailed: u32 = 0;
+    var serialNs: u64 = 0;
+    for (cases) |case| {
+        serialNs += case.durationNs;
+        const status = if (case.passed) "PASS" else "FAIL";
+        if (opts.timing) {
+            try w.print("{s} {s} ({d:.2}ms)\n", .{ status, case.path, nsToMs(case.durationNs) });
+        } else {
+            try w.print("{s} {s}\n", .{ status, case.path });
+        }
+        if (case.passed) {
+            continue;
+        }
+        numFailed += 1;
+        if (case.runErr) |err| {
+            try w.print("  Failed to run: {}\n", .{err});
+            continue;
+        }
+        switch (case.term) {
+            .Exited => |code| try w.print("  Exited with code {}.\n", .{code}),
+            .Signal => |sig| try w.print("  Terminated by signal {}.\n", .{sig}),
+            else => try w.print("  Terminated abnormally.\n", .{}),
+        }
+        if (case.expect == .err) {
+            try writeIndented(w, "expected", case.expErr);
+        }
+        try writeIndented(w, "stdout", case.stdout);
+        try writeIndented(w, "stderr", case.stderr);
+    }
+    try w.print("\n{} passed, {} failed, {} total ({d:.2}ms)\n", .{
+        cases.len - numFailed, numFailed, cases.len, nsToMs(totalNs),
+    });
+    if (opts.timing) {
+        // The sum of the test durations is what a sequential run would take, minus the process overhead.
+        try w.print("Sum of test durations: {d:.2}ms, {d:.2}x speedup\n", .{
+            nsToMs(serialNs), @as(f64, @floatFromInt(serialNs)) / @as(f64, @floatFromInt(@max(totalNs, 1))),
+        });
+    }
+    return numFailed;
+}
+
+fn writeIndented(w: anytype, name: []const u8, out: []const u8) !void {
+    if (out.len == 0) {
+        return;
+    }
+    try w.print("  {s}:\n", .{name});
+    var iter = std.mem.splitScalar(u8, std.mem.trimRight(u8, out, "\n"), '\n');
+    while (iter.next()) |line| {
+        try w.print("    {s}\n", .{line});
+    }
+}
+
+fn nsToMs(ns: u64) f64 {
+    return @as(f64, @floatFromInt(ns)) / 1e6;
+}
+
+test "parseExpect()" {
+    var expErr: []const u8 = "";
+    try t.eq(parseExpect("print 1\n\n--cytest: pass", &expErr), .pass);
+    try t.eq(parseExpect("print 1\n", &expErr), null);
+    try t.eq(parseExpect("must(a)\n\n--cytest: error\n--panic: error.boom\n--\n--main:1:1 main:\n\nprint 2", &expErr), .err);
+    try t.eqStr(expErr, "--panic: error.boom\n--\n--main:1:1 main:");
+
+    const exp = try allocExpectedReport(t.alloc, expErr);
+    defer t.alloc.free(exp);
+    try t.eqStr(exp, "panic: error.boom\n\nmain:1:1 main:");
+}
@@ -0,0 +1,122 @@
+const std = @import("std");
+
+/// Generates the simple case mapping tables used by `src/unicode.zig`.
+/// Usage: gen_unicode <UnicodeData.txt> <out.zig>
+///
+/// Each mapping is stored as a two stage table of deltas from the code point.
+/// Stage 1 maps a 256 code point block to a block in stage 2. Blocks without mappings
+/// share block 0 which is all zeros.
+const NumCodepoints = 0x110000;
+const BlockSize = 256;
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const alloc = gpa.allocator();
+
+    const args = try std.process.argsAlloc(alloc);
+    defer std.process.argsFree(alloc, args);
+    if (args.len != 3) {
+        std.debug.print("Usage: gen_unicode <UnicodeData.txt> <out.zig>\n", .{});
+        return error.InvalidArgs;
+    }
+
+    const src = try std.fs.cwd().readFileAlloc(alloc, args[1], 1e8);
+    defer alloc.free(src);
+
+    const upper = try alloc.alloc(i32, NumCodepoints);
+    defer alloc.free(upper);
+    const lower = try alloc.alloc(i32, NumCodepoints);
+    defer alloc.free(lower);
+    const fold = try alloc.alloc(i32, NumCodepoints);
+    defer alloc.free(fold);
+    @memset(upper, 0);
+    @memset(lower, 0);
+
+    var lines = std.mem.splitScalar(u8, src, '\n');
+    while (lines.next()) |line| {
+        if (line.len == 0) {
+            continue;
+        }
+        var fields: [15][]const u8 = undefined;
+        var numFields: usize = 0;
+        var iter = std.mem.splitScalar(u8, line, ';');
+        while (iter.next()) |field| {
+            if (numFields < fields.len) {
+                fields[numFields] = field;
+            }
+            numFields += 1;
+        }
+        if (numFields != fields.len) {
+            std.debug.print("Invalid line: {s}\n", .{line});
+            return error.InvalidLine;
+        }
+        const cp = try std.fmt.parseInt(i32, fields[0], 16);
+        if (fields[12].len > 0) {
+            upper[@intCast(cp)] = try std.fmt.parseInt(i32, fields[12], 16) - cp;
+        }
+        if (fields[13].len > 0) {
+            lower[@intCast(cp)] = try std.fmt.parseInt(i32, fields[13], 16) - cp;
+        }
+    }
+
+    // Simple case folding as lower(upper(cp)) so that all case variants fold to the same code point.
+    for (fold, 0..) |*delta, i| {
+        const cp: i32 = @intCast(i);
+        const up = cp + upper[i];
+        const folded = up + lower[@intCast(up)];
+        delta.* = folded - cp;
+    }
+
+    const file = try std.fs.cwd().createFile(args[2], .{});
+    defer file.close();
+    var bw = std.io.bufferedWriter(file.writer());
+    const w = bw.writer();
+
+    try w.print("// Generated by src/tools/gen_unicode.zig from src/unicode/UnicodeData.txt. Do not edit.\n\n", .{});
+    try w.print("pub const BlockSize = {};\n\n", .{BlockSize});
+    try writeTable(alloc, w, "upper", upper);
+    try writeTable(alloc, w, "lower", lower);
+    try writeTable(alloc, w, "fold", fold);
+    try bw.flush();
+}
+
+fn writeTable(alloc: std.mem.Allocator, w: anytype, name: []const u8, deltas: []const i32) !void {
+    var blocks: std.ArrayListUnmanaged([]const i32) = .{};
+    defer blocks.deinit(alloc);
+    try blocks.append(alloc, &([_]i32{0} ** BlockSize));
+
+    var stage1: [NumCodepoints / BlockSize]u16 = undefined;
+    for (&stage1, 0..) |*entry, b| {
+        const block = deltas[b * BlockSize..][0..BlockSize];
+        const idx = for (blocks.items, 0..) |existing, i| {
+            if (std.mem.eql(i32, existing, block)) {
+                break i;
+            }
+        } else b: {
+            try blocks.append(alloc, block);
+            break :b blocks.items.len - 1;
+        };
+        entry.* = @intCast(idx);
+    }
+
+    try w.print("pub const {s}Stage1 = [_]u16{{", .{name});
+    for (stage1, 0..) |entry, i| {
+        if (i % 32 == 0) {
+            try w.writeAll("\n   ");
+        }
+        try w.print(" {},", .{entry});
+    }
+    try w.writeAll("\n};\n\n");
+
+    try w.print("pub const {s}Stage2 = [_]i32{{", .{name});
+    for (blocks.items) |block| {
+        for (block, 0..) |delta, i| {
+            if (i % 32 == 0) {
+                try w.writeAll("\n   ");
+            }
+            try w.print(" {},", .{delta});
+        }
+    }
+    try w.writeAll("\n};\n\n");
+}
@@ -149,6 +149,28 @@ pub const SemaExt = struct {
         return s.types.items[typeId].symType == .enumType;
     }
 
+    /// Whether a static type's values are only equal to identical value bits.
+    /// Comparisons with these values don't need to fall back to comparing strings or arrays.
+    pub fn isBitEqType(s: *cy.Sema, id: TypeId) bool {
+        switch (id) {
+            bt.Boolean,
+            bt.Error,
+            bt.Symbol,
+            bt.Integer => return true,
+            else => {
+                if (id < PrimitiveEnd) {
+                    return false;
+                }
+                const sym = s.types.items[id].sym;
+                if (sym.type != .enumType) {
+                    return false;
+                }
+                // Choice values are objects.
+                return !sym.cast(.enumType).isChoiceType;
+            },
+        }
+    }
+
     pub fn isRcCandidateType(s: *cy.Sema, id: TypeId) bool {
         switch (id) {
             bt.String,
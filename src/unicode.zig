@@ -0,0 +1,136 @@
+// Copyright (c) 2023 Cyber (See LICENSE)
+
+/// Unicode simple case mapping.
+/// Tables are generated at build time from `src/unicode/UnicodeData.txt` by `src/tools/gen_unicode.zig`.
+
+const std = @import("std");
+const stdx = @import("stdx");
+const t = stdx.testing;
+const cy = @import("cyber.zig");
+const tables = @import("unicode_tables");
+
+pub const CaseMode = enum {
+    upper,
+    lower,
+
+    /// Simple case folding for caseless comparison. Every case variant of a rune folds to the same rune.
+    fold,
+};
+
+pub fn toUpper(cp: u21) u21 {
+    return mapRune(.upper, cp);
+}
+
+pub fn toLower(cp: u21) u21 {
+    return mapRune(.lower, cp);
+}
+
+pub fn foldCase(cp: u21) u21 {
+    return mapRune(.fold, cp);
+}
+
+pub inline fn mapRune(comptime mode: CaseMode, cp: u21) u21 {
+    const stage1 = switch (mode) {
+        .upper => &tables.upperStage1,
+        .lower => &tables.lowerStage1,
+        .fold => &tables.foldStage1,
+    };
+    const stage2 = switch (mode) {
+        .upper => &tables.upperStage2,
+        .lower => &tables.lowerStage2,
+        .fold => &tables.foldStage2,
+    };
+    const block: usize = stage1[cp / tables.BlockSize];
+    const delta = stage2[block * tables.BlockSize + cp % tables.BlockSize];
+    return @intCast(@as(i32, cp) + delta);
+}
+
+inline fn mapAsciiByte(comptime mode: CaseMode, ch: u8) u8 {
+    return switch (mode) {
+        .upper => std.ascii.toUpper(ch),
+        .lower, .fold => std.ascii.toLower(ch),
+    };
+}
+
+/// Maps the leading ASCII run of `src` into `dst` and returns its length.
+/// Blocks of ASCII are mapped with vectors.
+pub fn mapAsciiPrefix(comptime mode: CaseMode, dst: []u8, src: []const u8) linksection(cy.StdSection) usize {
+    var i: usize = 0;
+    if (comptime std.simd.suggestVectorSize(u8)) |VecSize| {
+        const Vec = @Vector(VecSize, u8);
+        const first: Vec = @splat(@as(u8, if (mode == .upper) 'a' else 'A'));
+        const last: Vec = @splat(@as(u8, if (mode == .upper) 'z' else 'Z'));
+        const flip: Vec = @splat(@as(u8, 0x20));
+        const none: @Vector(VecSize, bool) = @splat(false);
+        while (i + VecSize <= src.len) : (i += VecSize) {
+            const vbuf: Vec = src[i..i+VecSize][0..VecSize].*;
+            if (@reduce(.Or, vbuf) & 0x80 > 0) {
+                break;
+            }
+            const inRange = @select(bool, vbuf >= first, vbuf <= last, none);
+            dst[i..i+VecSize][0..VecSize].* = @select(u8, inRange, vbuf ^ flip, vbuf);
+        }
+    }
+    while (i < src.len and src[i] < 0x80) : (i += 1) {
+        dst[i] = mapAsciiByte(mode, src[i]);
+    }
+    return i;
+}
+
+/// Writes the case mapped `src` to `dst` and returns the number of bytes written.
+/// Assumes `src` is valid UTF-8. Runes map one to one so the rune count doesn't change,
+/// but the byte length can. `dst` must be at least twice as long as `src`.
+pub fn mapUtf8(comptime mode: CaseMode, dst: []u8, src: []const u8) linksection(cy.StdSection) usize {
+    std.debug.assert(dst.len >= src.len * 2);
+    var i: usize = 0;
+    var j: usize = 0;
+    while (i < src.len) {
+        if (src[i] < 0x80) {
+            const n = mapAsciiPrefix(mode, dst[j..], src[i..]);
+            i += n;
+            j += n;
+            continue;
+        }
+        const len = std.unicode.utf8ByteSequenceLength(src[i]) catch cy.fatal();
+        const cp = std.unicode.utf8Decode(src[i..i+len]) catch cy.fatal();
+        const mapped = mapRune(mode, cp);
+        if (mapped == cp) {
+            @memcpy(dst[j..j+len], src[i..i+len]);
+            j += len;
+        } else {
+            j += std.unicode.utf8Encode(mapped, dst[j..]) catch cy.fatal();
+        }
+        i += len;
+    }
+    return j;
+}
+
+test "mapRune()" {
+    try t.eq(toUpper('a'), 'A');
+    try t.eq(toUpper('A'), 'A');
+    try t.eq(toUpper('é'), 'É');
+    try t.eq(toLower('Σ'), 'σ');
+    try t.eq(toUpper('ς'), 'Σ');
+    try t.eq(toUpper('ß'), 'ß');
+    try t.eq(toLower('ẞ'), 'ß');
+    try t.eq(toUpper('日'), '日');
+    try t.eq(foldCase('ς'), 'σ');
+    try t.eq(foldCase('Σ'), 'σ');
+    try t.eq(foldCase('ſ'), 's');
+    try t.eq(foldCase('K'), 'k');
+}
+
+test "mapUtf8()" {
+    var buf: [256]u8 = undefined;
+    var n = mapUtf8(.upper, &buf, "abc 🦊 straße ıi ȿ");
+    try t.eqStr(buf[0..n], "ABC 🦊 STRAßE II Ȿ");
+    n = mapUtf8(.lower, &buf, "ΣΊΣΥΦΟΣ ABC");
+    try t.eqStr(buf[0..n], "σίσυφοσ abc");
+    n = mapUtf8(.fold, &buf, "Straſe ΣΑΣ");
+    try t.eqStr(buf[0..n], "strase σασ");
+
+    // ASCII blocks followed by multibyte runes.
+    const src = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzé";
+    n = mapUtf8(.upper, &buf, src);
+    try t.eqStr(buf[0..n], "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZÉ");
+}
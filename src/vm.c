@@ -601,6 +601,7 @@ ResultCode execBytecode(VM* vm) {
         JENTRY(IndexList),
         JENTRY(IndexTuple),
         JENTRY(IndexMap),
+        JENTRY(MapUpdate),
         JENTRY(AppendList),
         JENTRY(List),
         JENTRY(Map),
@@ -641,7 +642,10 @@ ResultCode execBytecode(VM* vm) {
         JENTRY(PowFloat),
         JENTRY(ModFloat),
         JENTRY(CompareNot),
+        JENTRY(CompareBits),
+        JENTRY(CompareNotBits),
         JENTRY(StringTemplate),
+        JENTRY(StringTemplateStrs),
         JENTRY(NegFloat),
         JENTRY(ObjectTypeCheck),
         JENTRY(ObjectSmall),
@@ -657,6 +661,9 @@ ResultCode execBytecode(VM* vm) {
         JENTRY(Coyield),
         JENTRY(Coresume),
         JENTRY(Coreturn),
+        JENTRY(CoinitGen),
+        JENTRY(CoyieldGen),
+        JENTRY(CoreturnGen),
         JENTRY(Retain),
         JENTRY(Box),
         JENTRY(SetBoxValue),
@@ -664,6 +671,7 @@ ResultCode execBytecode(VM* vm) {
         JENTRY(BoxValue),
         JENTRY(BoxValueRetain),
         JENTRY(Captured),
+        JENTRY(CapturedValue),
         JENTRY(SetCaptured),
         JENTRY(Tag),
         JENTRY(TagLiteral),
@@ -688,6 +696,7 @@ ResultCode execBytecode(VM* vm) {
         JENTRY(ForRange),
         JENTRY(ForRangeReverse),
         JENTRY(SeqDestructure),
+        JENTRY(SeqDestructureMove),
         JENTRY(Match),
         JENTRY(StaticFunc),
         JENTRY(StaticVar),
@@ -921,6 +930,50 @@ beginSwitch:
             NEXT();
         }
     }
+    CASE(MapUpdate): {
+        Value mapv = stack[pc[1]];
+        Value right = stack[pc[3]];
+        Value init = stack[pc[4]];
+        u8 flags = pc[5];
+        bool insert = (flags & MAP_UPDATE_DEFAULT) != 0;
+        bool rightInt = VALUE_IS_INTEGER(right);
+        // Only numeric updates are done in place. The default must have the same kind as `right`
+        // so that an inserted entry is never left for the unfused path.
+        if (VALUE_IS_MAP(mapv) && (rightInt || VALUE_IS_FLOAT(right)) &&
+            (!insert || (rightInt ? VALUE_IS_INTEGER(init) : VALUE_IS_FLOAT(init)))) {
+            Value* slot;
+            ResultCode code = zMapUpdateSlot(vm, (Map*)VALUE_AS_HEAPOBJECT(mapv), stack[pc[2]], init, insert, &slot);
+            if (UNLIKELY(code != RES_CODE_SUCCESS)) {
+                RETURN(code);
+            }
+            if (slot != NULL) {
+                Value cur = *slot;
+                if (rightInt && VALUE_IS_INTEGER(cur)) {
+                    _BitInt(48) a = VALUE_AS_INTEGER(cur);
+                    _BitInt(48) b = VALUE_AS_INTEGER(right);
+                    switch (flags & ~MAP_UPDATE_DEFAULT) {
+                        case MAP_UPDATE_ADD: *slot = VALUE_INTEGER(a + b); break;
+                        case MAP_UPDATE_SUB: *slot = VALUE_INTEGER(a - b); break;
+                        default:             *slot = VALUE_INTEGER(a * b); break;
+                    }
+                    pc += READ_U16(6);
+                    NEXT();
+                } else if (!rightInt && VALUE_IS_FLOAT(cur)) {
+                    double a = VALUE_AS_FLOAT(cur);
+                    double b = VALUE_AS_FLOAT(right);
+                    switch (flags & ~MAP_UPDATE_DEFAULT) {
+                        case MAP_UPDATE_ADD: *slot = VALUE_FLOAT(a + b); break;
+                        case MAP_UPDATE_SUB: *slot = VALUE_FLOAT(a - b); break;
+                        default:             *slot = VALUE_FLOAT(a * b); break;
+                    }
+                    pc += READ_U16(6);
+                    NEXT();
+                }
+            }
+        }
+        pc += MAP_UPDATE_INST_LEN;
+        NEXT();
+    }
     CASE(AppendList): {
         Value listv = stack[pc[1]];
         Value itemv = stack[pc[2]];
@@ -1406,6 +1459,16 @@ beginSwitch:
         pc += 4;
         NEXT();
     }
+    CASE(CompareBits): {
+        stack[pc[3]] = VALUE_BOOLEAN(stack[pc[1]] == stack[pc[2]]);
+        pc += 4;
+        NEXT();
+    }
+    CASE(CompareNotBits): {
+        stack[pc[3]] = VALUE_BOOLEAN(stack[pc[1]] != stack[pc[2]]);
+        pc += 4;
+        NEXT();
+    }
     CASE(StringTemplate): {
         u8 startLocal = pc[1];
         u8 exprCount = pc[2];
@@ -1421,6 +1484,21 @@ beginSwitch:
         }
         RETURN(res.code);
     }
+    CASE(StringTemplateStrs): {
+        u8 startLocal = pc[1];
+        u8 exprCount = pc[2];
+        u8 dst = pc[3];
+        u8 strCount = exprCount + 1;
+        Inst* strs = pc + 4;
+        Value* vals = stack + startLocal;
+        ValueResult res = zAllocStringTemplateStrs(vm, strs, strCount, vals, exprCount);
+        if (LIKELY(res.code == RES_CODE_SUCCESS)) {
+            stack[dst] = res.val;
+            pc += 4 + strCount;
+            NEXT();
+        }
+        RETURN(res.code);
+    }
     CASE(NegFloat): {
         FLOAT_UNOP(stack[pc[2]] = VALUE_FLOAT(-VALUE_AS_FLOAT(val)))
     }
@@ -1614,9 +1692,30 @@ beginSwitch:
         if (VALUE_IS_POINTER(fiber)) {
             HeapObject* obj = VALUE_AS_HEAPOBJECT(fiber);
             if (OBJ_TYPEID(obj) == TYPE_FIBER) {
-                if ((Fiber*)obj != vm->curFiber) {
-                    if (obj->fiber.pcOffset != NULL_U32) {
-                        PcSp res = zPushFiber(vm, pcOffset(vm, pc + 3), stack, (Fiber*)obj, pc[2]);
+                Fiber* f = (Fiber*)obj;
+                if (f->genState != GEN_NONE) {
+                    if (f->genState != GEN_RUNNING && f->pcOffset != NULL_U32) {
+                        Value* frame = stack + pc[3];
+                        if (frame + f->stackLen >= vm->stackEndPtr) {
+                            RETURN(RES_CODE_STACK_OVERFLOW);
+                        }
+                        memcpy(frame, f->stackPtr, f->stackLen * sizeof(Value));
+                        frame[1] = VALUE_RETINFO(false, INST_CORESUME_LEN);
+                        frame[2] = (uintptr_t)(pc + INST_CORESUME_LEN);
+                        frame[3] = (uintptr_t)stack;
+                        Inst* resumePc = vm->instPtr + f->pcOffset;
+                        if (f->genState == GEN_PAUSED) {
+                            // Continue after `CoyieldGen`.
+                            resumePc += 3;
+                        }
+                        f->genState = GEN_RUNNING;
+                        pc = resumePc;
+                        stack = frame;
+                        NEXT();
+                    }
+                } else if (f != vm->curFiber) {
+                    if (f->pcOffset != NULL_U32) {
+                        PcSp res = zPushFiber(vm, pcOffset(vm, pc + INST_CORESUME_LEN * 2), stack, f, pc[2]);
                         pc = res.pc;
                         stack = res.sp;
                         NEXT();
@@ -1625,7 +1724,8 @@ beginSwitch:
             }
             releaseObject(vm, obj);
         }
-        pc += 3;
+        // Skip `CoreturnGen`.
+        pc += INST_CORESUME_LEN * 2;
         NEXT();
     }
     CASE(Coreturn): {
@@ -1637,6 +1737,55 @@ beginSwitch:
         }
         NEXT();
     }
+    CASE(CoinitGen): {
+        u8 startArgsLocal = pc[1];
+        u8 numArgs = pc[2];
+        u16 symId = READ_U16(3);
+        u8 dst = pc[5];
+
+        ValueResult res = zAllocGen(vm, symId, stack + startArgsLocal, numArgs);
+        if (res.code != RES_CODE_SUCCESS) {
+            RETURN(res.code);
+        }
+        stack[dst] = res.val;
+        pc += 6;
+        NEXT();
+    }
+    CASE(CoyieldGen): {
+        if (VALUE_RETINFO_RETFLAG(stack[1]) == 0) {
+            Inst* retPc = (Inst*)stack[2];
+            if (retPc[0] == CodeCoreturnGen) {
+                // Suspend generator. Its frame is copied back to the heap.
+                Value* parent = (Value*)stack[3];
+                Fiber* gen = (Fiber*)VALUE_AS_HEAPOBJECT(parent[retPc[1]]);
+                memcpy(gen->stackPtr, stack, gen->stackLen * sizeof(Value));
+                gen->pcOffset = pcOffset(vm, pc);
+                gen->genState = GEN_PAUSED;
+                parent[retPc[2]] = VALUE_NONE;
+                releaseObject(vm, (HeapObject*)gen);
+                pc = retPc + INST_CORESUME_LEN;
+                stack = parent;
+                NEXT();
+            }
+        }
+        if (vm->curFiber != &vm->mainFiber) {
+            PcSpOff res = zPopFiber(vm, pcOffset(vm, pc), stack, VALUE_NONE);
+            pc = vm->instPtr + res.pc;
+            stack = vm->stackPtr + res.sp;
+        } else {
+            pc += 3;
+        }
+        NEXT();
+    }
+    CASE(CoreturnGen): {
+        Fiber* gen = (Fiber*)VALUE_AS_HEAPOBJECT(stack[pc[1]]);
+        gen->pcOffset = NULL_U32;
+        gen->genState = GEN_DONE;
+        stack[pc[2]] = stack[pc[3]];
+        releaseObject(vm, (HeapObject*)gen);
+        pc += INST_CORESUME_LEN;
+        NEXT();
+    }
     CASE(Retain): {
         retain(vm, stack[pc[1]]);
         pc += 2;
@@ -1728,6 +1877,21 @@ beginSwitch:
         pc += 4;
         NEXT();
     }
+    CASE(CapturedValue): {
+        Value closure = stack[pc[1]];
+#if TRACE
+        if (!VALUE_IS_CLOSURE(closure)) {
+            TRACEV("Expected closure value.");
+            zFatal();
+        }
+#endif
+        // Immutable captures are copied into the closure without a box.
+        Value val = closureGetCapturedValuesPtr(&VALUE_AS_HEAPOBJECT(closure)->closure)[pc[2]];
+        retain(vm, val);
+        stack[pc[3]] = val;
+        pc += 4;
+        NEXT();
+    }
     CASE(SetCaptured): {
         Value closure = stack[pc[1]];
 #if TRACE
@@ -1945,6 +2109,45 @@ beginSwitch:
             RETURN(RES_CODE_PANIC);
         }
     }
+    CASE(SeqDestructureMove): {
+        // Same as `SeqDestructure` except the source is a temporary that dies here.
+        Value val = stack[pc[1]];
+        u8 numDst = pc[2];
+
+        if (getTypeId(val) != TYPE_TUPLE) {
+            panicStaticMsg(vm, "Expected tuple.");
+            RETURN(RES_CODE_PANIC);
+        }
+        Tuple* tuple = (Tuple*)VALUE_AS_HEAPOBJECT(val);
+        if (tuple->len < numDst) {
+            panicStaticMsg(vm, "Not enough elements.");
+            RETURN(RES_CODE_PANIC);
+        }
+        Value* elems = &tuple->firstValue;
+        if (tuple->rc == 1) {
+            // Sole owner: move the elements out so freeing the tuple doesn't release them.
+            if (numDst == 2) {
+                stack[pc[3]] = elems[0];
+                stack[pc[4]] = elems[1];
+                elems[0] = VALUE_NONE;
+                elems[1] = VALUE_NONE;
+            } else {
+                for (int i = 0; i < numDst; i += 1) {
+                    stack[pc[3+i]] = elems[i];
+                    elems[i] = VALUE_NONE;
+                }
+            }
+        } else {
+            for (int i = 0; i < numDst; i += 1) {
+                retain(vm, elems[i]);
+                stack[pc[3+i]] = elems[i];
+            }
+        }
+        releaseObject(vm, (HeapObject*)tuple);
+        stack[pc[1]] = VALUE_NONE;
+        pc += 3 + numDst;
+        NEXT();
+    }
     CASE(Match): {
         pc += zOpMatch(pc, stack);
         NEXT();
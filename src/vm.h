@@ -199,9 +199,15 @@ typedef struct FmtValue {
 } FmtValue;
 
 #define CALL_OBJ_SYM_INST_LEN 16
+#define MAP_UPDATE_INST_LEN 8
+
+/// `MapUpdate` flags. The lower bits hold a `MapUpdateOp`.
+/// Missing keys are inserted with the default operand before applying the op.
+#define MAP_UPDATE_DEFAULT 0x80
 #define CALL_SYM_INST_LEN 12
 #define CALL_INST_LEN 4
 #define INST_COINIT_LEN 7
+#define INST_CORESUME_LEN 4
 
 #define CALL_ARG_START 5
 #define CALLEE_START 4
@@ -238,6 +244,13 @@ typedef enum {
     CodeIndexList,
     CodeIndexTuple,
     CodeIndexMap,
+
+    /// [mapReg] [keyReg] [rightReg] [defaultReg] [flags] [skipOffset u16]
+    /// Fused read-modify-write of a map entry, eg. `m[k] += 1`. Looks up the key once and applies
+    /// the `MapUpdateOp` in place. If the update can't be done in place, execution falls through to
+    /// the unfused instructions that follow. Otherwise, jumps forward by `skipOffset`.
+    CodeMapUpdate,
+
     CodeAppendList,
     CodeList,
     CodeMap,
@@ -287,7 +300,13 @@ typedef enum {
     /// Perform modulus on the two locals and stores result to a dst local.
     CodeModFloat,
     CodeCompareNot,
+    /// Compares the raw bits of two locals. Used when an operand is statically known to be
+    /// a primitive such as a symbol or enum tag which can only equal an identical value.
+    CodeCompareBits,
+    CodeCompareNotBits,
     CodeStringTemplate,
+    /// String template where every expression is known to be a string.
+    CodeStringTemplateStrs,
     CodeNegFloat,
     CodeObjectTypeCheck,
     CodeObjectSmall,
@@ -306,8 +325,26 @@ typedef enum {
     CodeThrow,
     CodeCoinit,
     CodeCoyield,
+
+    /// [fiberReg] [dstReg] [frameStartReg]
+    /// Resumes a fiber or a stackless generator. Always followed by `CoreturnGen`.
+    /// A generator's frame is copied to `frameStartReg` and called so that it returns to `CoreturnGen`.
     CodeCoresume,
     CodeCoreturn,
+
+    /// [startArgsReg] [numArgs] [symId u16] [dstReg]
+    /// Creates a stackless generator for a function that only yields from statements in its own body.
+    /// The args are moved into a heap frame instead of a new fiber stack.
+    CodeCoinitGen,
+
+    /// [startLocalReg] [endLocalReg]
+    /// Same as `Coyield` except when the frame was resumed as a generator, in which case
+    /// the frame is copied back to the generator and control returns after `CoreturnGen`.
+    CodeCoyieldGen,
+
+    /// [fiberReg] [dstReg] [frameStartReg]
+    /// A generator's frame returns here when it's done.
+    CodeCoreturnGen,
     CodeRetain,
     CodeBox,
     CodeSetBoxValue,
@@ -315,6 +352,7 @@ typedef enum {
     CodeBoxValue,
     CodeBoxValueRetain,
     CodeCaptured,
+    CodeCapturedValue,
     CodeSetCaptured,
     CodeTag,
     CodeTagLiteral,
@@ -339,6 +377,7 @@ typedef enum {
     CodeForRange,
     CodeForRangeReverse,
     CodeSeqDestructure,
+    CodeSeqDestructureMove,
     CodeMatch,
     CodeStaticFunc,
     CodeStaticVar,
@@ -508,8 +547,20 @@ typedef struct Fiber {
 
     u8 argStart;
     u8 numArgs;
+
+    /// `GEN_NONE` if this is a fiber. A stackless generator uses `stackPtr` as its heap frame
+    /// and `pcOffset` as the function entry or the last `CoyieldGen`.
+    u8 genState;
 } Fiber;
 
+typedef enum {
+    GEN_NONE = 0,
+    GEN_INIT,
+    GEN_PAUSED,
+    GEN_RUNNING,
+    GEN_DONE,
+} GenState;
+
 /// One data structure for astring/ustring slice it can fit into a pool object
 /// and use the same layout.
 typedef struct StringSlice {
@@ -752,6 +803,12 @@ typedef struct TraceInfo {
     u32 numCycFrees;
 } TraceInfo;
 
+typedef enum {
+    MAP_UPDATE_ADD,
+    MAP_UPDATE_SUB,
+    MAP_UPDATE_MUL,
+} MapUpdateOp;
+
 typedef enum {
     FUNC_SYM_FUNC,
     FUNC_SYM_HOSTFUNC,
@@ -900,7 +957,7 @@ typedef struct VM {
         void* ptr;
         void* vtable;
     } httpClient;
-    void* stdHttpClient;
+    void* httpPool;
     size_t expGlobalRC;
     ZList varSymExtras;
     size_t endLocal;
@@ -909,12 +966,14 @@ typedef struct VM {
     u32 padding;
     #endif
     Str lastExeError;
+    void* finderCache;
+    void* osProcCache;
 #else
     struct {
         void* ptr;
         void* vtable;
     } httpClient;
-    void* stdHttpClient;
+    void* httpPool;
     Value emptyString;
     Value emptyArray;
     size_t expGlobalRC;
@@ -923,6 +982,8 @@ typedef struct VM {
     size_t endLocal;
 
     Str lastExeError;
+    void* finderCache;
+    void* osProcCache;
 
     #if TRACE
     u32 debugPc;
@@ -1005,6 +1066,7 @@ double zOtherToF64(Value val);
 CallObjSymResult zCallObjSym(VM* vm, Inst* pc, Value* stack, Value recv, TypeId typeId, uint8_t mgId, u8 startLocal, u8 numArgs, u16 anySelfFuncSigId);
 ValueResult zAllocFiber(VM* vm, uint32_t pc, Value* args, uint8_t nargs, uint8_t argDst, uint8_t initialStackSize);
 PcSp zPushFiber(VM* vm, size_t curFiberEndPc, Value* curStack, Fiber* fiber, uint8_t parentDstLocal);
+ValueResult zAllocGen(VM* vm, uint16_t symId, Value* args, uint8_t nargs);
 PcSpOff zPopFiber(VM* vm, size_t curFiberEndPc, Value* curStack, Value retValue);
 uint8_t zGetFieldOffsetFromTable(VM* vm, TypeId typeId, uint32_t symId);
 Value zEvalCompare(Value left, Value right);
@@ -1015,6 +1077,7 @@ HeapObjectResult zAllocExternalObject(VM* vm, size_t size);
 HeapObjectResult zAllocExternalCycObject(VM* vm, size_t size);
 ValueResult zAllocStringTemplate(VM* vm, Inst* strs, u8 strCount, Value* vals, u8 valCount);
 ValueResult zAllocStringTemplate2(VM* vm, Value* strs, u8 strCount, Value* vals, u8 valCount);
+ValueResult zAllocStringTemplateStrs(VM* vm, Inst* strs, u8 strCount, Value* vals, u8 valCount);
 ValueResult zAllocMap(VM* vm, u16* keyIdxs, Value* vals, u32 numEntries);
 Value zGetFieldFallback(VM* vm, HeapObject* obj, NameId nameId);
 void zPanicIncompatibleFuncSig(VM* vm, FuncId funcId, Value* args, size_t numArgs, FuncSigId targetFuncSigId);
@@ -1027,6 +1090,7 @@ void zCheckRetainDanglingPointer(VM* vm, HeapObject* obj);
 void zPanicFmt(VM* vm, const char* format, FmtValue* args, size_t numArgs);
 Value zValueMapGet(ValueMap* map, Value key, bool* found);
 ResultCode zMapSet(VM* vm, Map* map, Value key, Value val);
+ResultCode zMapUpdateSlot(VM* vm, Map* map, Value key, Value init, bool insert, Value** outSlot);
 Inst* zDeoptBinOp(VM* vm, Inst* pc);
 Str zGetTypeName(VM* vm, TypeId id);
 ResultCode zEnsureListCap(VM* vm, ZCyList* list, size_t cap);
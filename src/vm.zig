@@ -30,6 +30,9 @@ const UserVM = cy.UserVM;
 
 const logger = cy.log.scoped(.vm);
 
+/// Ops capacity reserved by `evalRepl` so that appending inputs rarely moves existing code.
+const ReplOpsCapacity = 1 << 20;
+
 const UseGlobalVM = true;
 const StdSection = cy.StdSection;
 
@@ -146,9 +149,10 @@ pub const VM = struct {
     /// debugPc == NullId indicates execution has not started.
     debugPc: if (cy.Trace) u32 else void,
 
-    /// Interface used for imports and fetch.
+    /// Interface used for imports and fetch. Deinited by the VM, including a client set by the host.
     httpClient: http.HttpClient,
-    stdHttpClient: if (cy.hasCLI) *http.StdHttpClient else *anyopaque,
+    /// Keep-alive connections behind the default `httpClient`.
+    httpPool: if (cy.hasCLI) *http.PooledHttpClient else *anyopaque,
 
     emptyString: Value,
     emptyArray: Value,
@@ -176,6 +180,12 @@ pub const VM = struct {
 
     lastExeError: []const u8,
 
+    /// Preprocessed needles for `find`, `split` and `replace`.
+    finderCache: *cy.string.FinderCache,
+
+    /// Env and args snapshots of the `os` module. Created on first use and freed by the module's `onDestroy`.
+    osProcCache: ?*anyopaque,
+
     pub fn init(self: *VM, alloc: std.mem.Allocator) !void {
         self.* = .{
             .alloc = alloc,
@@ -235,7 +245,7 @@ pub const VM = struct {
             .funcSymDeps = .{},
             .config = undefined,
             .httpClient = undefined,
-            .stdHttpClient = undefined,
+            .httpPool = undefined,
             .lastError = null,
             .userData = null,
             .expGlobalRC = 0,
@@ -246,17 +256,22 @@ pub const VM = struct {
             .numFreed = if (cy.Trace) 0 else {},
             .tempBuf = undefined,
             .lastExeError = "",
+            .finderCache = undefined,
+            .osProcCache = null,
         };
         self.mainFiber.panicType = vmc.PANIC_NONE;
+        self.mainFiber.genState = vmc.GEN_NONE;
         self.curFiber = &self.mainFiber;
+        self.finderCache = try self.alloc.create(cy.string.FinderCache);
+        self.finderCache.* = .{};
         self.compiler = try self.alloc.create(cy.VMcompiler);
         self.sema = &self.compiler.sema;
         try self.compiler.init(self);
 
         if (cy.hasCLI) {
-            self.stdHttpClient = try alloc.create(http.StdHttpClient);
-            self.stdHttpClient.* = http.StdHttpClient.init(self.alloc);
-            self.httpClient = self.stdHttpClient.iface();
+            self.httpPool = try alloc.create(http.PooledHttpClient);
+            self.httpPool.* = http.PooledHttpClient.init(self.alloc, http.StdHttpClientFactory.shared(), .{});
+            self.httpClient = self.httpPool.iface();
         }
 
         if (cy.Trace) {
@@ -430,6 +445,8 @@ pub const VM = struct {
         }
 
         self.stackTrace.deinit(self.alloc);
+        // Cached finders can refer to freed needle objects.
+        self.finderCache.clear();
         if (reset) {
             self.u8Buf.clearRetainingCapacity();
             self.strInterns.clearRetainingCapacity();
@@ -481,12 +498,18 @@ pub const VM = struct {
 
         if (!reset) {
             if (cy.hasCLI) {
+                // The VM owns `httpClient`, including one set by the host.
+                // The default pool is still released when it was replaced.
                 self.httpClient.deinit();
-                self.alloc.destroy(self.stdHttpClient);
+                if (self.httpClient.ptr != @as(*anyopaque, @ptrCast(self.httpPool))) {
+                    self.httpPool.deinit();
+                }
+                self.alloc.destroy(self.httpPool);
             }
         }
 
         if (!reset) {
+            self.alloc.destroy(self.finderCache);
             self.deinited = true;
         }
 
@@ -553,20 +576,7 @@ pub const VM = struct {
             .backend = config.backend,
         });
         if (res.err) |err| {
-            switch (err) {
-                .tokenize => {
-                    self.lastError = error.TokenError;
-                    return error.TokenError;
-                },
-                .parse => {
-                    self.lastError = error.ParseError;
-                    return error.ParseError;
-                },
-                .compile => {
-                    self.lastError = error.CompileError;
-                    return error.CompileError;
-                },
-            }
+            return self.setCompileError(err);
         }
         tt.endPrint("compile");
 
@@ -625,7 +635,7 @@ pub const VM = struct {
             tt = cy.debug.timer();
             defer tt.endPrint("eval");
 
-            return self.evalByteCode(res.inner.vm);
+            return self.evalByteCode(res.inner.vm, 0);
         } else {
             defer res.inner.aot.deinit(self.alloc);
             if (cy.isFreestanding or cy.isWasm) {
@@ -660,6 +670,114 @@ pub const VM = struct {
         }
     }
 
+    /// Compiles and evaluates `src` as the next REPL input. Unlike `eval`, the VM is not reset,
+    /// so vars, funcs and types declared by previous inputs stay alive and only the new code is
+    /// appended to the bytecode buffer. Only the `vm` backend is supported and the VM should not
+    /// be used with `eval` in the same session.
+    pub fn evalRepl(self: *VM, src: []const u8, config: EvalConfig) !Value {
+        if (!cy.hasGC) {
+            // Suspended fibers can only be found through the cyclable list when the ops buffer moves.
+            return error.Unsupported;
+        }
+        if (self.compiler.chunks.items.len == 0) {
+            // Load builtins with an empty input first so a failed input never has to roll them back.
+            _ = try self.evalReplInput("", config);
+        }
+        return self.evalReplInput(src, config);
+    }
+
+    fn evalReplInput(self: *VM, src: []const u8, config: EvalConfig) !Value {
+        self.config = config;
+        const buf = &self.compiler.buf;
+        if (buf.ops.capacity < ReplOpsCapacity) {
+            try buf.ops.ensureTotalCapacityPrecise(self.alloc, ReplOpsCapacity);
+        }
+        const mainPc = buf.ops.items.len;
+
+        var tt = cy.debug.timer();
+        const res = try self.compiler.compileRepl(src, .{
+            .enableFileModules = config.enableFileModules,
+            .genDebugFuncMarkers = cy.Trace,
+        });
+        if (res.err) |err| {
+            return self.setCompileError(err);
+        }
+        tt.endPrint("compile");
+
+        if (mainPc > 0 and self.ops.ptr != buf.ops.items.ptr) {
+            self.rebaseCallFuncIC(@intFromPtr(self.ops.ptr));
+            self.rebaseFiberStacks(@intFromPtr(self.ops.ptr));
+        }
+
+        tt = cy.debug.timer();
+        defer tt.endPrint("eval");
+        return self.evalByteCode(res.inner.vm, mainPc);
+    }
+
+    fn setCompileError(self: *VM, err: cy.CompileErrorType) error{TokenError, ParseError, CompileError} {
+        switch (err) {
+            .tokenize => {
+                self.lastError = error.TokenError;
+                return error.TokenError;
+            },
+            .parse => {
+                self.lastError = error.ParseError;
+                return error.ParseError;
+            },
+            .compile => {
+                self.lastError = error.CompileError;
+                return error.CompileError;
+            },
+        }
+    }
+
+    /// Patches inline caches after the ops buffer has moved from `oldBase`.
+    /// `callFuncIC` is the only inst that caches an absolute pc. It's quickened from `callSym`
+    /// which is failable, so every instance can be found from the debug table.
+    fn rebaseCallFuncIC(self: *VM, oldBase: usize) void {
+        const ops = self.compiler.buf.ops.items;
+        const newBase = @intFromPtr(ops.ptr);
+        var prevPc: u32 = cy.NullId;
+        for (self.compiler.buf.debugTable.items) |sym| {
+            if (sym.pc == prevPc) {
+                continue;
+            }
+            prevPc = sym.pc;
+            const pc = ops.ptr + sym.pc;
+            if (pc[0].opcode() == .callFuncIC) {
+                const target: *align(1) u48 = @ptrCast(pc + 6);
+                const addr: usize = target.*;
+                target.* = @intCast(addr - oldBase + newBase);
+            }
+        }
+    }
+
+    /// Patches the return pcs saved on the stacks of suspended fibers after the ops buffer has moved from `oldBase`.
+    /// Fibers are cyclable objects so they are all found in the cyclable list.
+    /// Paused generators are skipped since a resume saves a new return pc.
+    fn rebaseFiberStacks(self: *VM, oldBase: usize) void {
+        const newBase = @intFromPtr(self.compiler.buf.ops.items.ptr);
+        var mbNode: ?*cy.heap.DListNode = self.cyclableHead;
+        while (mbNode) |node| {
+            mbNode = node.next;
+            const obj = node.getHeapObject();
+            if (obj.getTypeId() != bt.Fiber) {
+                continue;
+            }
+            const fiber: *cy.Fiber = @ptrCast(obj);
+            if (fiber.genState != vmc.GEN_NONE or fiber.pcOffset == cy.NullId) {
+                continue;
+            }
+            const stack = @as([*]Value, @ptrCast(fiber.stackPtr));
+            var fp = fiber.stackOffset;
+            while (fp > 0) {
+                const addr = @intFromPtr(stack[fp + 2].retPcPtr);
+                stack[fp + 2] = Value{ .retPcPtr = @ptrFromInt(addr - oldBase + newBase) };
+                fp = cy.fiber.getStackOffset(stack, stack[fp + 3].retFramePtr);
+            }
+        }
+    }
+
     pub fn dumpStats(self: *const VM) void {
         const S = struct {
             fn opCountLess(_: void, a: vmc.OpCount, b: vmc.OpCount) bool {
@@ -754,7 +872,8 @@ pub const VM = struct {
         @memset(self.stack, val);
     }
 
-    pub fn evalByteCode(self: *VM, buf: cy.ByteCodeBuffer) !Value {
+    /// Evaluates `buf` starting at the `mainPc` offset.
+    pub fn evalByteCode(self: *VM, buf: cy.ByteCodeBuffer, mainPc: usize) !Value {
         if (buf.ops.items.len == 0) {
             return error.NoEndOp;
         }
@@ -767,7 +886,7 @@ pub const VM = struct {
         self.unwindTempPrevIndexes = buf.unwindTempPrevIndexes.items;
 
         // Set these last to hint location to cache before eval.
-        self.pc = @ptrCast(buf.ops.items.ptr);
+        self.pc = @ptrCast(buf.ops.items.ptr + mainPc);
         try cy.fiber.stackEnsureTotalCapacity(self, buf.mainStackSize);
         self.framePtr = @ptrCast(self.stack.ptr);
 
@@ -938,6 +1057,57 @@ pub const VM = struct {
         return self.syms.buf[id].name;
     }
 
+    /// Returns the symbol's string as `.name` or `name` with a +1 ref.
+    /// The string is interned once and cached in the symbol table so that converting
+    /// the same symbol again doesn't format or hash its name.
+    pub fn getSymbolStr(self: *VM, id: SymbolId, comptime withDot: bool) !Value {
+        const sym = &self.syms.buf[id];
+        const cached = if (withDot) &sym.str else &sym.nameStr;
+        if (cached.*) |obj| {
+            cy.arc.retainObject(self, obj);
+            return Value.initPtr(obj);
+        }
+
+        var str: Value = undefined;
+        if (withDot) {
+            const dotName = try std.fmt.allocPrint(self.alloc, ".{s}", .{sym.name});
+            defer self.alloc.free(dotName);
+            str = try self.allocStringInternOrArray(dotName);
+        } else {
+            str = try self.allocStringInternOrArray(sym.name);
+        }
+        try self.staticObjects.append(self.alloc, str.asHeapObject());
+        cached.* = str.asHeapObject();
+        self.retain(str);
+        return str;
+    }
+
+    /// Returns an enum value's string as `Type.member` or `member` with a +1 ref.
+    /// Cached on the member's sym the same way `getSymbolStr` caches symbol strings.
+    pub fn getEnumStr(self: *VM, val: Value, comptime withType: bool) !Value {
+        const enumT = self.types[val.getEnumType()].sym.cast(.enumType);
+        const member = enumT.getValueSym(val.getEnumValue()).cast(.enumMember);
+        const cached = if (withType) &member.str else &member.nameStr;
+        if (cached.*) |ptr| {
+            const obj: *HeapObject = @ptrCast(@alignCast(ptr));
+            cy.arc.retainObject(self, obj);
+            return Value.initPtr(obj);
+        }
+
+        var str: Value = undefined;
+        if (withType) {
+            const fullName = try std.fmt.allocPrint(self.alloc, "{s}.{s}", .{enumT.head.name(), member.head.name()});
+            defer self.alloc.free(fullName);
+            str = try self.allocStringInternOrArray(fullName);
+        } else {
+            str = try self.allocStringInternOrArray(member.head.name());
+        }
+        try self.staticObjects.append(self.alloc, str.asHeapObject());
+        cached.* = str.asHeapObject();
+        self.retain(str);
+        return str;
+    }
+
     pub fn ensureSymbol(self: *VM, name: []const u8) !SymbolId {
         return self.ensureSymbolExt(name, false);
     }
@@ -1714,6 +1884,12 @@ const Symbol = struct {
     },
     name: []const u8,
     nameOwned: bool,
+
+    /// Interned `.name` string, created on first conversion. Owned by `staticObjects`.
+    str: ?*HeapObject = null,
+
+    /// Interned `name` string, created on first `name()`. Owned by `staticObjects`.
+    nameStr: ?*HeapObject = null,
 };
 
 test "vm internals." {
@@ -1776,7 +1952,7 @@ test "vm internals." {
     try t.eq(@offsetOf(VM, "printFn"), @offsetOf(vmc.VM, "printFn"));
     try t.eq(@offsetOf(VM, "errorFn"), @offsetOf(vmc.VM, "errorFn"));
     try t.eq(@offsetOf(VM, "httpClient"), @offsetOf(vmc.VM, "httpClient"));
-    try t.eq(@offsetOf(VM, "stdHttpClient"), @offsetOf(vmc.VM, "stdHttpClient"));
+    try t.eq(@offsetOf(VM, "httpPool"), @offsetOf(vmc.VM, "httpPool"));
     try t.eq(@offsetOf(VM, "emptyString"), @offsetOf(vmc.VM, "emptyString"));
     try t.eq(@offsetOf(VM, "emptyArray"), @offsetOf(vmc.VM, "emptyArray"));
     try t.eq(@offsetOf(VM, "expGlobalRC"), @offsetOf(vmc.VM, "expGlobalRC"));
@@ -1790,6 +1966,8 @@ test "vm internals." {
     }
 
     try t.eq(@offsetOf(VM, "lastExeError"), @offsetOf(vmc.VM, "lastExeError"));
+    try t.eq(@offsetOf(VM, "finderCache"), @offsetOf(vmc.VM, "finderCache"));
+    try t.eq(@offsetOf(VM, "osProcCache"), @offsetOf(vmc.VM, "osProcCache"));
 
     if (cy.Trace) {
         try t.eq(@offsetOf(VM, "debugPc"), @offsetOf(vmc.VM, "debugPc"));
@@ -2917,7 +3095,7 @@ fn evalLoop(vm: *VM) linksection(cy.HotSection) error{StackOverflow, OutOfMemory
                         if (fiber != vm.curFiber) {
                             // Only resume fiber if it's not done.
                             if (fiber.pcOffset != cy.NullId) {
-                                const res = cy.fiber.pushFiber(vm, getInstOffset(vm, pc + 3), framePtr, fiber, pc[2].val);
+                                const res = cy.fiber.pushFiber(vm, getInstOffset(vm, pc + 8), framePtr, fiber, pc[2].val);
                                 pc = res.pc;
                                 framePtr = res.sp;
                                 continue;
@@ -2926,7 +3104,8 @@ fn evalLoop(vm: *VM) linksection(cy.HotSection) error{StackOverflow, OutOfMemory
                     }
                     cy.arc.releaseObject(vm, cy.ptrAlignCast(*HeapObject, fiber));
                 }
-                pc += 3;
+                // Skip `coreturnGen`.
+                pc += 8;
                 continue;
             },
             .coyield => {
@@ -3914,6 +4093,16 @@ fn opMatch(pc: [*]const cy.Inst, framePtr: [*]const Value) u16 {
     const expr = framePtr[pc[1].val];
     const numCases = pc[2].val;
     var i: u32 = 0;
+    if (!expr.isPointer()) {
+        // Numbers, symbols, enums and other primitives only match by value bits.
+        while (i < numCases) : (i += 1) {
+            const right = framePtr[pc[3 + i * 3].val];
+            if (expr.val == right.val) {
+                return @as(*const align (1) u16, @ptrCast(pc + 4 + i * 3)).*;
+            }
+        }
+        return @as(*const align (1) u16, @ptrCast(pc + 4 + i * 3 - 1)).*;
+    }
     while (i < numCases) : (i += 1) {
         const right = framePtr[pc[3 + i * 3].val];
         // Can immediately match numbers, objects, primitives.
@@ -4446,6 +4635,19 @@ export fn zAllocFiber(vm: *cy.VM, pc: u32, args: [*]const Value, nargs: u8, argD
     };
 }
 
+export fn zAllocGen(vm: *cy.VM, symId: u16, args: [*]const Value, nargs: u8) vmc.ValueResult {
+    const gen = cy.fiber.allocGen(vm, symId, args[0..nargs]) catch {
+        return .{
+            .val = undefined,
+            .code = vmc.RES_CODE_UNKNOWN,
+        };
+    };
+    return .{
+        .val = @bitCast(gen),
+        .code = vmc.RES_CODE_SUCCESS,
+    };
+}
+
 export fn zPushFiber(vm: *cy.VM, curFiberEndPc: usize, curStack: [*]Value, fiber: *cy.Fiber, parentDstLocal: u8) vmc.PcSp {
     const res = cy.fiber.pushFiber(vm, curFiberEndPc, curStack, fiber, parentDstLocal);
     return .{
@@ -4563,6 +4765,19 @@ export fn zAllocStringTemplate(vm: *cy.VM, strs: [*]cy.Inst, strCount: u8, vals:
     };
 }
 
+export fn zAllocStringTemplateStrs(vm: *cy.VM, strs: [*]cy.Inst, strCount: u8, vals: [*]Value, valCount: u8) vmc.ValueResult {
+    const val = cy.heap.allocStringTemplateStrs(vm, strs[0..strCount], vals[0..valCount]) catch {
+        return .{
+            .val = undefined,
+            .code = vmc.RES_CODE_UNKNOWN,
+        };
+    };
+    return .{
+        .val = @bitCast(val),
+        .code = vmc.RES_CODE_SUCCESS,
+    };
+}
+
 pub export fn zAllocStringTemplate2(vm: *cy.VM, strs: [*]cy.Value, strCount: u8, vals: [*]Value, valCount: u8) vmc.ValueResult {
     const val = cy.heap.allocStringTemplate2(vm, strs[0..strCount], vals[0..valCount]) catch {
         return .{
@@ -4688,6 +4903,26 @@ export fn zMapSet(vm: *VM, map: *cy.heap.Map, key: Value, val: Value) vmc.Result
     return vmc.RES_CODE_SUCCESS;
 }
 
+/// Returns the value slot of `key` in `outSlot` or null if it doesn't exist.
+/// If `insert` is true, a missing key is retained and inserted with `init`.
+export fn zMapUpdateSlot(vm: *VM, map: *cy.heap.Map, key: Value, init: Value, insert: bool, outSlot: *?*Value) vmc.ResultCode {
+    const inner = map.map();
+    if (insert) {
+        const res = inner.getOrPut(vm.alloc, key) catch {
+            return vmc.RES_CODE_UNKNOWN;
+        };
+        if (!res.foundExisting) {
+            cy.arc.retain(vm, key);
+            cy.arc.retain(vm, init);
+            res.valuePtr.* = init;
+        }
+        outSlot.* = res.valuePtr;
+    } else {
+        outSlot.* = inner.getPtr(key);
+    }
+    return vmc.RES_CODE_SUCCESS;
+}
+
 export fn zValueMapGet(map: *cy.ValueMap, key: Value, found: *bool) Value {
     if (map.get(key)) |val| {
         found.* = true;
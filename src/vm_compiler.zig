@@ -77,6 +77,16 @@ pub const VMcompiler = struct {
     /// Whether builtins should be imported.
     importBuiltins: bool = true,
 
+    /// Builtins module. Loaded once and imported into each user module.
+    builtinSym: ?*cy.sym.Chunk = null,
+
+    /// Main chunks of previous REPL inputs, newest first so that later declarations shadow earlier ones.
+    replChunks: std.ArrayListUnmanaged(*cy.Sym) = .{},
+
+    /// End of the types that codegen has registered with the VM's field and method tables.
+    /// A failed REPL input can only drop its types before they are registered.
+    preparedTypesEnd: u32 = 0,
+
     iteratorMGID: vmc.MethodGroupId = cy.NullId,
     seqIteratorMGID: vmc.MethodGroupId = cy.NullId,
     nextMGID: vmc.MethodGroupId = cy.NullId,
@@ -172,12 +182,16 @@ pub const VMcompiler = struct {
             self.chunkMap.clearRetainingCapacity();
             self.genSymMap.clearRetainingCapacity();
             self.importTasks.clearRetainingCapacity();
+            self.replChunks.clearRetainingCapacity();
+            self.preparedTypesEnd = 0;
         } else {
             self.chunks.deinit(self.alloc);
             self.chunkMap.deinit(self.alloc);
             self.genSymMap.deinit(self.alloc);
             self.importTasks.deinit(self.alloc);
+            self.replChunks.deinit(self.alloc);
         }
+        self.builtinSym = null;
 
         // Chunks depends on modules.
         self.sema.deinit(self.alloc, reset);
@@ -197,41 +211,109 @@ pub const VMcompiler = struct {
             self.vm.types = self.sema.types.items;
         }
         const res = self.compileInner(srcUri, src, config) catch |err| {
-            if (err == error.TokenError) {
-                return CompileResult{
-                    .inner = undefined,
-                    .err = .tokenize,
-                };
-            } else if (err == error.ParseError) {
-                return CompileResult{
-                    .inner = undefined,
-                    .err = .parse,
-                };
-            } else {
-                if (dumpCompileErrorStackTrace and !cy.silentError) {
-                    std.debug.dumpStackTrace(@errorReturnTrace().?.*);
-                }
-                if (err != error.CompileError) {
-                    if (self.chunks.items.len > 0) {
-                        // Report other errors using the main chunk.
-                        const chunk = self.chunks.items[0];
-                        try chunk.setErrorFmtAt("Error: {}", &.{v(err)}, cy.NullId);
-                    } else {
-                        return err;
-                    }
-                }
-                return CompileResult{
-                    .inner = undefined,
-                    .err = .compile,
-                };
+            return self.handleCompileError(err, 0);
+        };
+        return CompileResult{
+            .inner = res,
+            .err = null,
+        };
+    }
+
+    /// Compiles `src` as a new main chunk on top of the chunks compiled by previous calls.
+    /// Previous REPL chunks are imported into the new chunk's namespace and only the new chunks
+    /// are appended to the bytecode buffer. Constants are not merged into the ops buffer
+    /// since later inputs can add more.
+    pub fn compileRepl(self: *VMcompiler, src: []const u8, config: CompileConfig) !CompileResult {
+        defer {
+            // Update VM types view.
+            self.vm.types = self.sema.types.items;
+        }
+        const firstChunk: u32 = @intCast(self.chunks.items.len);
+        const typesStart: u32 = @intCast(self.sema.types.items.len);
+        const funcSymsStart = self.vm.funcSyms.len;
+        const varSymsStart = self.vm.varSyms.len;
+        const constsStart = self.buf.consts.items.len;
+        const opsStart = self.buf.ops.items.len;
+        const debugStart = self.buf.debugTable.items.len;
+        const markersStart = self.buf.debugMarkers.items.len;
+        const res = self.compileReplInner(src, config) catch |err| {
+            // Drop the failed chunks so that later inputs don't see their symbols.
+            // The chunks are kept alive until reset since syms can still point to them.
+            for (self.chunks.items[firstChunk..]) |chunk| {
+                _ = self.chunkMap.remove(chunk.srcUri);
             }
+            for (self.importTasks.items) |task| {
+                self.alloc.free(task.absSpec);
+                self.alloc.destroy(task.sym);
+            }
+            self.importTasks.clearRetainingCapacity();
+            self.rollbackRepl(typesStart, funcSymsStart, varSymsStart, constsStart);
+            self.buf.ops.items.len = opsStart;
+            self.buf.debugTable.items.len = debugStart;
+            self.buf.debugTempIndexTable.items.len = debugStart;
+            self.buf.debugMarkers.items.len = markersStart;
+            return self.handleCompileError(err, firstChunk);
         };
+        const mainChunk = self.chunks.items[firstChunk];
+        try self.replChunks.insert(self.alloc, 0, @ptrCast(mainChunk.sym));
         return CompileResult{
             .inner = res,
             .err = null,
         };
     }
 
+    /// Drops the types, func syms, var syms and consts added by a failed REPL input.
+    /// Types that codegen already registered with the VM are kept since their ids are
+    /// still referenced by the field and method tables.
+    fn rollbackRepl(self: *VMcompiler, typesStart: u32, funcSymsStart: usize, varSymsStart: usize, constsStart: usize) void {
+        if (self.preparedTypesEnd <= typesStart) {
+            self.sema.types.items.len = typesStart;
+        }
+        self.vm.funcSyms.len = funcSymsStart;
+        self.vm.funcSymDetails.len = funcSymsStart;
+        // Only host vars are retained before the input is evaluated.
+        for (self.vm.varSyms.items()[varSymsStart..]) |vsym| {
+            cy.arc.release(self.vm, vsym.value);
+        }
+        self.vm.varSyms.len = varSymsStart;
+        self.vm.varSymExtras.len = varSymsStart;
+        for (self.buf.consts.items[constsStart..]) |val| {
+            _ = self.buf.constMap.remove(val.val);
+        }
+        self.buf.consts.items.len = constsStart;
+    }
+
+    fn handleCompileError(self: *VMcompiler, err: anyerror, mainChunkId: cy.ChunkId) !CompileResult {
+        if (err == error.TokenError) {
+            return CompileResult{
+                .inner = undefined,
+                .err = .tokenize,
+            };
+        } else if (err == error.ParseError) {
+            return CompileResult{
+                .inner = undefined,
+                .err = .parse,
+            };
+        } else {
+            if (dumpCompileErrorStackTrace and !cy.silentError) {
+                std.debug.dumpStackTrace(@errorReturnTrace().?.*);
+            }
+            if (err != error.CompileError) {
+                if (self.chunks.items.len > mainChunkId) {
+                    // Report other errors using the main chunk.
+                    const chunk = self.chunks.items[mainChunkId];
+                    try chunk.setErrorFmtAt("Error: {}", &.{v(err)}, cy.NullId);
+                } else {
+                    return err;
+                }
+            }
+            return CompileResult{
+                .inner = undefined,
+                .err = .compile,
+            };
+        }
+    }
+
     /// Wrap compile so all errors can be handled in one place.
     fn compileInner(self: *VMcompiler, srcUri: []const u8, src: []const u8, config: CompileConfig) !CompileInnerResult {
         self.config = config;
@@ -247,28 +329,69 @@ pub const VMcompiler = struct {
             finalSrcUri = try self.alloc.dupe(u8, srcUri);
         }
 
+        const mainChunk = try self.addMainChunk(finalSrcUri, src);
+        return self.compileChunks(mainChunk, true);
+    }
+
+    fn compileReplInner(self: *VMcompiler, src: []const u8, config: CompileConfig) !CompileInnerResult {
+        self.config = config;
+        if (config.backend != .vm) {
+            return error.Unsupported;
+        }
+
+        // The uri is relative to the cwd so that relative imports resolve from there.
+        const name = try std.fmt.allocPrint(self.alloc, "<repl:{}>", .{self.replChunks.items.len});
+        defer self.alloc.free(name);
+        var srcUri: []const u8 = undefined;
+        if (!cy.isWasm and builtin.os.tag != .freestanding and config.enableFileModules) {
+            const cwd = try std.fs.cwd().realpathAlloc(self.alloc, ".");
+            defer self.alloc.free(cwd);
+            srcUri = try std.fs.path.join(self.alloc, &.{cwd, name});
+        } else {
+            srcUri = try self.alloc.dupe(u8, name);
+        }
+
+        const mainChunk = try self.addMainChunk(srcUri, src);
+        mainChunk.parser.staticRootVars = true;
+        for (self.replChunks.items) |sym| {
+            try sema.declareUsingModule(mainChunk, sym);
+        }
+        return self.compileChunks(mainChunk, false);
+    }
+
+    /// Takes ownership of `srcUri`.
+    fn addMainChunk(self: *VMcompiler, srcUri: []const u8, src: []const u8) !*cy.Chunk {
         const srcDup = try self.alloc.dupe(u8, src);
 
-        // Main chunk.
         const mainSym = try self.sema.createChunkSym();
         const nextId: u32 = @intCast(self.chunks.items.len);
         var mainChunk = try self.alloc.create(cy.Chunk);
-        mainChunk.* = try cy.Chunk.init(self, nextId, finalSrcUri, srcDup, mainSym);
+        mainChunk.* = try cy.Chunk.init(self, nextId, srcUri, srcDup, mainSym);
         mainSym.mod.chunk = mainChunk;
-        mainSym.head.namePtr = finalSrcUri.ptr;
-        mainSym.head.nameLen = @intCast(finalSrcUri.len);
+        mainSym.head.namePtr = srcUri.ptr;
+        mainSym.head.nameLen = @intCast(srcUri.len);
         try self.chunks.append(self.alloc, mainChunk);
-        try self.chunkMap.put(self.alloc, finalSrcUri, mainChunk);
+        try self.chunkMap.put(self.alloc, srcUri, mainChunk);
+        return mainChunk;
+    }
+
+    /// Compiles `mainChunk` and the chunks it imports. Chunks before `mainChunk` are already compiled.
+    /// When `mergeConsts` is false, consts are kept in their own buffer so more code can be appended later.
+    fn compileChunks(self: *VMcompiler, mainChunk: *cy.Chunk, mergeConsts: bool) !CompileInnerResult {
+        const config = self.config;
+        const firstType: u32 = @intCast(self.sema.types.items.len);
 
         // All modules and data types are loaded first.
         try declareImportsAndTypes(self, mainChunk);
 
+        const newChunks = self.chunks.items[mainChunk.id..];
+
         // Declare static vars and funcs after types have been resolved.
-        try declareSymbols(self);
+        try declareSymbols(self, newChunks);
 
         // Perform sema on static initializers.
         log.tracev("Perform init sema.", .{});
-        for (self.chunks.items) |chunk| {
+        for (newChunks) |chunk| {
             // First stmt is root at index 0.
             _ = try chunk.ir.pushEmptyStmt2(chunk.alloc, .root, chunk.parserAstRootId, false);
             try chunk.ir.pushStmtBlock(chunk.alloc);
@@ -282,8 +405,8 @@ pub const VMcompiler = struct {
 
         // Perform sema on all chunks.
         log.tracev("Perform sema.", .{});
-        for (self.chunks.items) |chunk| {
-            performChunkSema(self, chunk) catch |err| {
+        for (newChunks) |chunk| {
+            performChunkSema(self, chunk, chunk == mainChunk) catch |err| {
                 if (err == error.CompileError) {
                     return err;
                 } else {
@@ -317,7 +440,7 @@ pub const VMcompiler = struct {
                     return error.TODO;
                 },
                 .vm => {
-                    try genBytecode(self);
+                    try genBytecode(self, mainChunk.id, firstType, mergeConsts);
                     return .{
                         .vm = self.buf,
                     };
@@ -383,8 +506,8 @@ fn performChunkParse(self: *VMcompiler, chunk: *cy.Chunk) !void {
 
 /// Sema pass.
 /// Symbol resolving, type checking, and builds the model for codegen.
-fn performChunkSema(self: *VMcompiler, chunk: *cy.Chunk) !void {
-    if (chunk.id == 0) {
+fn performChunkSema(self: *VMcompiler, chunk: *cy.Chunk, isMain: bool) !void {
+    if (isMain) {
         _ = try sema.semaMainBlock(self, chunk);
     }
     // Top level declarations only.
@@ -424,7 +547,7 @@ fn performChunkInitSema(_: *VMcompiler, c: *cy.Chunk) !void {
         switch (sdecl.declT) {
             .variable => {
                 const node = c.nodes[sdecl.nodeId];
-                if (node.node_t == .staticDecl) {
+                if (node.node_t == .staticDecl and !node.head.staticDecl.replRoot) {
                     try sema.staticDecl(c, sdecl.data.sym, sdecl.nodeId);
                 }
             },
@@ -558,9 +681,8 @@ fn declareImportsAndTypes(self: *VMcompiler, mainChunk: *cy.Chunk) !void {
     log.tracev("Load imports and types.", .{});
 
     // Load core module first since the members are imported into each user module.
-    var builtinSym: *cy.sym.Chunk = undefined;
-    if (self.importBuiltins) {
-        builtinSym = try self.sema.createChunkSym();
+    if (self.importBuiltins and self.builtinSym == null) {
+        const builtinSym = try self.sema.createChunkSym();
         const importCore = ImportTask{
             .fromChunk = mainChunk,
             .nodeId = cy.NullId,
@@ -573,16 +695,17 @@ fn declareImportsAndTypes(self: *VMcompiler, mainChunk: *cy.Chunk) !void {
         };
         _ = self.importTasks.orderedRemove(0);
         try loadPredefinedTypes(self, @ptrCast(builtinSym));
+        self.builtinSym = builtinSym;
     }
 
-    var id: u32 = 0;
+    var id: u32 = mainChunk.id;
     while (true) {
         while (id < self.chunks.items.len) : (id += 1) {
             const chunk = self.chunks.items[id];
             log.tracev("chunk parse: {}", .{chunk.id});
             try performChunkParse(self, chunk);
 
-            if (self.importBuiltins) {
+            if (self.builtinSym) |builtinSym| {
                 // Import builtin module into local namespace.
                 try sema.declareUsingModule(chunk, @ptrCast(builtinSym));
             }
@@ -707,9 +830,9 @@ fn loadPredefinedTypes(self: *VMcompiler, parent: *cy.Sym) !void {
     // std.debug.assert(id == bt.Dynamic);
 }
 
-fn declareSymbols(self: *VMcompiler) !void {
+fn declareSymbols(self: *VMcompiler, chunks: []const *cy.Chunk) !void {
     log.tracev("Load module symbols.", .{});
-    for (self.chunks.items) |chunk| {
+    for (chunks) |chunk| {
         // Process static declarations.
         for (chunk.parser.staticDecls.items) |*decl| {
             log.tracev("Load {s}", .{@tagName(decl.declT)});
@@ -718,7 +841,7 @@ fn declareSymbols(self: *VMcompiler) !void {
                     const sym = try sema.declareVar(chunk, decl.nodeId);
                     decl.data = .{ .sym = sym };
                     const node = chunk.nodes[decl.nodeId];
-                    if (node.node_t == .staticDecl) {
+                    if (node.node_t == .staticDecl and !node.head.staticDecl.replRoot) {
                         chunk.hasStaticInit = true;
                     }
                 },
@@ -750,14 +873,18 @@ fn declareSymbols(self: *VMcompiler) !void {
     }
 }
 
-fn genBytecode(c: *VMcompiler) !void {
-    // Constants.
-    c.vm.emptyString = try c.buf.getOrPushStaticAstring("");
-    c.vm.emptyArray = try cy.heap.allocArray(c.vm, "");
-    try c.vm.staticObjects.append(c.alloc, c.vm.emptyArray.asHeapObject());
+/// Generates code for chunks starting at `firstChunk` and types starting at `firstType`.
+fn genBytecode(c: *VMcompiler, firstChunk: u32, firstType: u32, mergeConsts: bool) !void {
+    if (firstChunk == 0) {
+        // Constants.
+        c.vm.emptyString = try c.buf.getOrPushStaticAstring("");
+        c.vm.emptyArray = try cy.heap.allocArray(c.vm, "");
+        try c.vm.staticObjects.append(c.alloc, c.vm.emptyArray.asHeapObject());
+    }
 
     // Prepare types.
-    for (c.sema.types.items, 0..) |stype, typeId| {
+    c.preparedTypesEnd = @intCast(c.sema.types.items.len);
+    for (c.sema.types.items[firstType..], firstType..) |stype, typeId| {
         log.tracev("bc prepare type: {s}", .{stype.sym.name()});
         const sym = stype.sym;
 
@@ -781,8 +908,10 @@ fn genBytecode(c: *VMcompiler) !void {
         }
     }
 
+    const chunks = c.chunks.items[firstChunk..];
+
     // Prepare funcs.
-    for (c.chunks.items) |chunk| {
+    for (chunks) |chunk| {
         const mod = chunk.sym.getMod();
         for (mod.syms.items) |sym| {
             try prepareSym(c, sym);
@@ -802,15 +931,22 @@ fn genBytecode(c: *VMcompiler) !void {
         }
     }
 
-    // Bind the rest that aren't in sema.
-    try @call(.never_inline, bindings.bindCore, .{c.vm});
+    if (firstChunk == 0) {
+        // Bind the rest that aren't in sema.
+        try @call(.never_inline, bindings.bindCore, .{c.vm});
+    }
 
-    for (c.chunks.items) |chunk| {
+    for (chunks) |chunk| {
         log.tracev("Perform codegen for chunk{}: {s}", .{chunk.id, chunk.srcUri});
         try performChunkCodegen(c, chunk);
         log.tracev("Done. performChunkCodegen {s}", .{chunk.srcUri});
     }
 
+    if (!mergeConsts) {
+        c.buf.mconsts = c.buf.consts.items;
+        return;
+    }
+
     // Merge inst and const buffers.
     var reqLen = c.buf.ops.items.len + c.buf.consts.items.len * @sizeOf(cy.Value) + @alignOf(cy.Value) - 1;
     if (c.buf.ops.capacity < reqLen) {
@@ -225,6 +225,7 @@ if (!aot) {
     run.case("meta/metatype.cy");
 
     run.case("concurrency/fibers.cy");
+    run.case("concurrency/sched.cy");
 
     run.case("errors/error_values.cy");
     run.case("errors/throw.cy");
@@ -241,6 +242,7 @@ if (!aot) {
     run.case("builtins/array_slices.cy");
     run.case("builtins/bitwise_ops.cy");
     run.case("builtins/bools.cy");
+    run.case("builtins/buffer.cy");
     run.case("builtins/compare_eq.cy");
     run.case("builtins/compare_neq.cy");
     run.case("builtins/compare_numbers.cy");
@@ -552,6 +554,124 @@ test "Multiple evals with same VM." {
     });
 }
 
+test "REPL inputs." {
+    const run = VMrunner.create();
+    defer run.destroy();
+    const vm = run.vm;
+
+    // Declarations persist across inputs.
+    _ = try vm.evalRepl("var a = 10", .{});
+    _ = try vm.evalRepl(
+        \\func double(x):
+        \\    return x * 2
+    , .{});
+    var res = try vm.evalRepl("double(a)", .{});
+    try t.eq(res.asInteger(), 20);
+
+    // A failed input is rolled back.
+    const numTypes = vm.compiler.sema.types.items.len;
+    const numFuncSyms = vm.funcSyms.len;
+    const numVarSyms = vm.varSyms.len;
+    const numConsts = vm.compiler.buf.consts.items.len;
+    cy.silentError = true;
+    const failed = vm.evalRepl(
+        \\type Point:
+        \\    var x int
+        \\func point():
+        \\    return [Point x: 1]
+        \\var b = missing
+    , .{});
+    cy.silentError = false;
+    try t.expectError(failed, error.CompileError);
+    try t.eq(vm.compiler.sema.types.items.len, numTypes);
+    try t.eq(vm.funcSyms.len, numFuncSyms);
+    try t.eq(vm.varSyms.len, numVarSyms);
+    try t.eq(vm.compiler.buf.consts.items.len, numConsts);
+
+    // Its names can be declared again.
+    _ = try vm.evalRepl(
+        \\type Point:
+        \\    var x int
+        \\    var y int
+    , .{});
+    res = try vm.evalRepl(
+        \\var p = [Point x: 1, y: 2]
+        \\p.x + p.y + a
+    , .{});
+    try t.eq(res.asInteger(), 13);
+
+    // Root vars are initialized in statement order, so they can refer to the input's locals.
+    _ = try vm.evalRepl(
+        \\my l = [1, 2, 3]
+        \\var n = l.len()
+    , .{});
+    res = try vm.evalRepl("n", .{});
+    try t.eq(res.asInteger(), 3);
+
+    // A fiber suspended in a nested call resumes after the ops buffer has moved.
+    _ = try vm.evalRepl(
+        \\func inner():
+        \\    coyield
+        \\    return 2
+        \\func outer():
+        \\    var a = inner()
+        \\    return a + 1
+        \\var f = coinit(outer)
+        \\coresume f
+    , .{});
+    vm.compiler.buf.ops.shrinkAndFree(vm.alloc, vm.compiler.buf.ops.items.len);
+    res = try vm.evalRepl("coresume f", .{});
+    try t.eq(res.asInteger(), 3);
+}
+
+test "Fused map updates." {
+    const run = VMrunner.create();
+    defer run.destroy();
+
+    _ = try run.evalExt(.{},
+        \\import t 'test'
+        \\my m = [a: 1, b: 1.5]
+        \\my key = 'b'
+        \\m[key] -= 0.5
+        \\t.eq(m['b'], 1.0)
+        \\m = [:]
+        \\m[2] = 10
+        \\my i = 2
+        \\m[i] *= 3
+        \\t.eq(m[2], 30)
+    );
+    try t.eq(countFailableOps(run.vm, .mapUpdate), 2);
+
+    // A missing key without a default leaves the fused op for the unfused update, which panics on `none`.
+    const res = run.evalExt(.{ .silent = true },
+        \\my m = [a: 1]
+        \\my key = 'b'
+        \\m[key] += 1
+    );
+    try t.expectError(res, error.Panic);
+    try t.eq(countFailableOps(run.vm, .mapUpdate), 1);
+    const trace = run.getStackTrace();
+    try t.eq(trace.frames.len, 1);
+    try t.eq(trace.frames[0].line, 2);
+}
+
+/// Counts the insts of `code` that have a debug sym.
+fn countFailableOps(vm: *cy.VM, code: cy.OpCode) u32 {
+    const ops = vm.compiler.buf.ops.items;
+    var count: u32 = 0;
+    var prevPc: u32 = cy.NullId;
+    for (vm.compiler.buf.debugTable.items) |sym| {
+        if (sym.pc == prevPc) {
+            continue;
+        }
+        prevPc = sym.pc;
+        if (ops[sym.pc].opcode() == code) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
 test "Debug labels." {
     try eval(.{},
         \\var a = 1
@@ -635,6 +755,99 @@ test "Import http spec." {
     );
 }
 
+test "Pooled http client." {
+    if (cy.isWasm) {
+        return;
+    }
+
+    // Reuses a keep-alive connection per host:port.
+    var factory = http.MockHttpClientFactory{};
+    var pool = http.PooledHttpClient.init(t.alloc, factory.iface(), .{});
+    for (0..3) |_| {
+        const res = try pool.getOne("https://exists.com/a.cy");
+        defer t.alloc.free(res.body);
+        try t.eqStr(res.body, "Hello.");
+    }
+    try t.eq(factory.stats.numOpens, 1);
+    var res = try pool.getOne("https://exists.com:8080/a.cy");
+    t.alloc.free(res.body);
+    res = try pool.getOne("https://other.com/a.cy");
+    t.alloc.free(res.body);
+    try t.eq(factory.stats.numOpens, 3);
+    pool.deinit();
+    try t.eq(factory.stats.numCloses, 3);
+
+    // Idle connections are closed after the timeout.
+    factory = .{};
+    pool = http.PooledHttpClient.init(t.alloc, factory.iface(), .{ .idleTimeoutMs = 0 });
+    for (0..3) |_| {
+        res = try pool.getOne("https://exists.com/a.cy");
+        t.alloc.free(res.body);
+    }
+    try t.eq(factory.stats.numOpens, 3);
+    try t.eq(factory.stats.numCloses, 2);
+    pool.deinit();
+    try t.eq(factory.stats.numCloses, 3);
+
+    // Requests through the `HttpClient` interface return their connection in `deinitRequest`.
+    factory = .{};
+    pool = http.PooledHttpClient.init(t.alloc, factory.iface(), .{});
+    for (0..3) |_| {
+        res = try http.get(t.alloc, pool.iface(), "https://exists.com/a.cy");
+        t.alloc.free(res.body);
+    }
+    try t.eq(factory.stats.numOpens, 1);
+    try t.eq(factory.stats.numRequests, 3);
+    try t.eq(factory.stats.numInflight, 0);
+    pool.deinit();
+
+    // URL imports go through the pool when it backs the VM's client.
+    const run = VMrunner.create();
+    defer run.destroy();
+    factory = .{ .retBody = "var .foo = 123" };
+    pool = http.PooledHttpClient.init(t.alloc, factory.iface(), .{});
+    try run.resetEnv();
+    run.vm.httpClient = pool.iface();
+    _ = try run.evalExtNoReset(Config.initFileModules("./test/modules/import.cy"),
+        \\import a 'https://exists.com/a.cy'
+        \\import b 'https://exists.com/b.cy'
+        \\import t 'test'
+        \\t.eq(a.foo + b.foo, 246)
+    );
+    try t.eq(factory.stats.numOpens, 1);
+    try t.eq(factory.stats.numRequests, 2);
+    // Hand back the VM's own client since the VM deinits `httpClient`.
+    run.vm.httpClient = run.vm.httpPool.iface();
+    pool.deinit();
+
+    // Batched requests are bounded by the max connections per host and returned in order.
+    factory = .{ .latencyNs = 20 * std.time.ns_per_ms };
+    pool = http.PooledHttpClient.init(t.alloc, factory.iface(), .{ .maxPerHost = 4 });
+    defer pool.deinit();
+    const urls = [_][]const u8{
+        "https://exists.com/0", "https://exists.com/1", "https://exists.com/2", "https://exists.com/3",
+        "https://exists.com/4", "https://exists.com/5", "https://exists.com/6", "https://exists.com/7",
+        "http://exists.com/8",
+    };
+    const results = try pool.getMany(&urls);
+    defer {
+        for (results) |r| {
+            if (r == .ok) t.alloc.free(r.ok.body);
+        }
+        t.alloc.free(results);
+    }
+    try t.eq(results.len, urls.len);
+    for (results) |r| {
+        try t.eqStr(r.ok.body, "Hello.");
+        try t.eq(r.ok.status, .ok);
+    }
+    try t.eq(factory.stats.numRequests, 9);
+    // 4 for exists.com:443 and 1 for exists.com:80.
+    try t.eq(factory.stats.numOpens <= 5, true);
+    try t.eq(factory.stats.maxInflight <= 5, true);
+    try t.eq(factory.stats.maxInflight > 1, true);
+}
+
 test "os constants" {
     try eval(.{},
         \\import os
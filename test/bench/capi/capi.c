@@ -0,0 +1,65 @@
+#include <time.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "cyber.h"
+
+// Compares per-element and bulk transfer of a list between the host and the VM.
+// zig build lib -Doptimize=ReleaseFast
+// cc -O2 capi.c -I ../../../src/include ../../../zig-out/lib/libcyber.a -o capi
+
+#define N 1000000
+
+double now() {
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return (double)spec.tv_sec + (double)spec.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    CsVM* vm = csCreate();
+    double* src = malloc(sizeof(double) * N);
+    CsValue* vals = malloc(sizeof(CsValue) * N);
+    for (int i = 0; i < N; i += 1) {
+        src[i] = (double)i;
+    }
+
+    // Host to VM, per element.
+    double start = now();
+    CsValue list = csNewEmptyList(vm);
+    for (int i = 0; i < N; i += 1) {
+        csListAppend(vm, list, csFloat(src[i]));
+    }
+    printf("append per element: %f ms\n", (now() - start) * 1000);
+    csRelease(vm, list);
+
+    // Host to VM, bulk.
+    start = now();
+    list = csNewListFromF64s(vm, src, N);
+    printf("newListFromF64s: %f ms\n", (now() - start) * 1000);
+
+    // VM to host, per element.
+    start = now();
+    double sum = 0;
+    for (int i = 0; i < N; i += 1) {
+        CsValue val = csListGet(vm, list, i);
+        sum += csAsFloat(val);
+        csRelease(vm, val);
+    }
+    printf("get per element: %f ms, sum: %f\n", (now() - start) * 1000, sum);
+
+    // VM to host, bulk.
+    start = now();
+    sum = 0;
+    size_t n = csListGetRange(vm, list, 0, N, vals);
+    for (size_t i = 0; i < n; i += 1) {
+        sum += csAsFloat(vals[i]);
+    }
+    printf("getRange: %f ms, sum: %f\n", (now() - start) * 1000, sum);
+
+    csRelease(vm, list);
+    free(vals);
+    free(src);
+    csDestroy(vm);
+    return 0;
+}
@@ -9,4 +9,5 @@ test {
     t.refAllDecls(vm);
 
     _ = @import("behavior_test.zig");
+    _ = @import("../src/test_runner.zig");
 }
\ No newline at end of file
@@ -215,6 +215,31 @@ test "ARC for function return values." {
     }}.func);
 }
 
+test "ARC for closures." {
+    // Immutable captured var is copied into the closure without a box.
+    try eval(.{},
+        \\var a = [123]
+        \\var f = () => a[0]
+    , struct { fn func(run: *Runner, res: EvalResult) !void {
+        _ = try res;
+        var trace = run.getTrace();
+        try t.eq(trace.numRetains, 3);
+        try t.eq(trace.numReleases, 3);
+    }}.func);
+
+    // Reassigned captured var is lifted into a box.
+    try eval(.{},
+        \\var a = [123]
+        \\var f = () => a[0]
+        \\a = [234]
+    , struct { fn func(run: *Runner, res: EvalResult) !void {
+        _ = try res;
+        var trace = run.getTrace();
+        try t.eq(trace.numRetains, 5);
+        try t.eq(trace.numReleases, 5);
+    }}.func);
+}
+
 test "ARC on temp locals in expressions." {
     // Only the map literal is retained and released at the end of the arc expression.
     try evalPass(.{},